@@ -5,9 +5,6 @@
 #include <cmath>
 #include <fstream>
 #include <sstream>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 
 namespace aletheia {
 namespace {
@@ -71,6 +68,20 @@ double LexicalSimilarity(const std::string& left, const std::string& right) {
 }
 }  // namespace
 
+Eigen::VectorXd FallbackEmbedding(const std::string& word, int dims) {
+  Eigen::VectorXd vec(dims);
+  uint64_t hash = 1469598103934665603ULL;
+  for (char c : word) {
+    hash ^= static_cast<uint64_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  for (int i = 0; i < dims; ++i) {
+    double value = static_cast<double>((hash >> (i * 3)) & 0xFFFF);
+    vec[i] = std::sin(value * 0.001 + static_cast<double>(i));
+  }
+  return vec;
+}
+
 bool EmbeddingStore::LoadWord2VecBinary(
     const std::string& path,
     const std::unordered_set<std::string>& needed) {
@@ -195,10 +206,8 @@ void SimilarityEngine::BuildMatrix(
   constexpr double kCosineEps = 1e-12;
   const int n = static_cast<int>(embeddings.size());
   similarity_.resize(n, n);
-#ifdef _OPENMP
-#pragma omp parallel for schedule(static)
-#endif
-  for (int i = 0; i < n; ++i) {
+  auto fill_row = [&](size_t row) {
+    const int i = static_cast<int>(row);
     const double norm_i = embeddings[i].norm();
     for (int j = 0; j < n; ++j) {
       const double norm_j = embeddings[j].norm();
@@ -214,7 +223,8 @@ void SimilarityEngine::BuildMatrix(
       cosine = std::max(-1.0, std::min(1.0, cosine));
       similarity_(i, j) = 0.5 * (cosine + 1.0);
     }
-  }
+  };
+  ThreadPool::Instance().ParallelFor(0, static_cast<size_t>(n), 8, fill_row);
 }
 
 void SimilarityEngine::BuildMatrixHybrid(
@@ -229,10 +239,8 @@ void SimilarityEngine::BuildMatrixHybrid(
   double weight = std::max(0.0, std::min(1.0, lexical_weight));
   const int n = static_cast<int>(embeddings.size());
   similarity_.resize(n, n);
-#ifdef _OPENMP
-#pragma omp parallel for schedule(static)
-#endif
-  for (int i = 0; i < n; ++i) {
+  auto fill_row = [&](size_t row) {
+    const int i = static_cast<int>(row);
     const double norm_i = embeddings[i].norm();
     for (int j = 0; j < n; ++j) {
       const double norm_j = embeddings[j].norm();
@@ -249,7 +257,8 @@ void SimilarityEngine::BuildMatrixHybrid(
       double lexical = LexicalSimilarity(words[i], words[j]);
       similarity_(i, j) = (1.0 - weight) * semantic + weight * lexical;
     }
-  }
+  };
+  ThreadPool::Instance().ParallelFor(0, static_cast<size_t>(n), 8, fill_row);
 }
 
 ConnectionsSolver::ConnectionsSolver(const Eigen::MatrixXd& similarity)
@@ -257,13 +266,16 @@ ConnectionsSolver::ConnectionsSolver(const Eigen::MatrixXd& similarity)
   BuildGroups();
 }
 
-std::vector<uint16_t> ConnectionsSolver::SolveBestPartition() {
+std::vector<uint16_t> ConnectionsSolver::SolveBestPartition(
+    const CancelToken* cancel) {
   best_score_ = -std::numeric_limits<double>::infinity();
   best_groups_.clear();
+  cancel_ = cancel;
   std::vector<int> current;
   current.reserve(4);
   uint16_t all = static_cast<uint16_t>((1U << kNodeCount) - 1);
   Search(all, 0.0, current);
+  cancel_ = nullptr;
 
   std::vector<uint16_t> masks;
   for (int idx : best_groups_) {
@@ -325,6 +337,10 @@ void ConnectionsSolver::Search(uint16_t remaining,
   if (pivot < 0) {
     return;
   }
+  // Each subtree with two or more groups left is one chunk of work.
+  if (cancel_ && std::popcount(remaining) >= 8 && cancel_->cancelled()) {
+    return;
+  }
 
   for (int group_index : groups_by_node_[pivot]) {
     const Group& group = groups_[group_index];
@@ -0,0 +1,799 @@
+#include "Solver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define ALETHEIA_HAS_UNIX_SOCKETS 1
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace aletheia {
+namespace {
+constexpr size_t kDefaultTopGuesses = 5;
+constexpr size_t kMaxTopGuesses = 100;
+constexpr size_t kConnectionsWords = 16;
+constexpr int kFallbackDims = 64;
+
+// One value of a flat request object. Requests are objects of strings,
+// numbers, booleans and arrays of strings; nothing nests deeper.
+struct JsonValue {
+  enum class Kind { kNull, kString, kNumber, kBool, kStrings };
+  Kind kind = Kind::kNull;
+  std::string text;
+  double number = 0.0;
+  bool boolean = false;
+  std::vector<std::string> items;
+};
+
+using JsonObject = std::unordered_map<std::string, JsonValue>;
+
+class JsonReader {
+ public:
+  explicit JsonReader(std::string_view text) : text_(text) {}
+
+  bool ReadObject(JsonObject* out) {
+    SkipSpace();
+    if (!Consume('{')) {
+      return false;
+    }
+    SkipSpace();
+    if (Consume('}')) {
+      return AtEnd();
+    }
+    while (true) {
+      std::string key;
+      JsonValue value;
+      SkipSpace();
+      if (!ReadString(&key)) {
+        return false;
+      }
+      SkipSpace();
+      if (!Consume(':') || !ReadValue(&value)) {
+        return false;
+      }
+      (*out)[std::move(key)] = std::move(value);
+      SkipSpace();
+      if (Consume('}')) {
+        return AtEnd();
+      }
+      if (!Consume(',')) {
+        return false;
+      }
+    }
+  }
+
+ private:
+  bool ReadValue(JsonValue* out) {
+    SkipSpace();
+    if (pos_ >= text_.size()) {
+      return false;
+    }
+    const char c = text_[pos_];
+    if (c == '"') {
+      out->kind = JsonValue::Kind::kString;
+      return ReadString(&out->text);
+    }
+    if (c == '[') {
+      ++pos_;
+      out->kind = JsonValue::Kind::kStrings;
+      SkipSpace();
+      if (Consume(']')) {
+        return true;
+      }
+      while (true) {
+        std::string item;
+        SkipSpace();
+        if (!ReadString(&item)) {
+          return false;
+        }
+        out->items.push_back(std::move(item));
+        SkipSpace();
+        if (Consume(']')) {
+          return true;
+        }
+        if (!Consume(',')) {
+          return false;
+        }
+      }
+    }
+    if (ReadLiteral("true")) {
+      out->kind = JsonValue::Kind::kBool;
+      out->boolean = true;
+      return true;
+    }
+    if (ReadLiteral("false")) {
+      out->kind = JsonValue::Kind::kBool;
+      return true;
+    }
+    if (ReadLiteral("null")) {
+      return true;
+    }
+    const std::string rest(text_.substr(pos_, 32));
+    char* end = nullptr;
+    out->number = std::strtod(rest.c_str(), &end);
+    if (end == rest.c_str() || !std::isfinite(out->number)) {
+      return false;
+    }
+    out->kind = JsonValue::Kind::kNumber;
+    pos_ += static_cast<size_t>(end - rest.c_str());
+    return true;
+  }
+
+  bool ReadString(std::string* out) {
+    if (!Consume('"')) {
+      return false;
+    }
+    while (pos_ < text_.size()) {
+      char c = text_[pos_++];
+      if (c == '"') {
+        return true;
+      }
+      if (c != '\\') {
+        out->push_back(c);
+        continue;
+      }
+      if (pos_ >= text_.size()) {
+        return false;
+      }
+      c = text_[pos_++];
+      switch (c) {
+        case 'n':
+          out->push_back('\n');
+          break;
+        case 't':
+          out->push_back('\t');
+          break;
+        case 'r':
+          out->push_back('\r');
+          break;
+        case 'b':
+          out->push_back('\b');
+          break;
+        case 'f':
+          out->push_back('\f');
+          break;
+        case 'u': {
+          // Words are ASCII; anything wider cannot name one.
+          if (pos_ + 4 > text_.size()) {
+            return false;
+          }
+          const std::string hex(text_.substr(pos_, 4));
+          char* end = nullptr;
+          const long code = std::strtol(hex.c_str(), &end, 16);
+          if (end != hex.c_str() + 4) {
+            return false;
+          }
+          out->push_back(code < 0x80 ? static_cast<char>(code) : '?');
+          pos_ += 4;
+          break;
+        }
+        default:
+          out->push_back(c);
+          break;
+      }
+    }
+    return false;
+  }
+
+  bool ReadLiteral(std::string_view literal) {
+    if (text_.substr(pos_, literal.size()) != literal) {
+      return false;
+    }
+    pos_ += literal.size();
+    return true;
+  }
+
+  void SkipSpace() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' ||
+            text_[pos_] == '\r' || text_[pos_] == '\n')) {
+      ++pos_;
+    }
+  }
+
+  bool Consume(char c) {
+    if (pos_ < text_.size() && text_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  bool AtEnd() {
+    SkipSpace();
+    return pos_ == text_.size();
+  }
+
+  std::string_view text_;
+  size_t pos_ = 0;
+};
+
+const JsonValue* Field(const JsonObject& object,
+                       const char* key,
+                       JsonValue::Kind kind) {
+  auto it = object.find(key);
+  return it != object.end() && it->second.kind == kind ? &it->second
+                                                       : nullptr;
+}
+
+std::string StringField(const JsonObject& object, const char* key) {
+  const JsonValue* value = Field(object, key, JsonValue::Kind::kString);
+  return value ? value->text : std::string();
+}
+
+// Starts a response, echoing the request id so pipelined clients can match
+// answers that arrive out of order.
+void BeginResponse(const JsonObject& request, std::ostringstream* out) {
+  *out << "{";
+  auto it = request.find("id");
+  if (it != request.end()) {
+    if (it->second.kind == JsonValue::Kind::kString) {
+      *out << "\"id\":\"" << JsonEscape(it->second.text) << "\",";
+    } else if (it->second.kind == JsonValue::Kind::kNumber) {
+      const double id = it->second.number;
+      *out << "\"id\":";
+      if (id == std::floor(id) && std::fabs(id) < 9e15) {
+        *out << static_cast<long long>(id);
+      } else {
+        *out << id;
+      }
+      *out << ",";
+    }
+  }
+}
+
+std::string ErrorResponse(const JsonObject& request, std::string_view error) {
+  std::ostringstream out;
+  BeginResponse(request, &out);
+  out << "\"ok\":false,\"error\":\"" << JsonEscape(error) << "\"}";
+  return out.str();
+}
+
+std::string SuggestResponse(const JsonObject& request,
+                            const std::string& guess,
+                            double entropy,
+                            size_t remaining) {
+  std::ostringstream out;
+  BeginResponse(request, &out);
+  out << "\"ok\":true,\"guess\":\"" << guess << "\",\"entropy\":" << entropy
+      << ",\"remaining\":" << remaining << "}";
+  return out.str();
+}
+}  // namespace
+
+std::string JsonEscape(std::string_view text) {
+  std::string out;
+  out.reserve(text.size());
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out.push_back(' ');
+    } else {
+      out.push_back(c);
+    }
+  }
+  return out;
+}
+
+struct SolverServer::Session {
+  Session(const WordleSolver& solver, bool hard_mode)
+      : game(solver, hard_mode) {}
+  GameSession game;
+};
+
+// One connection's output. Responses from different workers are written
+// whole under the mutex; `pending` counts requests not yet answered so the
+// reader can wait for them before closing.
+struct SolverServer::Stream {
+  std::function<void(const std::string&)> write;
+  std::mutex mutex;
+  std::condition_variable idle;
+  size_t pending = 0;
+};
+
+struct SolverServer::Request {
+  std::string line;
+  Stream* stream = nullptr;
+};
+
+struct SolverServer::Shard {
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+  std::deque<Request> queue;
+  bool stop = false;
+};
+
+SolverServer::SolverServer(const WordleSolver& wordle, Options options)
+    : wordle_(wordle), options_(options) {
+  if (options_.workers == 0) {
+    options_.workers = ThreadPool::Instance().threads();
+  }
+  options_.queue_depth = std::max<size_t>(1, options_.queue_depth);
+  shards_.reserve(options_.workers);
+  for (size_t i = 0; i < options_.workers; ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+  workers_.reserve(options_.workers);
+  for (size_t i = 0; i < options_.workers; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(shards_[i].get()); });
+  }
+}
+
+SolverServer::~SolverServer() {
+  for (auto& shard : shards_) {
+    {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->stop = true;
+    }
+    shard->not_empty.notify_all();
+  }
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+size_t SolverServer::sessions() const {
+  std::lock_guard<std::mutex> lock(sessions_mutex_);
+  return sessions_.size();
+}
+
+std::string SolverServer::Handle(std::string_view request) {
+  JsonObject object;
+  JsonReader reader(request);
+  if (!reader.ReadObject(&object)) {
+    return ErrorResponse(object, "malformed request");
+  }
+  const std::string op = StringField(object, "op");
+  std::string name = StringField(object, "session");
+  std::ostringstream out;
+  BeginResponse(object, &out);
+
+  if (op == "new") {
+    const JsonValue* hard = Field(object, "hard", JsonValue::Kind::kBool);
+    {
+      std::lock_guard<std::mutex> lock(sessions_mutex_);
+      if (sessions_.size() >= options_.max_sessions) {
+        return ErrorResponse(object, "too many sessions");
+      }
+      if (name.empty()) {
+        name = "s";
+        name += std::to_string(next_session_++);
+      }
+      if (sessions_.count(name) > 0) {
+        return ErrorResponse(object, "session exists");
+      }
+      sessions_.emplace(name, std::make_unique<Session>(
+                                  wordle_, hard != nullptr && hard->boolean));
+    }
+    out << "\"ok\":true,\"session\":\"" << JsonEscape(name)
+        << "\",\"remaining\":" << wordle_.words().size() << "}";
+    return out.str();
+  }
+
+  if (op == "stats") {
+    out << "\"ok\":true,\"sessions\":" << sessions()
+        << ",\"words\":" << wordle_.words().size()
+        << ",\"workers\":" << options_.workers << "}";
+    return out.str();
+  }
+
+  if (op == "connections") {
+    const JsonValue* words = Field(object, "words", JsonValue::Kind::kStrings);
+    if (!words || words->items.size() != kConnectionsWords) {
+      return ErrorResponse(object, "connections expects 16 words");
+    }
+    const EmbeddingStore* store = options_.embeddings;
+    const int dims = store && store->dimension() > 0 ? store->dimension()
+                                                     : kFallbackDims;
+    std::vector<std::string> lowered;
+    std::vector<Eigen::VectorXd> vectors;
+    for (const std::string& item : words->items) {
+      std::string word = item;
+      std::transform(word.begin(), word.end(), word.begin(), [](char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+      });
+      Eigen::VectorXd vec;
+      if (store && store->GetVector(word, &vec)) {
+        vectors.push_back(std::move(vec));
+      } else if (options_.allow_fallback) {
+        vectors.push_back(FallbackEmbedding(word, dims));
+      } else {
+        return ErrorResponse(object, "missing embedding for " + word);
+      }
+      lowered.push_back(std::move(word));
+    }
+    SimilarityEngine similarity;
+    if (options_.lexical_weight > 0.0) {
+      similarity.BuildMatrixHybrid(vectors, lowered, options_.lexical_weight);
+    } else {
+      similarity.BuildMatrix(vectors);
+    }
+    ConnectionsSolver solver(similarity.matrix());
+    const std::vector<uint16_t> groups = solver.SolveBestPartition();
+    out << "\"ok\":true,\"score\":" << solver.BestScore() << ",\"groups\":[";
+    for (size_t g = 0; g < groups.size(); ++g) {
+      out << (g > 0 ? "," : "") << "[";
+      bool first = true;
+      for (size_t i = 0; i < lowered.size(); ++i) {
+        if (groups[g] & (1U << i)) {
+          out << (first ? "" : ",") << "\"" << JsonEscape(lowered[i]) << "\"";
+          first = false;
+        }
+      }
+      out << "]";
+    }
+    out << "]}";
+    return out.str();
+  }
+
+  if (op != "feedback" && op != "suggest" && op != "top" && op != "reset" &&
+      op != "end") {
+    return ErrorResponse(object, op.empty() ? "missing op" : "unknown op");
+  }
+  Session* session = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    auto it = sessions_.find(name);
+    if (it == sessions_.end()) {
+      return ErrorResponse(object, "unknown session");
+    }
+    if (op == "end") {
+      sessions_.erase(it);
+      out << "\"ok\":true}";
+      return out.str();
+    }
+    session = it->second.get();
+  }
+  GameSession& game = session->game;
+
+  if (op == "feedback") {
+    const std::string guess = StringField(object, "guess");
+    const std::string pattern = StringField(object, "pattern");
+    if (!game.AllowsGuess(guess)) {
+      return ErrorResponse(object, WordleSolver::IsValidWord(
+                                       WordleSolver::NormalizeWord(guess))
+                                       ? "guess must reuse revealed hints"
+                                       : "invalid guess");
+    }
+    if (!game.ApplyFeedback(guess, pattern)) {
+      return ErrorResponse(object, "invalid or inconsistent feedback");
+    }
+    out << "\"ok\":true,\"remaining\":" << game.remaining().size()
+        << ",\"solved\":" << (pattern == "22222" ? "true" : "false") << "}";
+  } else if (op == "suggest") {
+    const JsonValue* deadline =
+        Field(object, "deadline_ms", JsonValue::Kind::kNumber);
+    double entropy = 0.0;
+    if (!deadline || deadline->number <= 0.0) {
+      const std::string guess = game.Suggest(&entropy);
+      return SuggestResponse(object, guess, entropy, game.remaining().size());
+    }
+    bool exact = true;
+    const std::string guess = game.SuggestWithin(
+        std::chrono::microseconds(
+            static_cast<int64_t>(std::min(deadline->number, 3.6e6) * 1000.0)),
+        &entropy, &exact);
+    out << "\"ok\":true,\"guess\":\"" << guess << "\",\"entropy\":" << entropy
+        << ",\"exact\":" << (exact ? "true" : "false")
+        << ",\"remaining\":" << game.remaining().size() << "}";
+  } else if (op == "top") {
+    const JsonValue* k = Field(object, "k", JsonValue::Kind::kNumber);
+    size_t limit = kDefaultTopGuesses;
+    if (k && k->number >= 1.0) {
+      limit = std::min(kMaxTopGuesses, static_cast<size_t>(k->number));
+    }
+    const auto scored = game.TopGuesses(limit);
+    out << "\"ok\":true,\"items\":[";
+    for (size_t i = 0; i < scored.size(); ++i) {
+      out << (i > 0 ? "," : "") << "{\"word\":\""
+          << wordle_.words().text(scored[i].index)
+          << "\",\"entropy\":" << scored[i].entropy << "}";
+    }
+    out << "]}";
+  } else {
+    game.Reset();
+    out << "\"ok\":true,\"remaining\":" << game.remaining().size() << "}";
+  }
+  return out.str();
+}
+
+std::vector<std::string> SolverServer::HandleBatch(
+    const std::vector<std::string>& requests) {
+  std::vector<std::string> responses(requests.size());
+  // The pending run of suggest requests: parsed request, response slot and
+  // session, with no session twice.
+  std::vector<JsonObject> run_requests;
+  std::vector<size_t> run_slots;
+  std::vector<const GameSession*> run_games;
+  auto flush = [&] {
+    if (run_games.empty()) {
+      return;
+    }
+    std::vector<double> entropies;
+    const std::vector<std::string> guesses =
+        GameSession::SuggestBatch(run_games, &entropies);
+    for (size_t r = 0; r < run_games.size(); ++r) {
+      responses[run_slots[r]] =
+          SuggestResponse(run_requests[r], guesses[r], entropies[r],
+                          run_games[r]->remaining().size());
+    }
+    run_requests.clear();
+    run_slots.clear();
+    run_games.clear();
+  };
+  for (size_t i = 0; i < requests.size(); ++i) {
+    JsonObject object;
+    JsonReader reader(requests[i]);
+    const GameSession* game = nullptr;
+    // Suggests under a deadline keep their own budget.
+    if (reader.ReadObject(&object) && StringField(object, "op") == "suggest" &&
+        !Field(object, "deadline_ms", JsonValue::Kind::kNumber)) {
+      std::lock_guard<std::mutex> lock(sessions_mutex_);
+      auto it = sessions_.find(StringField(object, "session"));
+      if (it != sessions_.end()) {
+        game = &it->second->game;
+      }
+    }
+    if (!game) {
+      flush();
+      responses[i] = Handle(requests[i]);
+      continue;
+    }
+    if (std::find(run_games.begin(), run_games.end(), game) !=
+        run_games.end()) {
+      flush();
+    }
+    run_requests.push_back(std::move(object));
+    run_slots.push_back(i);
+    run_games.push_back(game);
+  }
+  flush();
+  return responses;
+}
+
+void SolverServer::Submit(std::string line, Stream* stream) {
+  // Requests of one session always land on the same shard and so are
+  // answered in order; session-less requests are spread round-robin.
+  JsonObject object;
+  JsonReader reader(line);
+  std::string name;
+  if (reader.ReadObject(&object)) {
+    name = StringField(object, "session");
+  }
+  const size_t index =
+      name.empty()
+          ? next_shard_.fetch_add(1, std::memory_order_relaxed) % shards_.size()
+          : std::hash<std::string>()(name) % shards_.size();
+  Shard& shard = *shards_[index];
+  {
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    ++stream->pending;
+  }
+  std::unique_lock<std::mutex> lock(shard.mutex);
+  shard.not_full.wait(
+      lock, [&] { return shard.queue.size() < options_.queue_depth; });
+  shard.queue.push_back({std::move(line), stream});
+  lock.unlock();
+  shard.not_empty.notify_one();
+}
+
+void SolverServer::WorkerLoop(Shard* shard) {
+  const size_t limit = std::max<size_t>(1, options_.batch_limit);
+  std::vector<Request> batch;
+  std::vector<std::string> lines;
+  while (true) {
+    batch.clear();
+    lines.clear();
+    {
+      // Whatever queued up while the last batch ran is answered together.
+      std::unique_lock<std::mutex> lock(shard->mutex);
+      shard->not_empty.wait(
+          lock, [&] { return shard->stop || !shard->queue.empty(); });
+      if (shard->queue.empty()) {
+        return;
+      }
+      while (!shard->queue.empty() && batch.size() < limit) {
+        batch.push_back(std::move(shard->queue.front()));
+        shard->queue.pop_front();
+      }
+    }
+    shard->not_full.notify_all();
+    for (Request& request : batch) {
+      lines.push_back(std::move(request.line));
+    }
+    const std::vector<std::string> responses = HandleBatch(lines);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      Stream* stream = batch[i].stream;
+      std::lock_guard<std::mutex> lock(stream->mutex);
+      stream->write(responses[i]);
+      if (--stream->pending == 0) {
+        stream->idle.notify_all();
+      }
+    }
+  }
+}
+
+void SolverServer::Serve(std::istream& in, std::ostream& out) {
+  Stream stream;
+  stream.write = [&out](const std::string& response) {
+    out << response << '\n';
+    out.flush();
+  };
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+    Submit(std::move(line), &stream);
+  }
+  std::unique_lock<std::mutex> lock(stream.mutex);
+  stream.idle.wait(lock, [&] { return stream.pending == 0; });
+}
+
+#if defined(ALETHEIA_HAS_UNIX_SOCKETS)
+namespace {
+// Clears a socket left at `path` by an earlier run. Anything else there is
+// left alone and reported as false, so a mistyped path never deletes a file.
+bool RemoveStaleSocket(const std::string& path) {
+  struct stat info;
+  if (::lstat(path.c_str(), &info) != 0) {
+    return errno == ENOENT;
+  }
+  return S_ISSOCK(info.st_mode) && ::unlink(path.c_str()) == 0;
+}
+}  // namespace
+
+void SolverServer::ServeFd(int fd) {
+  Stream stream;
+  stream.write = [fd](const std::string& response) {
+    std::string data = response;
+    data.push_back('\n');
+    size_t sent = 0;
+    while (sent < data.size()) {
+#if defined(MSG_NOSIGNAL)
+      const ssize_t n =
+          ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+#else
+      const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+#endif
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        // The client went away; its remaining answers are dropped.
+        return;
+      }
+      sent += static_cast<size_t>(n);
+    }
+  };
+  std::string buffer;
+  char chunk[4096];
+  while (true) {
+    const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    buffer.append(chunk, static_cast<size_t>(n));
+    size_t start = 0;
+    size_t newline;
+    while ((newline = buffer.find('\n', start)) != std::string::npos) {
+      std::string line = buffer.substr(start, newline - start);
+      start = newline + 1;
+      if (line.find_first_not_of(" \t\r") != std::string::npos) {
+        Submit(std::move(line), &stream);
+      }
+    }
+    buffer.erase(0, start);
+  }
+  std::unique_lock<std::mutex> lock(stream.mutex);
+  stream.idle.wait(lock, [&] { return stream.pending == 0; });
+}
+
+bool SolverServer::ServeUnixSocket(const std::string& path) {
+  sockaddr_un address{};
+  if (path.empty() || path.size() >= sizeof(address.sun_path) ||
+      !RemoveStaleSocket(path)) {
+    return false;
+  }
+  const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    return false;
+  }
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  if (::bind(listener, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(listener, SOMAXCONN) != 0) {
+    ::close(listener);
+    return false;
+  }
+  bool serving = false;
+  {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    serving = !stopping_;
+    if (serving) {
+      listener_ = listener;
+    }
+  }
+  while (serving) {
+    const int fd = ::accept(listener, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      break;
+    }
+    {
+      std::lock_guard<std::mutex> lock(connections_mutex_);
+      if (stopping_) {
+        ::close(fd);
+        break;
+      }
+      connections_.push_back(fd);
+    }
+    // Each connection leaves the list before its fd is closed, so Stop
+    // never shuts down a number the kernel has already handed out again.
+    std::thread([this, fd] {
+      ServeFd(fd);
+      {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_.erase(
+            std::find(connections_.begin(), connections_.end(), fd));
+        connections_idle_.notify_all();
+      }
+      ::close(fd);
+    }).detach();
+  }
+  {
+    std::unique_lock<std::mutex> lock(connections_mutex_);
+    listener_ = -1;
+    connections_idle_.wait(lock, [&] { return connections_.empty(); });
+    stopping_ = false;
+  }
+  ::close(listener);
+  RemoveStaleSocket(path);
+  return true;
+}
+
+void SolverServer::Stop() {
+  std::lock_guard<std::mutex> lock(connections_mutex_);
+  stopping_ = true;
+  // Shutting a socket down wakes a thread blocked on it, where closing it
+  // would not.
+  if (listener_ >= 0) {
+    ::shutdown(listener_, SHUT_RDWR);
+  }
+  for (int fd : connections_) {
+    ::shutdown(fd, SHUT_RD);
+  }
+}
+#else
+void SolverServer::ServeFd(int fd) { (void)fd; }
+
+bool SolverServer::ServeUnixSocket(const std::string& path) {
+  (void)path;
+  return false;
+}
+
+void SolverServer::Stop() {}
+#endif
+
+}  // namespace aletheia
@@ -3,31 +3,488 @@
 #include <Eigen/Dense>
 
 #include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
+#include <functional>
+#include <iosfwd>
 #include <limits>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 namespace aletheia {
 
-struct PackedWord {
-  uint32_t letters = 0;
-  uint32_t mask = 0;
+// Word geometry shared by every solver: kLength letters drawn from an
+// alphabet of kAlphabetSize, packed kLetterBits apart in `letters`, plus one
+// `mask` bit per letter present. The letter width, pattern code type and
+// histogram size all follow from the template arguments, so each shape runs
+// fully unrolled kernels. Lengths 4-8 over 26 letters are instantiated in
+// Wordle.cpp.
+template <int kLength, int kAlphabetSize = 26>
+struct WordShape {
+  static_assert(kLength >= 1 && kLength <= 10,
+                "patterns must fit 16-bit codes");
+  static_assert(kAlphabetSize >= 2 && kAlphabetSize <= 64,
+                "letter sets must fit a 64-bit mask");
+
+  static constexpr int kWordLen = kLength;
+  static constexpr int kAlphabet = kAlphabetSize;
+  static constexpr int kLetterBits =
+      std::bit_width(static_cast<unsigned>(kAlphabetSize - 1));
+  static constexpr int kPatternCount = [] {
+    int count = 1;
+    for (int i = 0; i < kLength; ++i) {
+      count *= 3;
+    }
+    return count;
+  }();
+  static constexpr int kSolvedPattern = kPatternCount - 1;
+
+  using Letters = std::conditional_t<kLength * kLetterBits <= 32,
+                                     uint32_t,
+                                     uint64_t>;
+  using LetterMask =
+      std::conditional_t<kAlphabetSize <= 32, uint32_t, uint64_t>;
+  using PatternCode =
+      std::conditional_t<kPatternCount <= 256, uint8_t, uint16_t>;
+
+  struct Packed {
+    Letters letters = 0;
+    LetterMask mask = 0;
+  };
+
+  static uint32_t LetterAt(Letters letters, int index) {
+    return static_cast<uint32_t>((letters >> (index * kLetterBits)) &
+                                 ((Letters{1} << kLetterBits) - 1));
+  }
+  static int Pattern(const Packed& guess, const Packed& target);
+  // Scores one guess against `count` targets given as packed letters and
+  // writes one pattern code per target. Uses Highway lanes when available.
+  static void PatternBatch(const Packed& guess,
+                           const Letters* target_letters,
+                           size_t count,
+                           PatternCode* out);
+  static std::string PatternString(int pattern);
+  static int ParsePattern(std::string_view pattern);
 };
 
-struct WordEntry {
-  PackedWord packed;
-  std::string_view text;
+extern template struct WordShape<4>;
+extern template struct WordShape<5>;
+extern template struct WordShape<6>;
+extern template struct WordShape<7>;
+extern template struct WordShape<8>;
+
+using PackedWord = WordShape<5>::Packed;
+
+// Dictionary stored as structure-of-arrays: packed letters and letter masks
+// live in separate 64-byte aligned arrays (8 bytes per 5-letter word), so
+// kernels that only read letters stream 4 bytes per word. Text is kept in a
+// cold side array and only touched when a caller asks for it. operator[]
+// assembles an Entry by value for code that wants both.
+template <typename Shape>
+class BasicWordTable {
+ public:
+  static constexpr size_t kAlignment = 64;
+
+  using Letters = typename Shape::Letters;
+  using LetterMask = typename Shape::LetterMask;
+  using Packed = typename Shape::Packed;
+
+  struct Entry {
+    Packed packed;
+    std::string_view text;
+  };
+
+  class const_iterator {
+   public:
+    const_iterator(const BasicWordTable* table, size_t index)
+        : table_(table), index_(index) {}
+    Entry operator*() const { return (*table_)[index_]; }
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return index_ != other.index_;
+    }
+
+   private:
+    const BasicWordTable* table_;
+    size_t index_;
+  };
+
+  BasicWordTable() = default;
+
+  BasicWordTable(const BasicWordTable&) = delete;
+  BasicWordTable& operator=(const BasicWordTable&) = delete;
+
+  void Clear();
+  void Reserve(size_t capacity);
+  void PushBack(const Packed& packed, std::string_view text);
+  // Replaces the contents with source's words at `indices`, in order. Used
+  // to compact a remaining target set so histogram passes stream it.
+  void Assign(const BasicWordTable& source,
+              const std::vector<size_t>& indices);
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const Letters* letters() const { return letters_; }
+  const LetterMask* masks() const { return masks_; }
+  Packed packed(size_t index) const {
+    return {letters_[index], masks_[index]};
+  }
+  std::string_view text(size_t index) const { return text_[index]; }
+  Entry operator[](size_t index) const {
+    return {packed(index), text_[index]};
+  }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+ private:
+  struct AlignedDeleter {
+    void operator()(unsigned char* ptr) const noexcept {
+      if (ptr) {
+        ::operator delete(ptr, std::align_val_t(kAlignment));
+      }
+    }
+  };
+
+  // letters_ and masks_ both point into storage_; masks_ starts on the next
+  // aligned boundary after capacity_ letters.
+  std::unique_ptr<unsigned char, AlignedDeleter> storage_;
+  Letters* letters_ = nullptr;
+  LetterMask* masks_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+  std::vector<std::string_view> text_;
+};
+
+extern template class BasicWordTable<WordShape<4>>;
+extern template class BasicWordTable<WordShape<5>>;
+extern template class BasicWordTable<WordShape<6>>;
+extern template class BasicWordTable<WordShape<7>>;
+extern template class BasicWordTable<WordShape<8>>;
+
+using WordTable = BasicWordTable<WordShape<5>>;
+using WordEntry = WordTable::Entry;
+
+// Dense guess x target table of pattern codes, one byte per pair. The table
+// either owns its storage or views a read-only mapping of a cache file.
+class PatternMatrix {
+ public:
+  static constexpr uint32_t kFormatVersion = 1;
+
+  PatternMatrix() = default;
+  ~PatternMatrix() { Clear(); }
+
+  PatternMatrix(const PatternMatrix&) = delete;
+  PatternMatrix& operator=(const PatternMatrix&) = delete;
+
+  void Build(const WordTable& words);
+  bool Save(const std::string& path, uint64_t fingerprint) const;
+  bool Load(const std::string& path, size_t size, uint64_t fingerprint);
+  void Clear();
+
+  bool empty() const { return data_ == nullptr; }
+  size_t size() const { return size_; }
+  bool mapped() const { return mapping_ != nullptr; }
+  const uint8_t* Row(size_t guess_index) const {
+    return data_ + guess_index * size_;
+  }
+  uint8_t At(size_t guess_index, size_t target_index) const {
+    return data_[guess_index * size_ + target_index];
+  }
+
+ private:
+  std::vector<uint8_t> storage_;
+  void* mapping_ = nullptr;
+  size_t mapping_bytes_ = 0;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Bitset over dictionary indices. Filtering and bucket sizing reduce to
+// word-wide AND and popcount over 64 candidates at a time.
+class CandidateSet {
+ public:
+  CandidateSet() = default;
+  explicit CandidateSet(size_t universe) { Reset(universe); }
+
+  static CandidateSet All(size_t universe);
+  static CandidateSet FromIndices(size_t universe,
+                                  const std::vector<size_t>& indices);
+
+  void Reset(size_t universe);
+  void Fill();
+  void Clear();
+
+  void Insert(size_t index) {
+    blocks_[index >> 6] |= uint64_t{1} << (index & 63);
+  }
+  void Erase(size_t index) {
+    blocks_[index >> 6] &= ~(uint64_t{1} << (index & 63));
+  }
+  bool Contains(size_t index) const {
+    return index < universe_ &&
+           ((blocks_[index >> 6] >> (index & 63)) & 1U) != 0;
+  }
+
+  size_t Count() const;
+  bool Empty() const;
+  size_t universe() const { return universe_; }
+  const std::vector<uint64_t>& blocks() const { return blocks_; }
+
+  void IntersectWith(const CandidateSet& other);
+  size_t IntersectCount(const CandidateSet& other) const;
+  void ToIndices(std::vector<size_t>* out) const;
+
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (size_t block = 0; block < blocks_.size(); ++block) {
+      uint64_t bits = blocks_[block];
+      while (bits != 0) {
+        fn(block * 64 + static_cast<size_t>(std::countr_zero(bits)));
+        bits &= bits - 1;
+      }
+    }
+  }
+
+ private:
+  size_t universe_ = 0;
+  std::vector<uint64_t> blocks_;
+};
+
+// Every (guess, pattern) hint of a game compiled into one state: a fixed
+// letter per green position, banned letters per position and a min/max
+// count per letter. A word is checked against the whole history with a few
+// mask tests, so a session can be rebuilt from its hints in one pass over
+// the dictionary instead of replaying the filters turn by turn.
+class HintConstraints {
+ public:
+  using Shape = WordShape<5>;
+  using Letters = Shape::Letters;
+  using LetterMask = Shape::LetterMask;
+
+  HintConstraints() { Reset(); }
+
+  void Reset();
+  // Folds one hint in. Returns false, leaving the state unchanged, when the
+  // guess is not a five-letter lowercase word or the pattern is malformed.
+  // Feedback no answer could produce, such as a yellow after a grey copy of
+  // the same letter, is accepted but makes the state contradictory.
+  bool Add(std::string_view guess, std::string_view pattern);
+  bool Matches(const PackedWord& word) const;
+  // Hard-mode legality as NYT enforces it: greens stay in place and every
+  // revealed letter is reused at least as often as it was revealed. Grey
+  // letters and yellow positions do not restrict guesses, so legal guesses
+  // include words that can no longer be the answer.
+  bool AllowsGuess(const PackedWord& word) const;
+
+  // True when the hints contradict each other; nothing matches.
+  bool contradictory() const { return contradictory_; }
+  bool empty() const { return hints_ == 0; }
+  size_t hints() const { return hints_; }
+  // Letters every match contains, and letters no match contains, as
+  // PackedWord::mask bits. These give a first-level reject on the mask.
+  LetterMask required() const { return required_; }
+  LetterMask excluded() const { return excluded_; }
+  // Packed letters at the green positions, and the bits selecting them.
+  Letters fixed_letters() const { return fixed_letters_; }
+  Letters fixed_mask() const { return fixed_mask_; }
+
+ private:
+  static constexpr int kWordLen = Shape::kWordLen;
+  static constexpr int kAlphabet = Shape::kAlphabet;
+  static constexpr int kLetterBits = Shape::kLetterBits;
+  static constexpr Letters kLetterMask = (Letters{1} << kLetterBits) - 1;
+  static constexpr uint8_t kUnbounded = kWordLen;
+
+  void Recompile();
+
+  Letters fixed_letters_ = 0;
+  Letters fixed_mask_ = 0;
+  std::array<LetterMask, kWordLen> banned_{};
+  std::array<uint8_t, kAlphabet> min_count_{};
+  std::array<uint8_t, kAlphabet> max_count_{};
+  LetterMask required_ = 0;
+  LetterMask excluded_ = 0;
+  // Letters whose count bounds go beyond present/absent and need counting.
+  LetterMask counted_ = 0;
+  size_t hints_ = 0;
+  bool contradictory_ = false;
+};
+
+// Flattened decision tree for a deterministic guessing policy. Each node
+// holds the guess for one remaining set; internal nodes own a dense block of
+// child slots indexed by pattern so that following the tree is O(1).
+class DecisionTree {
+ public:
+  static constexpr uint32_t kFormatVersion = 1;
+  static constexpr uint32_t kNoNode = 0xFFFFFFFFu;
+  static constexpr int kPatternSlots = 243;
+
+  // How the guesses were chosen. Greedy trees replay the live entropy
+  // search; the optimal policies are complete strategies of their own.
+  enum class Policy : uint8_t {
+    kGreedy = 0,
+    kMinExpected = 1,
+    kMinWorstCase = 2,
+  };
+
+  void Reset(uint64_t fingerprint,
+             size_t word_count,
+             bool hard_mode,
+             Policy policy = Policy::kGreedy);
+  void Clear();
+
+  uint32_t AddNode(size_t guess_index, double entropy);
+  void SetChild(uint32_t node, int pattern, uint32_t child);
+
+  bool empty() const { return guesses_.empty(); }
+  size_t node_count() const { return guesses_.size(); }
+  bool hard_mode() const { return hard_mode_; }
+  Policy policy() const { return policy_; }
+  uint64_t fingerprint() const { return fingerprint_; }
+  size_t word_count() const { return word_count_; }
+  uint32_t root() const { return empty() ? kNoNode : 0; }
+
+  size_t Guess(uint32_t node) const { return guesses_[node]; }
+  double Entropy(uint32_t node) const { return entropies_[node]; }
+  uint32_t Child(uint32_t node, int pattern) const {
+    if (node == kNoNode || child_base_[node] == kNoNode) {
+      return kNoNode;
+    }
+    return children_[child_base_[node] + static_cast<uint32_t>(pattern)];
+  }
+
+  bool Write(std::ostream& out) const;
+  bool Read(std::istream& in);
+  bool Save(const std::string& path) const;
+  bool Load(const std::string& path);
+
+ private:
+  uint64_t fingerprint_ = 0;
+  uint64_t word_count_ = 0;
+  bool hard_mode_ = false;
+  Policy policy_ = Policy::kGreedy;
+  std::vector<uint32_t> guesses_;
+  std::vector<double> entropies_;
+  std::vector<uint32_t> child_base_;
+  std::vector<uint32_t> children_;
+};
+
+// Cooperative cancellation shared by a request and the work running it.
+// Copies share one flag; long searches poll it between chunks and return
+// what they have once it is set.
+class CancelToken {
+ public:
+  CancelToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+  void Cancel() const { flag_->store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return flag_->load(std::memory_order_relaxed); }
+
+ private:
+  std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+class GuessFuture;
+
+// Bounded, thread-safe map from a search state to the guess chosen there.
+// Keys are 128-bit fingerprints of the candidate pool and remaining set, so
+// games that reach the same state share one search. Entries are split over
+// independently locked shards, each evicting its least recently used entry.
+class GuessCache {
+ public:
+  static constexpr uint32_t kFormatVersion = 1;
+  static constexpr size_t kShardCount = 16;
+
+  struct Key {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+    bool operator==(const Key& other) const {
+      return hi == other.hi && lo == other.lo;
+    }
+  };
+
+  struct Entry {
+    uint32_t guess = 0;
+    double entropy = 0.0;
+  };
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+  };
+
+  // `salt` separates states searched under different policies.
+  static Key MakeKey(const std::vector<size_t>& candidates,
+                     const std::vector<size_t>& targets,
+                     uint64_t salt);
+
+  // A capacity of 0 disables the cache. Changing the capacity drops all
+  // entries and must not race with lookups.
+  void SetCapacity(size_t capacity);
+  size_t capacity() const { return capacity_; }
+  bool enabled() const { return capacity_ > 0; }
+
+  bool Find(const Key& key, Entry* out);
+  void Store(const Key& key, const Entry& entry);
+  void Clear();
+  Stats stats() const;
+
+  // Entries are tied to the dictionary they index into. Load keeps the
+  // current entries when the file is missing or was saved for another one.
+  bool Save(const std::string& path,
+            uint64_t fingerprint,
+            size_t word_count) const;
+  bool Load(const std::string& path, uint64_t fingerprint, size_t word_count);
+
+ private:
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      return static_cast<size_t>(key.lo ^ (key.hi >> 17));
+    }
+  };
+  using LruList = std::list<std::pair<Key, Entry>>;
+  struct Shard {
+    mutable std::mutex mutex;
+    LruList lru;  // Most recently used first.
+    std::unordered_map<Key, LruList::iterator, KeyHash> index;
+  };
+
+  Shard& ShardFor(const Key& key) { return shards_[key.hi % kShardCount]; }
+
+  size_t capacity_ = 0;
+  size_t shard_capacity_ = 0;
+  std::array<Shard, kShardCount> shards_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> evictions_{0};
 };
 
 class WordleSolver {
  public:
+  using Shape = WordShape<5>;
+  static constexpr int kPatternCount = Shape::kPatternCount;
+  static constexpr size_t kNoIndex = static_cast<size_t>(-1);
+
   struct Step {
     std::string guess;
     std::string pattern;
@@ -37,30 +494,347 @@ class WordleSolver {
     size_t remaining_after = 0;
   };
 
+  // Work done by one best-guess search. Pruned candidates were rejected by
+  // an entropy bound before their histogram was complete.
+  struct SearchStats {
+    size_t candidates = 0;
+    size_t evaluated = 0;
+    size_t pruned = 0;
+    // Of the pruned, guesses that split the targets like an earlier one.
+    size_t merged = 0;
+  };
+
+  // Bounds on one best-guess search, shared by every word shape.
+  struct SearchLimits {
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max();
+    // Rank the loosest-bound guesses on a sample of the targets and score
+    // the leaders in full before the exhaustive pass (BestGuessWithin).
+    bool warm_up = false;
+    // Checked alongside the deadline; cancelling also ends the search.
+    const CancelToken* cancel = nullptr;
+  };
+
+  // Exact policy search. Targets are the whole dictionary; hard mode draws
+  // guesses from the remaining set. guess_limit > 0 keeps only that many of
+  // the highest-entropy guesses per node, which is faster but no longer
+  // provably optimal.
+  struct OptimalOptions {
+    DecisionTree::Policy objective = DecisionTree::Policy::kMinExpected;
+    bool hard_mode = false;
+    size_t max_guesses = 6;
+    size_t guess_limit = 0;
+  };
+
+  struct OptimalStats {
+    bool feasible = false;
+    double expected_guesses = 0.0;
+    size_t worst_case = 0;
+    size_t states = 0;
+    size_t memo_hits = 0;
+  };
+
+  // Absurdle: the adversary answers each guess with any pattern that keeps
+  // a word consistent. guess_limit > 0 searches only the highest-entropy
+  // guesses, which still proves a forced win but not that it is minimal.
+  struct AdversarialOptions {
+    bool hard_mode = false;
+    size_t max_guesses = 8;
+    size_t guess_limit = 0;
+  };
+
+  struct AdversarialResult {
+    size_t guess = kNoIndex;
+    // Guesses, this one included, that force a win; 0 if none fits.
+    size_t guesses = 0;
+    bool proven_optimal = false;
+    size_t states = 0;
+    size_t memo_hits = 0;
+  };
+
+  struct ScoredGuess {
+    size_t index = 0;
+    double entropy = 0.0;
+  };
+
+  // Two-ply ranking of one position. score is the first guess's entropy
+  // plus the expected entropy of the best second guess in its bucket.
+  struct LookaheadResult {
+    size_t guess = kNoIndex;
+    double entropy = 0.0;
+    double score = 0.0;
+    size_t beam = 0;
+    size_t second_ply_searches = 0;
+    // False when the search limits cut the ranking short; the guess is then
+    // the greedy leader of what was scored.
+    bool exact = true;
+  };
+
+  struct GameResult {
+    std::string target;
+    std::vector<Step> steps;
+    // Wall time of the search behind each step. Steps shared with other
+    // games report the one computation they share.
+    std::vector<double> step_ms;
+    bool solved = false;
+  };
+
+  struct SolveAllResult {
+    std::vector<GameResult> games;
+    size_t decisions = 0;
+  };
+
+  // Dordle/Quordle/Octordle: every guess is played on all unsolved boards.
+  static constexpr size_t kMaxBoards = 64;
+
+  struct MultiGameResult {
+    std::vector<std::string> targets;
+    std::vector<std::string> guesses;
+    // patterns[turn][board]; solved boards report an empty pattern.
+    std::vector<std::vector<std::string>> patterns;
+    std::vector<double> entropies;
+    std::vector<double> step_ms;
+    // Turn (1-based) on which each board was solved, 0 if it never was.
+    std::vector<size_t> solved_turn;
+    bool solved = false;
+  };
+
   bool LoadDictionary(const std::string& path);
   void SetWordList(const std::vector<std::string>& words);
 
-  const std::vector<WordEntry>& words() const;
+  const WordTable& words() const;
+  // Every dictionary index in order: the easy-mode guess pool and the
+  // opening target set, shared by all sessions.
+  const std::vector<size_t>& all_indices() const { return all_indices_; }
+  size_t IndexOf(std::string_view word) const;
+
+  // Builds the guess x target pattern matrix on every SetWordList. With a
+  // non-empty cache_path the matrix is mapped from that file when it matches
+  // the dictionary, and rebuilt and written back otherwise.
+  void EnablePatternMatrix(const std::string& cache_path);
+  bool HasPatternMatrix() const { return !pattern_matrix_.empty(); }
+  const PatternMatrix& pattern_matrix() const { return pattern_matrix_; }
+  uint64_t DictionaryFingerprint() const;
+
+  int PatternAt(size_t guess_index, size_t target_index) const;
+  // Stops between chunks of targets once `cancel` is set, leaving the
+  // counts partial.
+  std::array<int, kPatternCount> PatternCounts(
+      size_t guess_index,
+      const std::vector<size_t>& targets,
+      const CancelToken* cancel = nullptr) const;
+  std::array<int, kPatternCount> PatternCounts(
+      size_t guess_index,
+      const CandidateSet& targets) const;
+  // Targets already compacted with WordTable::Assign; scores straight from
+  // the dense letters array with no per-target gather.
+  std::array<int, kPatternCount> PatternCounts(
+      size_t guess_index,
+      const WordTable& targets) const;
+  // Entropy in bits of a pattern histogram over `total` targets, computed
+  // exactly as every search scores guesses.
+  static double EntropyOf(const std::array<int, kPatternCount>& counts,
+                          size_t total);
+
+  // Stores, for each listed guess, the set of dictionary words producing
+  // each pattern so that filtering on that guess becomes a single AND.
+  void PrecomputePatternBitmaps(const std::vector<size_t>& guesses);
+  bool HasPatternBitmaps(size_t guess_index) const;
+  void ClearPatternBitmaps() { pattern_bitmaps_.clear(); }
 
+  // `hard_mode` only matters under lookahead: it says `candidates` is a
+  // hard-mode pool, which each later guess narrows further.
   std::string BestGuess(const std::vector<size_t>& candidates,
                         const std::vector<size_t>& targets,
-                        double* entropy_out) const;
+                        double* entropy_out,
+                        SearchStats* stats = nullptr,
+                        bool hard_mode = false) const;
+  // Anytime BestGuess for a latency ceiling. Every guess is first scored on
+  // an evenly spaced sample of the targets, the leaders are rescored on all
+  // of them, and the exact search then starts from the best of those until
+  // `budget` is spent. *exact_out is true when that search finished, and
+  // the answer is then BestGuess's; otherwise it is the best guess scored
+  // on the full targets so far. Under lookahead the budget covers both
+  // plies, and one that ends first leaves the best first-ply guess.
+  std::string BestGuessWithin(const std::vector<size_t>& candidates,
+                              const std::vector<size_t>& targets,
+                              std::chrono::microseconds budget,
+                              double* entropy_out,
+                              bool* exact_out,
+                              SearchStats* stats = nullptr,
+                              bool hard_mode = false) const;
+  // The same search on the calling thread under explicit `limits`, for
+  // callers that already own a thread and a token; *exact_out is false if
+  // the deadline or the token cut it short.
+  std::string BestGuessWithin(const std::vector<size_t>& candidates,
+                              const std::vector<size_t>& targets,
+                              const SearchLimits& limits,
+                              double* entropy_out,
+                              bool* exact_out,
+                              SearchStats* stats = nullptr,
+                              bool hard_mode = false) const;
+  // BestGuess on its own thread, over copies of the lists, so the caller
+  // may move on (the solver must outlive the handle). Cancelling the handle
+  // stops the search at its next chunk and returns its pool threads. A
+  // finite budget bounds it as BestGuessWithin does; without one the
+  // answer is BestGuess's, and a lookahead search checks the token in each
+  // of its first- and second-ply searches.
+  GuessFuture BestGuessAsync(
+      std::vector<size_t> candidates,
+      std::vector<size_t> targets,
+      std::chrono::microseconds budget = std::chrono::microseconds::max(),
+      bool hard_mode = false) const;
+  // The k highest-entropy candidates, best first. Ties keep candidate order.
+  // Once `limits` run out the remaining guesses are skipped, and the list
+  // holds the best of those scored (at least one unless cancelled).
+  std::vector<ScoredGuess> TopGuesses(const std::vector<size_t>& candidates,
+                                      const std::vector<size_t>& targets,
+                                      size_t k) const {
+    return TopGuesses(candidates, targets, k, SearchLimits{});
+  }
+  std::vector<ScoredGuess> TopGuesses(const std::vector<size_t>& candidates,
+                                      const std::vector<size_t>& targets,
+                                      size_t k,
+                                      const SearchLimits& limits) const;
+  // Re-ranks the top `beam` entropy guesses by two-ply score. Second guesses
+  // come from the same candidates, or in hard mode from those the first
+  // guess's feedback for that bucket still allows (HintConstraints). Every
+  // search, including the per-bucket ones, stops at `limits`.
+  LookaheadResult BestGuessLookahead(const std::vector<size_t>& candidates,
+                                     const std::vector<size_t>& targets,
+                                     size_t beam,
+                                     bool hard_mode) const {
+    return BestGuessLookahead(candidates, targets, beam, hard_mode,
+                              SearchLimits{});
+  }
+  LookaheadResult BestGuessLookahead(const std::vector<size_t>& candidates,
+                                     const std::vector<size_t>& targets,
+                                     size_t beam,
+                                     bool hard_mode,
+                                     const SearchLimits& limits) const;
+  // With a beam above 1, BestGuess, SolveToTarget, SolveAll and
+  // BuildDecisionTree choose guesses by two-ply lookahead.
+  void SetLookahead(size_t beam) { lookahead_beam_ = beam; }
+  size_t lookahead() const { return lookahead_beam_; }
   std::vector<Step> SolveToTarget(const std::string& target,
                                   size_t max_steps) const;
+  // Plays SolveToTarget for every target in one pass. Games that reach the
+  // same remaining set share a single search, and the subtrees under the
+  // opening guess are solved in parallel.
+  SolveAllResult SolveAll(const std::vector<std::string>& targets,
+                          size_t max_steps) const;
+
+  // BestGuess over one guess list for many target sets at once, e.g. every
+  // player asking for a suggestion together. Each guess's pattern row is
+  // computed once over the union of the sets and split into per-set
+  // histograms, with each set keeping its own entropy bound for pruning.
+  // Returns one guess index per set (kNoIndex without candidates); each is
+  // the one BestGuess would pick for that set alone.
+  std::vector<size_t> BestGuessBatch(
+      const std::vector<size_t>& candidates,
+      const std::vector<const std::vector<size_t>*>& target_sets,
+      std::vector<double>* entropies,
+      bool hard_mode = false) const;
+
+  // Guess maximizing the summed entropy over independent boards, each
+  // given by its remaining set. Every guess scores the union of targets
+  // once and splits that pattern row into per-board histograms. Boards
+  // with fewer than two words add nothing; at most kMaxBoards are allowed.
+  std::string BestMultiGuess(const std::vector<size_t>& candidates,
+                             const std::vector<std::vector<size_t>>& boards,
+                             double* entropy_out) const;
+  // Plays one multi-board game, guessing from the whole dictionary. A board
+  // down to one word is guessed outright.
+  MultiGameResult SolveMultiToTargets(const std::vector<std::string>& targets,
+                                      size_t max_steps) const;
 
   static bool IsValidWord(std::string_view word);
   static std::string NormalizeWord(std::string_view word);
   static PackedWord EncodeWord(std::string_view word);
-  static int Pattern(const PackedWord& guess, const PackedWord& target);
-  static std::string PatternString(int pattern);
+  static int Pattern(const PackedWord& guess, const PackedWord& target) {
+    return Shape::Pattern(guess, target);
+  }
+  static void PatternBatch(const PackedWord& guess,
+                           const uint32_t* target_letters,
+                           size_t count,
+                           uint8_t* out) {
+    Shape::PatternBatch(guess, target_letters, count, out);
+  }
+  static std::string PatternString(int pattern) {
+    return Shape::PatternString(pattern);
+  }
   static bool IsConsistent(std::string_view candidate,
                            std::string_view guess,
                            std::string_view pattern);
-  static void FilterCandidates(const std::vector<WordEntry>& words,
+  static void FilterCandidates(const WordTable& words,
                                const std::vector<size_t>& remaining,
                                std::string_view guess,
                                std::string_view pattern,
                                std::vector<size_t>* out);
+  void FilterCandidates(const std::vector<size_t>& remaining,
+                        std::string_view guess,
+                        std::string_view pattern,
+                        std::vector<size_t>* out) const;
+  void FilterCandidates(const CandidateSet& remaining,
+                        size_t guess_index,
+                        int pattern,
+                        CandidateSet* out) const;
+  void FilterCandidates(const CandidateSet& remaining,
+                        std::string_view guess,
+                        std::string_view pattern,
+                        CandidateSet* out) const;
+  // Every dictionary word consistent with the compiled hints, in index
+  // order. One pass over the packed letter and mask arrays.
+  void FilterCandidates(const HintConstraints& hints,
+                        std::vector<size_t>* out) const;
+  // Narrows `pool` to the legal hard-mode guesses under `hints`. Hints only
+  // accumulate, so passing last turn's pool rechecks just its members; a
+  // pool over a different universe restarts from the whole dictionary.
+  void RestrictHardModePool(const HintConstraints& hints,
+                            CandidateSet* pool) const;
+  static int ParsePattern(std::string_view pattern) {
+    return Shape::ParsePattern(pattern);
+  }
+
+  // Expands the greedy policy into a decision tree of at most max_depth
+  // guesses. Hard mode draws guesses from the remaining set (the policy
+  // SolveToTarget plays); easy mode draws from the whole dictionary.
+  DecisionTree BuildDecisionTree(bool hard_mode, size_t max_depth) const;
+  // Searches for the policy minimizing expected (or worst-case) guesses
+  // within options.max_guesses. The tree is empty if no policy fits.
+  DecisionTree BuildOptimalTree(const OptimalOptions& options,
+                                OptimalStats* stats = nullptr) const;
+  // Minimax search for the guess forcing a win fastest against any
+  // adversary from `remaining`: iterative deepening over forced-win depth,
+  // a transposition table of proven states, and a parallel root.
+  AdversarialResult SolveAdversarial(const std::vector<size_t>& remaining,
+                                     const AdversarialOptions& options) const;
+  // The adversary's reply: the bucket needing the most further guesses,
+  // then the largest, then the lowest pattern.
+  int AdversarialPattern(size_t guess_index,
+                         const std::vector<size_t>& remaining,
+                         const AdversarialOptions& options) const;
+  bool LoadDecisionTree(const std::string& path);
+  bool SetDecisionTree(DecisionTree tree);
+
+  // Remembers up to `capacity` chosen guesses by state (0 disables). The
+  // cache is emptied whenever the dictionary changes.
+  void EnableGuessCache(size_t capacity) { guess_cache_.SetCapacity(capacity); }
+  GuessCache::Stats GuessCacheStats() const { return guess_cache_.stats(); }
+  bool SaveGuessCache(const std::string& path) const;
+  bool LoadGuessCache(const std::string& path);
+  const DecisionTree& decision_tree() const { return decision_tree_; }
+  // A greedy tree is used only in the mode it replays. An optimal tree is
+  // a full strategy: a hard-mode one is also valid in easy play.
+  bool HasDecisionTree(bool hard_mode) const {
+    if (decision_tree_.empty()) {
+      return false;
+    }
+    if (decision_tree_.policy() == DecisionTree::Policy::kGreedy) {
+      return decision_tree_.hard_mode() == hard_mode;
+    }
+    return decision_tree_.hard_mode() || !hard_mode;
+  }
 
  private:
   struct WordPool {
@@ -126,29 +900,473 @@ class WordleSolver {
     size_t offset_ = 0;
   };
 
-  static constexpr int kWordLen = 5;
-  static constexpr int kAlphabet = 26;
-  static constexpr int kLetterBits = 5;
-  static constexpr uint32_t kLetterMask = 0x1F;
-  static constexpr int kPatternCount = 243;
+  static constexpr int kWordLen = Shape::kWordLen;
+  static constexpr int kAlphabet = Shape::kAlphabet;
 
-  std::vector<WordEntry> words_;
+  WordTable words_;
   WordPool word_pool_;
   std::vector<std::string> word_storage_;
+  std::vector<size_t> all_indices_;
+  std::unordered_map<uint32_t, size_t> index_by_letters_;
+  bool use_pattern_matrix_ = false;
+  std::string pattern_cache_path_;
+  PatternMatrix pattern_matrix_;
+
+  struct GuessBitmaps {
+    std::array<int16_t, kPatternCount> slot{};
+    std::vector<CandidateSet> sets;
+  };
+  std::unordered_map<size_t, GuessBitmaps> pattern_bitmaps_;
+  DecisionTree decision_tree_;
+  size_t lookahead_beam_ = 0;
+  mutable GuessCache guess_cache_;
 
+  void RebuildPatternMatrix();
+  void SolveAllNode(const std::vector<size_t>& remaining,
+                    const std::vector<size_t>& games,
+                    const std::vector<PackedWord>& targets,
+                    size_t depth,
+                    size_t max_steps,
+                    uint32_t book_node,
+                    SolveAllResult* result) const;
+  struct OptimalContext;
+  struct OptimalChoice {
+    size_t guess = 0;
+    int64_t lower = 0;
+    double entropy = 0.0;
+  };
+  std::vector<OptimalChoice> RankOptimalGuesses(
+      const OptimalContext& context,
+      const std::vector<size_t>& remaining,
+      size_t guesses_left) const;
+  size_t OptimalExpectedRoot(OptimalContext* context,
+                             size_t max_guesses) const;
+  size_t OptimalWorstCaseRoot(OptimalContext* context,
+                              const std::vector<size_t>& root,
+                              size_t max_guesses) const;
+  bool OptimalFeasible(OptimalContext* context,
+                       const std::vector<size_t>& remaining,
+                       size_t guesses_left) const;
+  bool OptimalGuessFeasible(OptimalContext* context,
+                            const std::vector<size_t>& remaining,
+                            size_t guesses_left,
+                            size_t guess_index) const;
+  int64_t OptimalCost(OptimalContext* context,
+                      const std::vector<size_t>& remaining,
+                      size_t guesses_left,
+                      int64_t bound) const;
+  int64_t OptimalGuessCost(OptimalContext* context,
+                           const std::vector<size_t>& remaining,
+                           size_t guesses_left,
+                           size_t guess_index,
+                           int64_t bound) const;
+  uint32_t OptimalTreeNode(OptimalContext* context,
+                           const std::vector<size_t>& remaining,
+                           size_t guesses_left,
+                           DecisionTree* tree) const;
+  // First decision-tree node SolveToTarget and SolveAll follow, if any.
+  uint32_t PolicyRoot() const;
+  uint32_t BuildTreeNode(const std::vector<size_t>& remaining,
+                         const std::vector<size_t>& all_indices,
+                         bool hard_mode,
+                         size_t depth,
+                         size_t max_depth,
+                         DecisionTree* tree) const;
+
+  // Greedy or lookahead choice, per SetLookahead, through the guess cache.
+  size_t ChooseGuessIndex(const std::vector<size_t>& candidates,
+                          const std::vector<size_t>& targets,
+                          bool hard_mode,
+                          double* entropy_out,
+                          SearchStats* stats = nullptr) const;
+  // ChooseGuessIndex under `limits`. Returns false, caching nothing, if the
+  // deadline or the token cut the search short.
+  bool ChooseGuessIndex(const std::vector<size_t>& candidates,
+                        const std::vector<size_t>& targets,
+                        bool hard_mode,
+                        const SearchLimits& limits,
+                        size_t* guess_out,
+                        double* entropy_out,
+                        SearchStats* stats) const;
   size_t BestGuessIndex(const std::vector<size_t>& candidates,
                         const std::vector<size_t>& targets,
-                        double* entropy_out) const;
+                        double* entropy_out,
+                        SearchStats* stats = nullptr) const;
+  // BestGuessIndex under `limits`. Returns false if the deadline or the
+  // token cut the search short; the guess is then the best scored so far.
+  bool BoundedGuessIndex(const std::vector<size_t>& candidates,
+                         const std::vector<size_t>& targets,
+                         const SearchLimits& limits,
+                         size_t* guess_out,
+                         double* entropy_out,
+                         SearchStats* stats) const;
+  size_t MultiGuessIndex(const std::vector<size_t>& candidates,
+                         const std::vector<std::vector<size_t>>& boards,
+                         double* entropy_out) const;
+  // One sweep of BestGuessBatch over at most kMaxBoards distinct sets.
+  void BatchSweep(const std::vector<size_t>& candidates,
+                  const std::vector<const std::vector<size_t>*>& sets,
+                  std::vector<size_t>* guesses,
+                  std::vector<double>* entropies) const;
   double EntropyForGuess(size_t guess_index,
                          const std::vector<size_t>& targets) const;
+};
+
+// Handle to a suggestion computed on a thread of its own. Cancel(), or
+// dropping or reassigning the handle, sets its token; the search then
+// stops within one chunk and the result is the best guess scored so far.
+// Builds without threads compute the result when it is launched.
+class GuessFuture {
+ public:
+  struct Result {
+    std::string guess;
+    double entropy = 0.0;
+    // False when a budget or cancellation cut the search short.
+    bool exact = true;
+    bool cancelled = false;
+    WordleSolver::SearchStats stats;
+  };
+
+  GuessFuture() = default;
+  // A moved-from handle keeps a token of its own, so cancelling it never
+  // reaches the search that moved away.
+  GuessFuture(GuessFuture&& other) noexcept;
+  GuessFuture& operator=(GuessFuture&& other) noexcept;
+  ~GuessFuture();
+
+  bool valid() const { return state_ != nullptr; }
+  bool ready() const;
+  // Waits up to `timeout`; true once the result is ready.
+  bool WaitFor(std::chrono::microseconds timeout) const;
+  // Waits for the result. Requires valid().
+  const Result& Get();
+  void Cancel() const { token_.Cancel(); }
+  const CancelToken& token() const { return token_; }
+
+  // Runs `work` on a new thread with this handle's token.
+  static GuessFuture Launch(std::function<Result(const CancelToken&)> work);
+  static GuessFuture FromResult(Result result);
+
+ private:
+  struct State;
+
+  void Release();
+
+  std::shared_ptr<State> state_;
+  CancelToken token_;
+  std::thread thread_;
+};
+
+// One player's game over a shared solver: the feedback history, the
+// remaining set, the hard-mode guess pool and filter scratch. The solver's
+// dictionary, pattern matrix and decision tree are only read, so any number
+// of sessions can run on different threads against one solver as long as
+// it is not reconfigured meanwhile. A fresh session holds two bitsets; the
+// index lists start out as views of the solver's all_indices().
+class GameSession {
+ public:
+  explicit GameSession(const WordleSolver& solver, bool hard_mode = false);
+
+  // Back to the opening position, keeping the solver and mode.
+  void Reset();
+  // Switching mode rebuilds the hard-mode pool from the hints so far.
+  void SetHardMode(bool hard_mode);
+  // Folds in one turn. Returns false, leaving the session unchanged, when
+  // the guess or pattern is malformed or no remaining word fits it.
+  // Hard-mode legality is the caller's check (AllowsGuess).
+  bool ApplyFeedback(std::string_view guess, std::string_view pattern);
+  bool AllowsGuess(std::string_view guess) const;
+  bool IsCandidate(std::string_view guess) const;
+
+  // Follows the solver's decision tree while the game is still on it,
+  // names the answer once only one word remains, and otherwise searches
+  // guess_pool() against remaining(). Empty if the dictionary is.
+  std::string Suggest(double* entropy_out = nullptr,
+                      WordleSolver::SearchStats* stats = nullptr) const;
+  // Suggest within a latency budget, or under explicit limits on the
+  // calling thread (WordleSolver::BestGuessWithin). Book moves and lone
+  // answers are always exact.
+  std::string SuggestWithin(std::chrono::microseconds budget,
+                            double* entropy_out,
+                            bool* exact_out,
+                            WordleSolver::SearchStats* stats = nullptr) const;
+  std::string SuggestWithin(const WordleSolver::SearchLimits& limits,
+                            double* entropy_out,
+                            bool* exact_out,
+                            WordleSolver::SearchStats* stats = nullptr) const;
+  // Suggest in the background (WordleSolver::BestGuessAsync). The handle
+  // does not refer to the session, so feedback may land while it runs;
+  // cancel it then, since its answer is for the earlier position.
+  GuessFuture SuggestAsync(std::chrono::microseconds budget =
+                               std::chrono::microseconds::max()) const;
+  // Suggest for many sessions at once. Sessions that need a search and
+  // share a solver, mode and guess pool go through one BestGuessBatch sweep;
+  // each answer equals that session's own Suggest.
+  static std::vector<std::string> SuggestBatch(
+      const std::vector<const GameSession*>& sessions,
+      std::vector<double>* entropies);
+  std::vector<WordleSolver::ScoredGuess> TopGuesses(size_t k) const;
+
+  const WordleSolver& solver() const { return *solver_; }
+  bool hard_mode() const { return hard_mode_; }
+  size_t turns() const { return turns_; }
+  const HintConstraints& hints() const { return hints_; }
+  const CandidateSet& remaining_set() const { return remaining_set_; }
+  const std::vector<size_t>& remaining() const {
+    return turns_ == 0 ? solver_->all_indices() : remaining_;
+  }
+  // Legal guesses: the hard-mode pool, or the whole dictionary.
+  const std::vector<size_t>& guess_pool() const {
+    return hard_mode_ && !hints_.empty() ? hard_pool_indices_
+                                         : solver_->all_indices();
+  }
+  // Decision-tree node for the current state, or DecisionTree::kNoNode.
+  uint32_t book_node() const { return book_node_; }
+
+ private:
+  // Suggest's answer when it needs no search; false when it does.
+  bool DirectSuggestion(std::string* guess, double* entropy_out) const;
+
+  const WordleSolver* solver_;
+  bool hard_mode_ = false;
+  size_t turns_ = 0;
+  HintConstraints hints_;
+  CandidateSet remaining_set_;
+  std::vector<size_t> remaining_;
+  CandidateSet hard_pool_;
+  std::vector<size_t> hard_pool_indices_;
+  uint32_t book_node_ = DecisionTree::kNoNode;
+  CandidateSet next_set_;
+};
+
+// Next-turn suggestions computed while the player is still deciding. For
+// the guess just suggested, the feedback patterns are taken from the most
+// likely (largest bucket) down; each one's follow-up suggestion is searched
+// in turn on a background thread. Taking a pattern stops the rest.
+class SuggestionSpeculator {
+ public:
+  struct Outcome {
+    GuessFuture::Result result;
+    // Search time the outcome saves the player.
+    std::chrono::microseconds compute{0};
+  };
+
+  SuggestionSpeculator() = default;
+  ~SuggestionSpeculator() { Cancel(); }
+
+  SuggestionSpeculator(const SuggestionSpeculator&) = delete;
+  SuggestionSpeculator& operator=(const SuggestionSpeculator&) = delete;
+
+  // Replaces any running speculation with one for up to `max_patterns`
+  // answers to `guess` from `session`'s position. Solving patterns are
+  // skipped. The session is copied; the solver must outlive the run.
+  void Start(const GameSession& session,
+             std::string_view guess,
+             size_t max_patterns,
+             std::chrono::microseconds budget =
+                 std::chrono::microseconds::max());
+  // The follow-up for `guess` answered with `pattern` if it is finished,
+  // else false. Either way speculation stops.
+  bool Take(std::string_view guess, std::string_view pattern, Outcome* out);
+  // Blocks until every speculated pattern has its follow-up.
+  void Wait();
+  void Cancel();
+  bool active() const { return shared_ != nullptr; }
+
+ private:
+  struct Shared {
+    std::mutex mutex;
+    std::unordered_map<int, Outcome> done;
+  };
+
+  std::string guess_;
+  std::shared_ptr<Shared> shared_;
+  CancelToken token_;
+  std::thread worker_;
+};
+
+// WordleSolver's entropy policy for other word lengths and alphabets. The
+// dictionary, pattern kernels and branch-and-bound search are the ones
+// WordleSolver runs, instantiated for WordShape<kLength, kAlphabetSize>.
+// Letters are single bytes drawn from `alphabet`, in order; lengths 4-8
+// over the 26 Latin letters are instantiated in Wordle.cpp.
+template <int kLength, int kAlphabetSize = 26>
+class BasicWordleSolver {
+ public:
+  using Shape = WordShape<kLength, kAlphabetSize>;
+  static constexpr int kLetterBits = Shape::kLetterBits;
+  static constexpr int kPatternCount = Shape::kPatternCount;
+  static constexpr int kSolvedPattern = Shape::kSolvedPattern;
+  static constexpr size_t kNoIndex = static_cast<size_t>(-1);
+
+  using Letters = typename Shape::Letters;
+  using LetterMask = typename Shape::LetterMask;
+  using PatternCode = typename Shape::PatternCode;
+  using Packed = typename Shape::Packed;
+  using Step = WordleSolver::Step;
+  using SearchStats = WordleSolver::SearchStats;
+
+  // `alphabet` must hold kAlphabetSize distinct bytes; words() is empty
+  // until a valid alphabet is set.
+  explicit BasicWordleSolver(
+      std::string_view alphabet = "abcdefghijklmnopqrstuvwxyz");
+
+  bool LoadDictionary(const std::string& path);
+  void SetWordList(const std::vector<std::string>& words);
+  const std::vector<std::string>& words() const { return words_; }
+  size_t IndexOf(std::string_view word) const;
+
+  bool IsValidWord(std::string_view word) const;
+  std::string NormalizeWord(std::string_view word) const;
+  Packed EncodeWord(std::string_view word) const;
+  static int Pattern(const Packed& guess, const Packed& target) {
+    return Shape::Pattern(guess, target);
+  }
+  static std::string PatternString(int pattern) {
+    return Shape::PatternString(pattern);
+  }
+  static int ParsePattern(std::string_view pattern) {
+    return Shape::ParsePattern(pattern);
+  }
+
+  int PatternAt(size_t guess_index, size_t target_index) const {
+    return Pattern(table_.packed(guess_index), table_.packed(target_index));
+  }
   std::array<int, kPatternCount> PatternCounts(
       size_t guess_index,
       const std::vector<size_t>& targets) const;
+  void FilterCandidates(const std::vector<size_t>& remaining,
+                        size_t guess_index,
+                        int pattern,
+                        std::vector<size_t>* out) const;
+  std::string BestGuess(const std::vector<size_t>& candidates,
+                        const std::vector<size_t>& targets,
+                        double* entropy_out,
+                        SearchStats* stats = nullptr) const;
+  // Hard-mode greedy play, as WordleSolver::SolveToTarget.
+  std::vector<Step> SolveToTarget(const std::string& target,
+                                  size_t max_steps) const;
+
+ private:
+  size_t BestGuessIndex(const std::vector<size_t>& candidates,
+                        const std::vector<size_t>& targets,
+                        double* entropy_out,
+                        SearchStats* stats = nullptr) const;
+
+  std::array<int16_t, 256> letter_index_{};
+  bool alphabet_valid_ = false;
+  // table_ views the text held in words_.
+  std::vector<std::string> words_;
+  BasicWordTable<Shape> table_;
+  std::unordered_map<Letters, size_t> index_by_letters_;
 };
 
+extern template class BasicWordleSolver<4>;
+extern template class BasicWordleSolver<5>;
+extern template class BasicWordleSolver<6>;
+extern template class BasicWordleSolver<7>;
+extern template class BasicWordleSolver<8>;
+
 void SetSimdEnabled(bool enabled);
 bool SimdEnabled();
 
+// Process-wide work-stealing pool shared by Wordle and Connections. Each
+// worker owns a deque, runs its own tasks newest first and steals the
+// oldest from the others when it runs dry. A parallel loop hands out
+// chunks from a shared counter in increasing order, so uneven iterations
+// balance themselves, and the calling thread works through chunks too
+// instead of blocking. Loops started from inside another loop (a parallel
+// BestGuess inside parallel games) queue on the same workers rather than
+// spawning more threads.
+class ThreadPool {
+ public:
+  // Total threads, counting the caller; 0 picks the hardware concurrency.
+  // Restarts the workers, so call it before any parallel work is running.
+  static void Configure(size_t threads, bool pin = false);
+  static ThreadPool& Instance();
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t threads() const { return workers_.size() + 1; }
+  bool pinned() const { return pin_; }
+
+  // Calls fn(i) for every i in [begin, end), `grain` iterations per task.
+  template <typename Fn>
+  void ParallelFor(size_t begin, size_t end, size_t grain, Fn&& fn) {
+    if (end <= begin) {
+      return;
+    }
+    grain = grain == 0 ? 1 : grain;
+    auto body = [&](size_t chunk) {
+      const size_t lo = begin + chunk * grain;
+      const size_t hi = end - lo < grain ? end : lo + grain;
+      for (size_t i = lo; i < hi; ++i) {
+        fn(i);
+      }
+    };
+    Run((end - begin + grain - 1) / grain, &Invoke<decltype(body)>, &body);
+  }
+
+  // Maps every chunk [lo, hi) of `grain` iterations to a partial result and
+  // folds the partials with combine in chunk order. The result does not
+  // depend on which thread ran which chunk, so ties resolved by position
+  // inside combine stay deterministic.
+  template <typename T, typename Map, typename Combine>
+  T ParallelReduce(size_t begin,
+                   size_t end,
+                   size_t grain,
+                   T identity,
+                   Map&& map,
+                   Combine&& combine) {
+    if (end <= begin) {
+      return identity;
+    }
+    grain = grain == 0 ? 1 : grain;
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    std::vector<T> partials(chunks, identity);
+    auto body = [&](size_t chunk) {
+      const size_t lo = begin + chunk * grain;
+      const size_t hi = end - lo < grain ? end : lo + grain;
+      partials[chunk] = map(lo, hi);
+    };
+    Run(chunks, &Invoke<decltype(body)>, &body);
+    T result = std::move(identity);
+    for (T& partial : partials) {
+      result = combine(std::move(result), std::move(partial));
+    }
+    return result;
+  }
+
+ private:
+  struct Job;
+  struct Queue;
+
+  ThreadPool(size_t threads, bool pin);
+
+  template <typename Body>
+  static void Invoke(void* body, size_t chunk) {
+    (*static_cast<Body*>(body))(chunk);
+  }
+
+  // Runs body(chunk) for chunk in [0, chunks) and returns once all are done.
+  void Run(size_t chunks, void (*invoke)(void*, size_t), void* body);
+  void WorkerLoop(size_t index);
+  void Push(size_t queue, std::shared_ptr<Job> job);
+  std::shared_ptr<Job> Take(size_t home);
+
+  std::vector<std::thread> workers_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::atomic<size_t> queued_{0};
+  std::atomic<size_t> next_queue_{0};
+  bool stop_ = false;
+  bool pin_ = false;
+};
+
 class EmbeddingStore {
  public:
   bool LoadWord2VecBinary(const std::string& path,
@@ -163,6 +1381,10 @@ class EmbeddingStore {
   std::unordered_map<std::string, Eigen::VectorXd> vectors_;
 };
 
+// Deterministic stand-in for a word the embeddings lack: a hash of the
+// word spread over `dims` sine components.
+Eigen::VectorXd FallbackEmbedding(const std::string& word, int dims);
+
 class SimilarityEngine {
  public:
   void BuildMatrix(const std::vector<Eigen::VectorXd>& embeddings);
@@ -183,7 +1405,9 @@ class ConnectionsSolver {
   };
 
   explicit ConnectionsSolver(const Eigen::MatrixXd& similarity);
-  std::vector<uint16_t> SolveBestPartition();
+  // Once `cancel` is set the search unwinds and returns the best partition
+  // found so far, which may be empty.
+  std::vector<uint16_t> SolveBestPartition(const CancelToken* cancel = nullptr);
   double BestScore() const { return best_score_; }
 
  private:
@@ -193,10 +1417,101 @@ class ConnectionsSolver {
   std::array<std::vector<int>, kNodeCount> groups_by_node_;
   std::vector<int> best_groups_;
   double best_score_ = -std::numeric_limits<double>::infinity();
+  const CancelToken* cancel_ = nullptr;
 
   void BuildGroups();
   void Search(uint16_t remaining, double score, std::vector<int>& current);
   static int FirstSetBit(uint16_t mask);
 };
 
+// `text` as the inside of a JSON string: quotes and backslashes escaped,
+// control characters blanked.
+std::string JsonEscape(std::string_view text);
+
+// Long-lived front end for `--serve`: newline-delimited JSON requests
+// against one loaded WordleSolver (and optional embeddings) with a
+// GameSession per named session. Every request may carry an "id" that is
+// echoed in its response. Requests are sharded by session onto worker
+// threads, so one session's requests are answered in order while other
+// sessions overtake them. Each shard queue is bounded; when it is full the
+// reader stops reading, which pushes back on the client through the pipe or
+// socket buffer instead of growing memory.
+class SolverServer {
+ public:
+  struct Options {
+    // Request workers; 0 uses one per thread-pool thread.
+    size_t workers = 0;
+    // Requests buffered per worker before reading pauses.
+    size_t queue_depth = 256;
+    // Queued requests a worker takes at once; consecutive suggest requests
+    // among them share one guess sweep.
+    size_t batch_limit = 64;
+    size_t max_sessions = 65536;
+    // Connections vectors; words without one get a hashed stand-in when
+    // allow_fallback is set.
+    const EmbeddingStore* embeddings = nullptr;
+    bool allow_fallback = false;
+    // Above 0, blends lexical similarity in as --connections-hard does.
+    double lexical_weight = 0.0;
+  };
+
+  SolverServer(const WordleSolver& wordle, Options options);
+  ~SolverServer();
+
+  SolverServer(const SolverServer&) = delete;
+  SolverServer& operator=(const SolverServer&) = delete;
+
+  // Answers one request line. Safe to call from several threads as long as
+  // no two calls name the same session at once.
+  std::string Handle(std::string_view request);
+  // Answers requests in order, the same as Handle one by one, except that
+  // each run of suggest requests for distinct sessions is searched as a
+  // batch (GameSession::SuggestBatch).
+  std::vector<std::string> HandleBatch(const std::vector<std::string>& requests);
+  // Pipelined service of one stream: reads requests until EOF, answers them
+  // on the workers and returns after the last response is written.
+  void Serve(std::istream& in, std::ostream& out);
+  // Listens on a UNIX domain socket, serving every connection as a stream
+  // on a thread that exits with it. Sessions are shared across connections.
+  // Returns false if the socket cannot be set up, including when `path`
+  // names an existing file that is not a socket; otherwise runs until Stop
+  // or a failed accept, then waits for the open connections to finish.
+  bool ServeUnixSocket(const std::string& path);
+  // Graceful shutdown of ServeUnixSocket, from any thread: no new
+  // connections are accepted, open ones stop reading, and the requests
+  // already read are answered before they close. A call made before
+  // ServeUnixSocket starts makes it return at once.
+  void Stop();
+  size_t sessions() const;
+
+ private:
+  struct Session;
+  struct Request;
+  struct Shard;
+  struct Stream;
+
+  void Submit(std::string line, Stream* stream);
+  void WorkerLoop(Shard* shard);
+  // Serves one connection until the client closes it or Stop; the caller
+  // closes `fd`.
+  void ServeFd(int fd);
+
+  const WordleSolver& wordle_;
+  Options options_;
+  mutable std::mutex sessions_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<Session>> sessions_;
+  uint64_t next_session_ = 1;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> next_shard_{0};
+  // Socket state, guarded by connections_mutex_: the listening socket (-1
+  // when not serving) and every open connection, whose threads are
+  // detached and signal connections_idle_ as they finish.
+  std::mutex connections_mutex_;
+  std::condition_variable connections_idle_;
+  int listener_ = -1;
+  std::vector<int> connections_;
+  bool stopping_ = false;
+};
+
 }  // namespace aletheia
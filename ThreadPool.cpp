@@ -0,0 +1,224 @@
+#include "Solver.hpp"
+
+#include <algorithm>
+#include <deque>
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace aletheia {
+namespace {
+std::mutex g_pool_mutex;
+std::unique_ptr<ThreadPool> g_pool;
+size_t g_pool_threads = 0;
+bool g_pool_pin = false;
+
+// Index of the pool worker running on this thread, or kNotWorker.
+constexpr size_t kNotWorker = static_cast<size_t>(-1);
+thread_local size_t t_worker = kNotWorker;
+
+size_t ResolveThreads(size_t requested) {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  // Single-threaded WASM cannot start threads; the caller does all work.
+  (void)requested;
+  return 1;
+#else
+  size_t threads = requested;
+  if (threads == 0) {
+    threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+#if defined(ALETHEIA_MAX_THREADS)
+    // The WASM pthread build preallocates a fixed number of workers.
+    threads = std::min<size_t>(threads, ALETHEIA_MAX_THREADS);
+#endif
+  }
+  return threads;
+#endif
+}
+
+void PinCurrentThread(size_t cpu) {
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+  const size_t cpus = std::max<size_t>(1, std::thread::hardware_concurrency());
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(static_cast<int>(cpu % cpus), &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+}  // namespace
+
+// One parallel loop. Chunks are claimed from `next` by whichever threads
+// picked up a reference; a reference taken after every chunk is claimed
+// just drops out.
+struct ThreadPool::Job {
+  size_t chunks = 0;
+  void (*invoke)(void*, size_t) = nullptr;
+  void* body = nullptr;
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> done{0};
+  std::mutex mutex;
+  std::condition_variable finished;
+
+  void Work() {
+    for (;;) {
+      const size_t chunk = next.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= chunks) {
+        return;
+      }
+      invoke(body, chunk);
+      if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.notify_all();
+      }
+    }
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] {
+      return done.load(std::memory_order_acquire) >= chunks;
+    });
+  }
+};
+
+struct ThreadPool::Queue {
+  std::mutex mutex;
+  std::deque<std::shared_ptr<Job>> jobs;
+};
+
+void ThreadPool::Configure(size_t threads, bool pin) {
+  std::lock_guard<std::mutex> lock(g_pool_mutex);
+  g_pool_threads = threads;
+  g_pool_pin = pin;
+  if (g_pool && (g_pool->threads() != ResolveThreads(threads) ||
+                 g_pool->pinned() != pin)) {
+    g_pool.reset();
+  }
+}
+
+ThreadPool& ThreadPool::Instance() {
+  std::lock_guard<std::mutex> lock(g_pool_mutex);
+  if (!g_pool) {
+    g_pool.reset(new ThreadPool(ResolveThreads(g_pool_threads), g_pool_pin));
+  }
+  return *g_pool;
+}
+
+ThreadPool::ThreadPool(size_t threads, bool pin) : pin_(pin) {
+  const size_t workers = threads > 1 ? threads - 1 : 0;
+  queues_.reserve(workers);
+  for (size_t i = 0; i < workers; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  workers_.reserve(workers);
+  for (size_t i = 0; i < workers; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Push(size_t queue, std::shared_ptr<Job> job) {
+  {
+    std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+    queues_[queue]->jobs.push_back(std::move(job));
+  }
+  queued_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<ThreadPool::Job> ThreadPool::Take(size_t home) {
+  const size_t count = queues_.size();
+  for (size_t offset = 0; offset < count; ++offset) {
+    const size_t queue = (home + offset) % count;
+    std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+    std::deque<std::shared_ptr<Job>>& jobs = queues_[queue]->jobs;
+    if (jobs.empty()) {
+      continue;
+    }
+    // Newest from our own deque keeps nested loops cache-warm; the oldest
+    // from a victim is the largest outstanding piece of work.
+    std::shared_ptr<Job> job;
+    if (offset == 0) {
+      job = std::move(jobs.back());
+      jobs.pop_back();
+    } else {
+      job = std::move(jobs.front());
+      jobs.pop_front();
+    }
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+  }
+  return nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+  t_worker = index;
+  if (pin_) {
+    PinCurrentThread(index + 1);
+  }
+  for (;;) {
+    std::shared_ptr<Job> job = Take(index);
+    if (job) {
+      job->Work();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [this] {
+      return stop_ || queued_.load(std::memory_order_acquire) > 0;
+    });
+    if (stop_) {
+      return;
+    }
+  }
+}
+
+void ThreadPool::Run(size_t chunks, void (*invoke)(void*, size_t), void* body) {
+  if (chunks == 0) {
+    return;
+  }
+  if (workers_.empty() || chunks == 1) {
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+      invoke(body, chunk);
+    }
+    return;
+  }
+  auto job = std::make_shared<Job>();
+  job->chunks = chunks;
+  job->invoke = invoke;
+  job->body = body;
+
+  // Offer the loop to as many workers as could take a chunk. A nested loop
+  // goes on its worker's own deque for idle workers to steal; a top-level
+  // loop is spread round-robin.
+  const size_t helpers = std::min(workers_.size(), chunks - 1);
+  for (size_t i = 0; i < helpers; ++i) {
+    const size_t queue =
+        t_worker != kNotWorker
+            ? t_worker
+            : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                  queues_.size();
+    Push(queue, job);
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+  }
+  wake_.notify_all();
+
+  job->Work();
+  // Every chunk is claimed by a thread that is already running it, so the
+  // wait cannot depend on queued work.
+  job->Wait();
+}
+
+}  // namespace aletheia
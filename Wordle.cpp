@@ -1,473 +1,4682 @@
 #include "Solver.hpp"
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <fstream>
+#include <istream>
+#include <mutex>
 #include <numeric>
+#include <ostream>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #if defined(ALETHEIA_USE_HWY)
 #include "hwy/highway.h"
 #endif
 
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define ALETHEIA_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace aletheia {
 namespace {
-constexpr int kWordLen = 5;
-constexpr int kAlphabet = 26;
-constexpr int kLetterBits = 5;
-constexpr uint32_t kLetterMask = 0x1F;
-constexpr int kSolvedPattern = 242;
-bool g_simd_enabled = true;
+using FiveLetters = WordleSolver::Shape;
+constexpr int kWordLen = FiveLetters::kWordLen;
+constexpr int kAlphabet = FiveLetters::kAlphabet;
+constexpr int kLetterBits = FiveLetters::kLetterBits;
+constexpr uint32_t kLetterMask = (1U << kLetterBits) - 1;
+constexpr int kSolvedPattern = FiveLetters::kSolvedPattern;
+// Read on every filter and pattern batch from any thread.
+std::atomic<bool> g_simd_enabled{true};
+
+constexpr char kPatternMatrixMagic[4] = {'A', 'L', 'P', 'M'};
+constexpr char kDecisionTreeMagic[4] = {'A', 'L', 'D', 'T'};
+constexpr char kGuessCacheMagic[4] = {'A', 'L', 'G', 'C'};
+
+struct PatternMatrixHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t size;
+  uint64_t fingerprint;
+  uint64_t reserved;
+};
+static_assert(sizeof(PatternMatrixHeader) == 32,
+              "pattern matrix header must stay 32 bytes");
+
+struct DecisionTreeHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t pattern_slots;
+  uint32_t flags;  // Bit 0: hard mode. Bits 8-15: DecisionTree::Policy.
+  uint64_t word_count;
+  uint64_t fingerprint;
+  uint64_t node_count;
+  uint64_t child_count;
+};
+static_assert(sizeof(DecisionTreeHeader) == 48,
+              "decision tree header must stay 48 bytes");
+
+struct GuessCacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t word_count;
+  uint64_t fingerprint;
+  uint64_t entry_count;
+};
+static_assert(sizeof(GuessCacheHeader) == 32,
+              "guess cache header must stay 32 bytes");
+
+struct GuessCacheRecord {
+  uint64_t hi;
+  uint64_t lo;
+  uint32_t guess;
+  uint32_t reserved;
+  double entropy;
+};
+static_assert(sizeof(GuessCacheRecord) == 32,
+              "guess cache record must stay 32 bytes");
 
-uint8_t LetterAt(const PackedWord& word, int index) {
-  return static_cast<uint8_t>((word.letters >> (index * kLetterBits)) &
-                              kLetterMask);
+uint64_t Mix64(uint64_t value) {
+  value ^= value >> 30;
+  value *= 0xBF58476D1CE4E5B9ULL;
+  value ^= value >> 27;
+  value *= 0x94D049BB133111EBULL;
+  value ^= value >> 31;
+  return value;
 }
 
-}  // namespace
+template <typename T>
+bool WriteArray(std::ostream& out, const std::vector<T>& values) {
+  out.write(reinterpret_cast<const char*>(values.data()),
+            static_cast<std::streamsize>(values.size() * sizeof(T)));
+  return static_cast<bool>(out);
+}
 
-void SetSimdEnabled(bool enabled) { g_simd_enabled = enabled; }
+template <typename T>
+bool ReadArray(std::istream& in, size_t count, std::vector<T>* values) {
+  values->resize(count);
+  in.read(reinterpret_cast<char*>(values->data()),
+          static_cast<std::streamsize>(count * sizeof(T)));
+  return static_cast<bool>(in);
+}
 
-bool SimdEnabled() { return g_simd_enabled; }
+// Guesses whose entropy bound falls this far below the best exact entropy
+// are discarded. The slack absorbs rounding between the incremental bound
+// and the exact sum, so pruning never drops a guess that would tie.
+constexpr double kPruneSlack = 1e-9;
 
-bool WordleSolver::LoadDictionary(const std::string& path) {
-  std::ifstream infile(path);
-  if (!infile) {
-    return false;
+// Guesses per pool task in the entropy sweeps: pruned guesses cost almost
+// nothing, so tasks stay small enough for the scored ones to spread out.
+constexpr size_t kGuessGrain = 32;
+
+// c*log2(c) in fixed point, 2^-kXLogXShift bits per unit. Integer sums of
+// these are exact, so a histogram's entropy does not depend on the order
+// its buckets are visited in and equal bucket sizes score bit-identically.
+// The rounding, under 2^-39 per bucket, stays well inside kPruneSlack.
+constexpr int kXLogXShift = 38;
+// Sums over up to this many targets fit 64 bits.
+constexpr size_t kMaxFixedTotal = size_t{1} << 20;
+constexpr size_t kXLogXTableSize = size_t{1} << 14;
+
+uint64_t ComputeXLogX(size_t c) {
+  if (c < 2) {
+    return 0;
   }
-  std::vector<std::string> words;
-  std::string line;
-  while (std::getline(infile, line)) {
-    words.push_back(line);
+  const double value = static_cast<double>(c);
+  return static_cast<uint64_t>(
+      std::llround(std::ldexp(value * std::log2(value), kXLogXShift)));
+}
+
+const uint64_t* XLogXTable() {
+  static const std::vector<uint64_t> table = [] {
+    std::vector<uint64_t> values(kXLogXTableSize);
+    for (size_t c = 0; c < values.size(); ++c) {
+      values[c] = ComputeXLogX(c);
+    }
+    return values;
+  }();
+  return table.data();
+}
+
+uint64_t XLogX(const uint64_t* table, size_t c) {
+  return c < kXLogXTableSize ? table[c] : ComputeXLogX(c);
+}
+
+// XLogX(c) - XLogX(c - 1): what the c-th target in a bucket adds.
+const uint64_t* XLogXStepTable() {
+  static const std::vector<uint64_t> steps = [] {
+    const uint64_t* table = XLogXTable();
+    std::vector<uint64_t> values(kXLogXTableSize, 0);
+    for (size_t c = 1; c < values.size(); ++c) {
+      values[c] = table[c] - table[c - 1];
+    }
+    return values;
+  }();
+  return steps.data();
+}
+
+// H = log2(n) - sum c*log2(c) / n, with the sum taken over the table.
+template <size_t N>
+double EntropyFromCounts(const std::array<int, N>& counts, size_t total) {
+  if (total > kMaxFixedTotal) {
+    double entropy = 0.0;
+    const double inv_total = 1.0 / static_cast<double>(total);
+    for (int count : counts) {
+      if (count > 0) {
+        const double p = count * inv_total;
+        entropy -= p * std::log2(p);
+      }
+    }
+    return entropy;
   }
-  SetWordList(words);
-  return !words_.empty();
+  const uint64_t* table = XLogXTable();
+  uint64_t sum = 0;
+  size_t buckets = 0;
+  for (int count : counts) {
+    sum += XLogX(table, static_cast<size_t>(count));
+    buckets += count != 0 ? 1 : 0;
+  }
+  if (buckets < 2) {
+    return 0.0;
+  }
+  return std::log2(static_cast<double>(total)) -
+         std::ldexp(static_cast<double>(sum), -kXLogXShift) /
+             static_cast<double>(total);
 }
 
-void WordleSolver::SetWordList(const std::vector<std::string>& words) {
-  words_.clear();
-  word_storage_.clear();
+// Pattern histogram for one scan. A run of one pattern makes each count
+// wait on the store of the one before, so long scans deal consecutive
+// codes round-robin into 16-bit sub-histograms and fold them into the
+// counts once. Short scans count directly; the fold would cost more than
+// the stalls it avoids.
+template <size_t N>
+class PatternTally {
+ public:
+  static constexpr size_t kMinCodes = 1024;
 
-#if defined(ALETHEIA_USE_WORD_POOL)
-  size_t total_bytes = 0;
-  for (const auto& word : words) {
-    total_bytes += word.size() + 1;
+  PatternTally(std::array<int, N>* counts, size_t expected)
+      : counts_(*counts), interleaved_(expected >= kMinCodes) {
+    if (interleaved_) {
+      for (auto& lane : lanes_) {
+        lane.fill(0);
+      }
+    }
   }
-  word_pool_.Reset(total_bytes);
 
-  words_.reserve(words.size());
-  for (const auto& word : words) {
-    std::string normalized = NormalizeWord(word);
-    if (!IsValidWord(normalized)) {
+  template <typename PatternCode>
+  void Add(const PatternCode* codes, size_t n) {
+    Add(n, [codes](size_t i) { return codes[i]; });
+  }
+
+  // Adds code(0) .. code(n - 1), e.g. pattern matrix entries read in place.
+  template <typename Code>
+  void Add(size_t n, Code code) {
+    if (!interleaved_) {
+      for (size_t i = 0; i < n; ++i) {
+        counts_[code(i)]++;
+      }
+      return;
+    }
+    size_t offset = 0;
+    while (offset < n) {
+      const size_t run = std::min(n - offset, kFoldEvery - pending_);
+      const size_t end = offset + run;
+      // Lane of code(i) continues the round robin of earlier calls.
+      auto lane = [&](size_t i) { return (pending_ + i - offset) % kLanes; };
+      size_t i = offset;
+      for (; i < end && lane(i) != 0; ++i) {
+        lanes_[lane(i)][code(i)]++;
+      }
+      for (; i + kLanes <= end; i += kLanes) {
+        lanes_[0][code(i)]++;
+        lanes_[1][code(i + 1)]++;
+        lanes_[2][code(i + 2)]++;
+        lanes_[3][code(i + 3)]++;
+      }
+      for (; i < end; ++i) {
+        lanes_[lane(i)][code(i)]++;
+      }
+      pending_ += run;
+      offset = end;
+      if (pending_ == kFoldEvery) {
+        Fold();
+      }
+    }
+  }
+
+  // Adds the sub-histograms into the counts; call once the scan is done.
+  void Fold() {
+    if (pending_ == 0) {
+      return;
+    }
+    for (size_t pattern = 0; pattern < N; ++pattern) {
+      counts_[pattern] += lanes_[0][pattern] + lanes_[1][pattern] +
+                          lanes_[2][pattern] + lanes_[3][pattern];
+    }
+    for (auto& lane : lanes_) {
+      lane.fill(0);
+    }
+    pending_ = 0;
+  }
+
+ private:
+  static constexpr size_t kLanes = 4;
+  // Each lane takes every fourth code, so none passes 65535 before a fold.
+  static constexpr size_t kFoldEvery = kLanes * 65535;
+  // Lanes start on cache lines.
+  static constexpr size_t kLaneSize = (N + 31) / 32 * 32;
+
+  std::array<int, N>& counts_;
+  const bool interleaved_;
+  size_t pending_ = 0;
+  alignas(64) std::array<std::array<uint16_t, kLaneSize>, kLanes> lanes_;
+};
+
+// Letter statistics of a target set. They bound a guess's entropy without
+// building its pattern histogram.
+template <typename Shape>
+struct TargetLetters {
+  static constexpr int kLength = Shape::kWordLen;
+  static constexpr int kLetters = Shape::kAlphabet;
+
+  size_t total = 0;
+  typename Shape::LetterMask any = 0;
+  std::array<std::array<int, kLetters>, kLength> at{};
+  std::array<int, kLetters> containing{};
+  // occurrences[L][k]: targets holding letter L exactly k times.
+  std::array<std::array<int, kLength + 1>, kLetters> occurrences{};
+};
+
+template <typename Shape>
+TargetLetters<Shape> SummarizeTargets(const BasicWordTable<Shape>& words,
+                                      const std::vector<size_t>& targets) {
+  constexpr int kLength = Shape::kWordLen;
+  TargetLetters<Shape> summary;
+  summary.total = targets.size();
+  for (size_t index : targets) {
+    const typename Shape::Packed word = words.packed(index);
+    summary.any |= word.mask;
+    std::array<uint8_t, Shape::kAlphabet> seen{};
+    for (int i = 0; i < kLength; ++i) {
+      const uint32_t letter = Shape::LetterAt(word.letters, i);
+      summary.at[i][letter]++;
+      seen[letter]++;
+    }
+    for (auto mask = word.mask; mask != 0; mask &= mask - 1) {
+      int letter = std::countr_zero(mask);
+      summary.containing[letter]++;
+      summary.occurrences[letter][seen[letter]]++;
+    }
+  }
+  return summary;
+}
+
+// Upper bound on a guess's entropy over the summarized targets.
+//
+// The pattern is determined by the colours of each group of positions that
+// share a guess letter, so by subadditivity H(pattern) <= sum of the group
+// entropies. A single position's colour distribution is exact from letter
+// counts. A repeated letter's colours are a function of which of its
+// positions are green plus min(occurrences, repeats), bounded the same way.
+// The result is also capped by log2 of how many patterns can occur at all:
+// a letter absent from every target is always gray, and a letter fixed in
+// place is always green.
+template <typename Shape>
+double EntropyBound(const typename Shape::Packed& guess,
+                    const TargetLetters<Shape>& summary,
+                    const std::vector<double>& xlogx,
+                    size_t* patterns_out) {
+  using LetterMask = typename Shape::LetterMask;
+  constexpr int kLength = Shape::kWordLen;
+  const size_t n = summary.total;
+  const double inv_n = 1.0 / static_cast<double>(n);
+  const double log_n = std::log2(static_cast<double>(n));
+  auto split = [&](std::initializer_list<int> parts) {
+    double sum = 0.0;
+    for (int part : parts) {
+      sum += xlogx[part];
+    }
+    return log_n - sum * inv_n;
+  };
+
+  std::array<uint8_t, kLength> letters{};
+  for (int i = 0; i < kLength; ++i) {
+    letters[i] = static_cast<uint8_t>(Shape::LetterAt(guess.letters, i));
+  }
+  const int total = static_cast<int>(n);
+  double bound = 0.0;
+  size_t patterns = 1;
+  LetterMask done = 0;
+  for (int i = 0; i < kLength; ++i) {
+    const uint8_t letter = letters[i];
+    const LetterMask bit = LetterMask{1} << letter;
+    if ((done & bit) != 0 || (summary.any & bit) == 0) {
       continue;
     }
-    std::string_view stored = word_pool_.Store(normalized);
-    if (stored.empty()) {
+    done |= bit;
+    int repeats = 0;
+    for (int j = i; j < kLength; ++j) {
+      if (letters[j] == letter) {
+        const int green = summary.at[j][letter];
+        patterns *= (green > 0 ? 1 : 0) + (green < total ? 2 : 0);
+        ++repeats;
+      }
+    }
+    const int present = summary.containing[letter];
+    if (repeats == 1) {
+      const int green = summary.at[i][letter];
+      bound += split({green, present - green, total - present});
       continue;
     }
-    WordEntry entry;
-    entry.text = stored;
-    entry.packed = EncodeWord(entry.text);
-    words_.push_back(entry);
+    for (int j = i; j < kLength; ++j) {
+      if (letters[j] == letter) {
+        const int green = summary.at[j][letter];
+        bound += split({green, total - green});
+      }
+    }
+    const auto& occurrences = summary.occurrences[letter];
+    int clipped = 0;
+    for (int k = repeats; k <= kLength; ++k) {
+      clipped += occurrences[k];
+    }
+    double sum = xlogx[total - present] + xlogx[clipped];
+    for (int k = 1; k < repeats; ++k) {
+      sum += xlogx[occurrences[k]];
+    }
+    bound += log_n - sum * inv_n;
   }
-#else
-  words_.reserve(words.size());
-  word_storage_.reserve(words.size());
-  for (const auto& word : words) {
-    std::string normalized = NormalizeWord(word);
-    if (!IsValidWord(normalized)) {
-      continue;
+
+  patterns =
+      std::min({patterns, n, static_cast<size_t>(Shape::kPatternCount)});
+  if (patterns_out) {
+    *patterns_out = patterns;
+  }
+  return std::min(bound, std::log2(static_cast<double>(patterns)));
+}
+
+// Keys under which guesses that split the summarized targets identically,
+// pattern for pattern, collide. A letter's colours depend only on where
+// that letter sits in the guess and the target, so a letter absent from
+// every target, or a single letter coloured the same for every target, is
+// replaced by a marker for its constant colour; every other letter is kept
+// with all its positions. An answer is the only guess that scores all
+// green against itself, so answers never share a key.
+template <typename Shape>
+class SplitKeys {
+  static constexpr int kLength = Shape::kWordLen;
+  static constexpr int kLetters = Shape::kAlphabet;
+  // Letters plus the three colour markers.
+  static constexpr int kKeyBits =
+      std::bit_width(static_cast<unsigned>(kLetters + 2));
+  static_assert(kLength * kKeyBits < 64, "split keys must fit 64 bits");
+
+ public:
+  // The all-ones key is never formed, so it can mark empty set slots.
+  using Key =
+      std::conditional_t<kLength * kKeyBits < 32, uint32_t, uint64_t>;
+
+  explicit SplitKeys(const TargetLetters<Shape>& summary) {
+    constexpr Key kGray = kLetters;
+    constexpr Key kYellow = kLetters + 1;
+    constexpr Key kGreen = kLetters + 2;
+    const int total = static_cast<int>(summary.total);
+    for (int i = 0; i < kLength; ++i) {
+      for (int letter = 0; letter < kLetters; ++letter) {
+        const int present = summary.containing[letter];
+        const int green = summary.at[i][letter];
+        Key code = static_cast<Key>(letter);
+        if (present == 0) {
+          code = kGray;
+        } else if (green == total) {
+          code = kGreen;
+        } else if (green == 0 && present == total) {
+          code = kYellow;
+        }
+        merges_ = merges_ || code != static_cast<Key>(letter);
+        single_[i][letter] = code << (i * kKeyBits);
+        repeated_[i][letter] = (present == 0 ? kGray : Key(letter))
+                               << (i * kKeyBits);
+      }
     }
-    word_storage_.push_back(std::move(normalized));
-    WordEntry entry;
-    entry.text = word_storage_.back();
-    entry.packed = EncodeWord(entry.text);
-    words_.push_back(entry);
   }
-#endif
+
+  // False when every letter keeps its own key, so no two guesses collide.
+  bool merges() const { return merges_; }
+
+  Key operator()(const typename Shape::Packed& guess) const {
+    using LetterMask = typename Shape::LetterMask;
+    std::array<uint8_t, kLength> letters;
+    LetterMask seen = 0;
+    LetterMask repeated = 0;
+    for (int i = 0; i < kLength; ++i) {
+      letters[i] = static_cast<uint8_t>(Shape::LetterAt(guess.letters, i));
+      const LetterMask bit = LetterMask{1} << letters[i];
+      repeated |= seen & bit;
+      seen |= bit;
+    }
+    Key key = 0;
+    for (int i = 0; i < kLength; ++i) {
+      key |= (repeated >> letters[i]) & 1U ? repeated_[i][letters[i]]
+                                           : single_[i][letters[i]];
+    }
+    return key;
+  }
+
+ private:
+  std::array<std::array<Key, kLetters>, kLength> single_{};
+  std::array<std::array<Key, kLetters>, kLength> repeated_{};
+  bool merges_ = false;
+};
+
+// Insert-only set of split keys, which never use every bit.
+template <typename Key>
+class SplitKeySet {
+ public:
+  explicit SplitKeySet(size_t capacity) {
+    while ((size_t{1} << bits_) < capacity * 2) {
+      ++bits_;
+    }
+    slots_.assign(size_t{1} << bits_, kEmpty);
+  }
+
+  // True if `key` was not in the set yet.
+  bool Insert(Key key) {
+    const size_t mask = slots_.size() - 1;
+    // Fibonacci hashing: the top bits of the product mix every letter.
+    for (size_t slot = static_cast<size_t>((key * kGolden) >>
+                                           (kKeyWidth - bits_));
+         ; slot = (slot + 1) & mask) {
+      if (slots_[slot] == key) {
+        return false;
+      }
+      if (slots_[slot] == kEmpty) {
+        slots_[slot] = key;
+        return true;
+      }
+    }
+  }
+
+ private:
+  static constexpr int kKeyWidth = std::numeric_limits<Key>::digits;
+  static constexpr Key kGolden = static_cast<Key>(
+      kKeyWidth == 32 ? 0x9E3779B1ULL : 0x9E3779B97F4A7C15ULL);
+  static constexpr Key kEmpty = ~Key{0};
+  int bits_ = 4;
+  std::vector<Key> slots_;
+};
+
+void AtomicMax(std::atomic<double>* value, double candidate) {
+  double current = value->load(std::memory_order_relaxed);
+  while (candidate > current &&
+         !value->compare_exchange_weak(current, candidate,
+                                       std::memory_order_relaxed)) {
+  }
 }
 
-const std::vector<WordEntry>& WordleSolver::words() const { return words_; }
+const PatternMatrix* MatrixOf(const WordleSolver& solver) {
+  return solver.HasPatternMatrix() ? &solver.pattern_matrix() : nullptr;
+}
 
-bool WordleSolver::IsValidWord(std::string_view word) {
-  if (word.size() != kWordLen) {
-    return false;
+// One branch-and-bound best-guess search over a word table, shared by every
+// word shape. Codes are read from the pattern matrix when the solver has one
+// (5-letter words only) and computed with PatternBatch otherwise.
+template <typename Shape>
+class GuessSearch {
+ public:
+  using Counts = std::array<int, Shape::kPatternCount>;
+  using Letters = typename Shape::Letters;
+  using Packed = typename Shape::Packed;
+  using PatternCode = typename Shape::PatternCode;
+
+  GuessSearch(const BasicWordTable<Shape>& words, const PatternMatrix* matrix)
+      : words_(words), matrix_(matrix) {}
+
+  // Without a pattern matrix every histogram pass computes codes from the
+  // targets' letters, so a search first copies them into one dense table
+  // and each pass streams contiguous letters instead of gathering across
+  // the dictionary. Matrix rows are read by target index and need no copy;
+  // *packed is left empty then.
+  void CompactTargets(const std::vector<size_t>& targets,
+                      BasicWordTable<Shape>* packed) const {
+    packed->Clear();
+    if (!matrix_) {
+      packed->Assign(words_, targets);
+    }
   }
-  for (char c : word) {
-    if (c < 'a' || c > 'z') {
+
+  // Stops between chunks of targets once `cancel` is set, leaving the
+  // counts partial.
+  Counts PatternCounts(size_t guess_index,
+                       const std::vector<size_t>& targets,
+                       const CancelToken* cancel) const {
+    Counts counts{};
+    counts.fill(0);
+    PatternTally<Shape::kPatternCount> tally(&counts, targets.size());
+    constexpr size_t kBatch = 256;
+    std::array<PatternCode, kBatch> codes;
+    const uint8_t* row = matrix_ ? matrix_->Row(guess_index) : nullptr;
+    std::array<Letters, kBatch> letters;
+    const Packed guess = words_.packed(guess_index);
+    for (size_t offset = 0; offset < targets.size(); offset += kBatch) {
+      if (cancel && cancel->cancelled()) {
+        break;
+      }
+      const size_t batch = std::min(kBatch, targets.size() - offset);
+      if (row) {
+        const size_t* indices = targets.data() + offset;
+        tally.Add(batch, [row, indices](size_t i) { return row[indices[i]]; });
+        continue;
+      }
+      for (size_t i = 0; i < batch; ++i) {
+        letters[i] = words_.letters()[targets[offset + i]];
+      }
+      Shape::PatternBatch(guess, letters.data(), batch, codes.data());
+      tally.Add(codes.data(), batch);
+    }
+    tally.Fold();
+    return counts;
+  }
+
+  // Fills *counts_out with the guess's histogram unless the partial
+  // histogram shows its entropy cannot reach *best (or `cancel` is set), in
+  // which case it returns false early.
+  bool BoundedCounts(size_t guess_index,
+                     const std::vector<size_t>& targets,
+                     const BasicWordTable<Shape>& packed_targets,
+                     double log_total,
+                     size_t patterns,
+                     const std::atomic<double>* best,
+                     Counts* counts_out,
+                     const CancelToken* cancel) const {
+    Counts& counts = *counts_out;
+    counts.fill(0);
+    const double inv_total = 1.0 / static_cast<double>(targets.size());
+    // S grows by an integer step per target: no floating-point add chain.
+    const uint64_t* table = XLogXTable();
+    const uint64_t* steps = XLogXStepTable();
+    const bool fixed = targets.size() <= kMaxFixedTotal;
+    uint64_t sum_xlogx = 0;
+    auto add = [&](size_t code) {
+      const size_t count = static_cast<size_t>(++counts[code]);
+      sum_xlogx += count < kXLogXTableSize
+                       ? steps[count]
+                       : XLogX(table, count) - XLogX(table, count - 1);
+    };
+    // The unscanned targets add at least patterns * f(rest / patterns) to S:
+    // f(c + x) >= f(c) + f(x) for f(x) = x*log2(x), and f is convex.
+    const double spread = static_cast<double>(patterns);
+    auto hopeless = [&](size_t scanned) {
+      if (cancel && cancel->cancelled()) {
+        return true;
+      }
+      if (!fixed) {
+        return false;
+      }
+      double rest = static_cast<double>(targets.size() - scanned);
+      double floor = rest > spread ? rest * std::log2(rest / spread) : 0.0;
+      const double sum =
+          std::ldexp(static_cast<double>(sum_xlogx), -kXLogXShift);
+      return log_total - (sum + floor) * inv_total <
+             best->load(std::memory_order_relaxed) - kPruneSlack;
+    };
+
+    constexpr size_t kBatch = 256;
+    if (matrix_) {
+      const uint8_t* row = matrix_->Row(guess_index);
+      for (size_t offset = 0; offset < targets.size(); offset += kBatch) {
+        const size_t batch = std::min(kBatch, targets.size() - offset);
+        for (size_t i = 0; i < batch; ++i) {
+          add(row[targets[offset + i]]);
+        }
+        if (hopeless(offset + batch)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    std::array<PatternCode, kBatch> codes;
+    const Packed guess = words_.packed(guess_index);
+    const Letters* letters = packed_targets.letters();
+    for (size_t offset = 0; offset < targets.size(); offset += kBatch) {
+      const size_t batch = std::min(kBatch, targets.size() - offset);
+      Shape::PatternBatch(guess, letters + offset, batch, codes.data());
+      for (size_t i = 0; i < batch; ++i) {
+        add(codes[i]);
+      }
+      if (hopeless(offset + batch)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Returns false if the deadline or the token cut the search short; the
+  // guess is then the best scored so far.
+  bool Run(const std::vector<size_t>& candidates,
+           const std::vector<size_t>& targets,
+           const WordleSolver::SearchLimits& limits,
+           size_t* guess_out,
+           double* entropy_out,
+           WordleSolver::SearchStats* stats) const {
+    if (stats) {
+      *stats = WordleSolver::SearchStats{};
+      stats->candidates = candidates.size();
+    }
+    if (candidates.empty()) {
+      *guess_out = 0;
+      if (entropy_out) {
+        *entropy_out = 0.0;
+      }
+      return true;
+    }
+    if (targets.empty()) {
+      *guess_out = candidates[0];
+      if (entropy_out) {
+        *entropy_out = 0.0;
+      }
+      if (stats) {
+        stats->evaluated = candidates.size();
+      }
+      return true;
+    }
+
+    // Cancelling before anything is scored yields the first candidate.
+    constexpr size_t kCancelStride = 1024;
+    auto abandoned = [&] {
+      if (stats) {
+        stats->pruned = candidates.size();
+      }
+      if (entropy_out) {
+        *entropy_out = 0.0;
+      }
+      *guess_out = candidates[0];
       return false;
+    };
+    if (limits.cancel && limits.cancel->cancelled()) {
+      return abandoned();
+    }
+
+    // Branch and bound: a guess whose entropy bound is below the best exact
+    // entropy seen by any thread is skipped. While a histogram fills,
+    // H = log2(n) - S/n where S = sum of c*log2(c) only grows, so a guess is
+    // also abandoned once its partial histogram rules it out.
+    const size_t total = targets.size();
+    const double log_total = std::log2(static_cast<double>(total));
+    BasicWordTable<Shape> packed_targets;
+    CompactTargets(targets, &packed_targets);
+    const TargetLetters<Shape> summary = SummarizeTargets(words_, targets);
+    std::vector<double> xlogx(total + 1, 0.0);
+    for (size_t c = 2; c <= total; ++c) {
+      double value = static_cast<double>(c);
+      xlogx[c] = value * std::log2(value);
+    }
+
+    // Guesses that split the targets like an earlier candidate score the
+    // same and lose the tie, so only the first of each kind is searched.
+    // Visit those from the loosest bound down: the strongest guesses are
+    // scored first and most of the rest never get past their bound.
+    const SplitKeys<Shape> split_key(summary);
+    SplitKeySet<typename SplitKeys<Shape>::Key> splits(
+        split_key.merges() ? candidates.size() : 0);
+    std::vector<double> bounds(candidates.size());
+    std::vector<size_t> patterns(candidates.size());
+    std::vector<size_t> order;
+    order.reserve(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (limits.cancel && i % kCancelStride == 0 &&
+          limits.cancel->cancelled()) {
+        return abandoned();
+      }
+      const Packed guess = words_.packed(candidates[i]);
+      if (split_key.merges() && !splits.Insert(split_key(guess))) {
+        continue;
+      }
+      bounds[i] = EntropyBound(guess, summary, xlogx, &patterns[i]);
+      order.push_back(i);
+    }
+    if (stats) {
+      stats->merged = candidates.size() - order.size();
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return bounds[a] > bounds[b];
+    });
+    if (limits.cancel && limits.cancel->cancelled()) {
+      return abandoned();
+    }
+
+    const bool timed =
+        limits.deadline != std::chrono::steady_clock::time_point::max();
+    auto out_of_time = [&] {
+      return (limits.cancel && limits.cancel->cancelled()) ||
+             (timed && std::chrono::steady_clock::now() >= limits.deadline);
+    };
+    std::atomic<double> shared_best(-std::numeric_limits<double>::infinity());
+    std::atomic<bool> expired(false);
+    using Best = std::tuple<double, size_t, size_t>;
+    Best warm(-std::numeric_limits<double>::infinity(), candidates.size(), 0);
+    // Warm-up guesses already scored in full, skipped by the main pass.
+    std::vector<uint8_t> warmed;
+
+    // Warm-up: the loosest-bound guesses are ranked on an evenly spaced
+    // sample of the targets, which are in dictionary order, and the leaders
+    // are scored on all of them. Their best is the answer if time runs out
+    // and a strong starting bound if not. The first of each pass always runs.
+    if (limits.warm_up) {
+      constexpr size_t kSampleTargets = 128;
+      constexpr size_t kWarmUpGuesses = 256;
+      constexpr size_t kContenders = 16;
+      std::vector<size_t> sample;
+      sample.reserve(std::min(total, kSampleTargets));
+      for (size_t i = 0; i < std::min(total, kSampleTargets); ++i) {
+        sample.push_back(targets[i * total / std::min(total, kSampleTargets)]);
+      }
+      BasicWordTable<Shape> packed_sample;
+      packed_sample.Assign(words_, sample);
+      const size_t ranked = std::min(kWarmUpGuesses, order.size());
+      std::vector<double> rough(ranked,
+                                -std::numeric_limits<double>::infinity());
+      ThreadPool::Instance().ParallelFor(0, ranked, kGuessGrain, [&](size_t k) {
+        if (k > 0 && out_of_time()) {
+          return;
+        }
+        std::array<PatternCode, kSampleTargets> codes;
+        Counts counts{};
+        Shape::PatternBatch(words_.packed(candidates[order[k]]),
+                     packed_sample.letters(), sample.size(), codes.data());
+        for (size_t j = 0; j < sample.size(); ++j) {
+          counts[codes[j]]++;
+        }
+        rough[k] = EntropyFromCounts(counts, sample.size());
+      });
+      std::vector<size_t> leaders(ranked);
+      std::iota(leaders.begin(), leaders.end(), 0);
+      const size_t contenders = std::min(kContenders, ranked);
+      std::partial_sort(leaders.begin(), leaders.begin() + contenders,
+                        leaders.end(), [&](size_t a, size_t b) {
+                          return rough[a] > rough[b] ||
+                                 (rough[a] == rough[b] && a < b);
+                        });
+      Counts counts{};
+      warmed.assign(candidates.size(), 0);
+      for (size_t i = 0; i < contenders; ++i) {
+        if (i > 0 && out_of_time()) {
+          break;
+        }
+        const size_t position = order[leaders[i]];
+        warmed[position] = 1;
+        if (!BoundedCounts(candidates[position], targets, packed_targets,
+                                  log_total, patterns[position], &shared_best,
+                                  &counts, limits.cancel)) {
+          continue;
+        }
+        auto& [warm_entropy, warm_position, warm_evaluated] = warm;
+        ++warm_evaluated;
+        const double entropy = EntropyFromCounts(counts, total);
+        if (entropy > warm_entropy ||
+            (entropy == warm_entropy && position < warm_position)) {
+          warm_entropy = entropy;
+          warm_position = position;
+        }
+        AtomicMax(&shared_best, entropy);
+      }
+    }
+
+    // Chunks are claimed in bound order, so every thread starts on strong
+    // guesses and the shared bound rises quickly.
+    auto search = [&](size_t begin, size_t end) {
+      double local_best_entropy = -std::numeric_limits<double>::infinity();
+      size_t local_best_position = candidates.size();
+      size_t local_evaluated = 0;
+      Counts counts{};
+      for (size_t k = begin; k < end; ++k) {
+        const size_t position = order[k];
+        const size_t guess_index = candidates[position];
+        if (bounds[position] <
+                shared_best.load(std::memory_order_relaxed) - kPruneSlack ||
+            (!warmed.empty() && warmed[position])) {
+          continue;
+        }
+        if (expired.load(std::memory_order_relaxed) || out_of_time()) {
+          expired.store(true, std::memory_order_relaxed);
+          break;
+        }
+        if (!BoundedCounts(guess_index, targets, packed_targets,
+                                  log_total, patterns[position], &shared_best,
+                                  &counts, limits.cancel)) {
+          continue;
+        }
+        ++local_evaluated;
+        double entropy = EntropyFromCounts(counts, total);
+        if (entropy > local_best_entropy ||
+            (entropy == local_best_entropy &&
+             position < local_best_position)) {
+          local_best_entropy = entropy;
+          local_best_position = position;
+        }
+        AtomicMax(&shared_best, entropy);
+      }
+      return Best(local_best_entropy, local_best_position, local_evaluated);
+    };
+
+    // Ties resolve to the earliest candidate, as in the exhaustive loop, so
+    // the result depends neither on the search order nor on thread timing.
+    auto merge = [](const Best& a, const Best& b) {
+      const auto& [a_entropy, a_position, a_count] = a;
+      const auto& [b_entropy, b_position, b_count] = b;
+      const bool take_b = b_entropy > a_entropy ||
+                          (b_entropy == a_entropy && b_position < a_position);
+      return take_b ? Best(b_entropy, b_position, a_count + b_count)
+                    : Best(a_entropy, a_position, a_count + b_count);
+    };
+
+    if (out_of_time()) {
+      expired.store(true, std::memory_order_relaxed);
+    }
+    auto [best_entropy, best_position, evaluated] =
+        expired.load(std::memory_order_relaxed)
+            ? warm
+            : ThreadPool::Instance().ParallelReduce(
+                  0, order.size(), kGuessGrain, warm, search, merge);
+    if (limits.cancel && limits.cancel->cancelled()) {
+      // A guess abandoned mid-histogram may have been the best.
+      expired.store(true, std::memory_order_relaxed);
+    }
+    if (best_position == candidates.size()) {
+      // Out of time before any guess was scored: take the loosest bound.
+      best_position = order[0];
+      best_entropy = EntropyFromCounts(
+          PatternCounts(candidates[best_position], targets, limits.cancel),
+          total);
+    }
+
+    if (stats) {
+      stats->evaluated = evaluated;
+      stats->pruned = candidates.size() - evaluated;
+    }
+    if (entropy_out) {
+      *entropy_out = best_entropy;
     }
+    *guess_out = candidates[best_position];
+    return !expired.load(std::memory_order_relaxed);
   }
-  return true;
+
+ private:
+  const BasicWordTable<Shape>& words_;
+  const PatternMatrix* matrix_;
+};
+
+}  // namespace
+
+template <typename Shape>
+void BasicWordTable<Shape>::Clear() {
+  size_ = 0;
+  text_.clear();
 }
 
-std::string WordleSolver::NormalizeWord(std::string_view word) {
-  std::string normalized;
-  normalized.reserve(word.size());
-  for (char c : word) {
-    if (c >= 'A' && c <= 'Z') {
-      normalized.push_back(static_cast<char>(c - 'A' + 'a'));
-    } else if (c >= 'a' && c <= 'z') {
-      normalized.push_back(c);
+template <typename Shape>
+void BasicWordTable<Shape>::Reserve(size_t capacity) {
+  if (capacity <= capacity_) {
+    return;
+  }
+  // Round up so the mask array starts on an aligned boundary too.
+  constexpr size_t kPerLine = kAlignment / sizeof(Letters);
+  capacity = (capacity + kPerLine - 1) / kPerLine * kPerLine;
+  std::unique_ptr<unsigned char, AlignedDeleter> storage(
+      static_cast<unsigned char*>(::operator new(
+          capacity * (sizeof(Letters) + sizeof(LetterMask)),
+          std::align_val_t(kAlignment))));
+  Letters* letters = reinterpret_cast<Letters*>(storage.get());
+  LetterMask* masks = reinterpret_cast<LetterMask*>(letters + capacity);
+  if (size_ > 0) {
+    std::memcpy(letters, letters_, size_ * sizeof(Letters));
+    std::memcpy(masks, masks_, size_ * sizeof(LetterMask));
+  }
+  storage_ = std::move(storage);
+  letters_ = letters;
+  masks_ = masks;
+  capacity_ = capacity;
+  text_.reserve(capacity);
+}
+
+template <typename Shape>
+void BasicWordTable<Shape>::PushBack(const Packed& packed,
+                                     std::string_view text) {
+  if (size_ == capacity_) {
+    Reserve(capacity_ == 0 ? kAlignment : capacity_ * 2);
+  }
+  letters_[size_] = packed.letters;
+  masks_[size_] = packed.mask;
+  text_.push_back(text);
+  ++size_;
+}
+
+template <typename Shape>
+void BasicWordTable<Shape>::Assign(const BasicWordTable& source,
+                                   const std::vector<size_t>& indices) {
+  Clear();
+  Reserve(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    letters_[i] = source.letters_[indices[i]];
+    masks_[i] = source.masks_[indices[i]];
+    text_.push_back(source.text_[indices[i]]);
+  }
+  size_ = indices.size();
+}
+
+template class BasicWordTable<WordShape<4>>;
+template class BasicWordTable<WordShape<5>>;
+template class BasicWordTable<WordShape<6>>;
+template class BasicWordTable<WordShape<7>>;
+template class BasicWordTable<WordShape<8>>;
+
+CandidateSet CandidateSet::All(size_t universe) {
+  CandidateSet set(universe);
+  set.Fill();
+  return set;
+}
+
+CandidateSet CandidateSet::FromIndices(size_t universe,
+                                       const std::vector<size_t>& indices) {
+  CandidateSet set(universe);
+  for (size_t index : indices) {
+    if (index < universe) {
+      set.Insert(index);
     }
   }
-  return normalized;
+  return set;
 }
 
-PackedWord WordleSolver::EncodeWord(std::string_view word) {
-  PackedWord packed;
-  for (int i = 0; i < kWordLen; ++i) {
-    uint32_t letter = static_cast<uint32_t>(word[i] - 'a');
-    packed.letters |= (letter & kLetterMask) << (i * kLetterBits);
-    packed.mask |= 1U << letter;
+void CandidateSet::Reset(size_t universe) {
+  universe_ = universe;
+  blocks_.assign((universe + 63) / 64, 0);
+}
+
+void CandidateSet::Fill() {
+  std::fill(blocks_.begin(), blocks_.end(), ~uint64_t{0});
+  if (universe_ % 64 != 0 && !blocks_.empty()) {
+    blocks_.back() = (uint64_t{1} << (universe_ % 64)) - 1;
   }
-  return packed;
 }
 
-int WordleSolver::Pattern(const PackedWord& guess, const PackedWord& target) {
-  std::array<uint8_t, kWordLen> guess_letters{};
-  std::array<uint8_t, kWordLen> target_letters{};
-  for (int i = 0; i < kWordLen; ++i) {
-    guess_letters[i] = LetterAt(guess, i);
-    target_letters[i] = LetterAt(target, i);
+void CandidateSet::Clear() {
+  std::fill(blocks_.begin(), blocks_.end(), 0);
+}
+
+size_t CandidateSet::Count() const {
+  size_t count = 0;
+  for (uint64_t block : blocks_) {
+    count += static_cast<size_t>(std::popcount(block));
   }
+  return count;
+}
 
-  std::array<int, kAlphabet> counts{};
-  counts.fill(0);
-  for (int i = 0; i < kWordLen; ++i) {
-    counts[target_letters[i]]++;
+bool CandidateSet::Empty() const {
+  for (uint64_t block : blocks_) {
+    if (block != 0) {
+      return false;
+    }
   }
+  return true;
+}
 
-  std::array<int, kWordLen> result{};
-  result.fill(0);
-  for (int i = 0; i < kWordLen; ++i) {
-    if (guess_letters[i] == target_letters[i]) {
-      result[i] = 2;
-      counts[guess_letters[i]]--;
+void CandidateSet::IntersectWith(const CandidateSet& other) {
+  const size_t shared = std::min(blocks_.size(), other.blocks_.size());
+  for (size_t i = 0; i < shared; ++i) {
+    blocks_[i] &= other.blocks_[i];
+  }
+  for (size_t i = shared; i < blocks_.size(); ++i) {
+    blocks_[i] = 0;
+  }
+}
+
+size_t CandidateSet::IntersectCount(const CandidateSet& other) const {
+  const size_t shared = std::min(blocks_.size(), other.blocks_.size());
+  size_t count = 0;
+  for (size_t i = 0; i < shared; ++i) {
+    count += static_cast<size_t>(std::popcount(blocks_[i] & other.blocks_[i]));
+  }
+  return count;
+}
+
+void CandidateSet::ToIndices(std::vector<size_t>* out) const {
+  if (!out) {
+    return;
+  }
+  out->clear();
+  ForEach([out](size_t index) { out->push_back(index); });
+}
+
+void HintConstraints::Reset() {
+  fixed_letters_ = 0;
+  fixed_mask_ = 0;
+  banned_.fill(0);
+  min_count_.fill(0);
+  max_count_.fill(kUnbounded);
+  required_ = 0;
+  excluded_ = 0;
+  counted_ = 0;
+  hints_ = 0;
+  contradictory_ = false;
+}
+
+bool HintConstraints::Add(std::string_view guess, std::string_view pattern) {
+  if (!WordleSolver::IsValidWord(guess) ||
+      WordleSolver::ParsePattern(pattern) < 0) {
+    return false;
+  }
+  // Per guess letter: how many copies were coloured, and whether a grey
+  // copy capped the count at exactly that many.
+  std::array<uint8_t, kAlphabet> marked{};
+  LetterMask capped = 0;
+  LetterMask seen = 0;
+  for (int i = 0; i < kWordLen; ++i) {
+    const int letter = guess[i] - 'a';
+    const int shift = i * kLetterBits;
+    seen |= LetterMask{1} << letter;
+    if (pattern[i] == '2') {
+      if ((fixed_mask_ >> shift & kLetterMask) != 0 &&
+          (fixed_letters_ >> shift & kLetterMask) !=
+              static_cast<Letters>(letter)) {
+        contradictory_ = true;
+      }
+      fixed_mask_ |= kLetterMask << shift;
+      fixed_letters_ = (fixed_letters_ & ~(kLetterMask << shift)) |
+                       (static_cast<Letters>(letter) << shift);
+      marked[letter]++;
+    } else {
+      // Yellow and grey both say the letter is not at this position.
+      banned_[i] |= LetterMask{1} << letter;
+      if (pattern[i] == '1') {
+        // Feedback colours repeated letters left to right, so a yellow
+        // after a grey copy of the same letter cannot come from any answer.
+        if ((capped >> letter & 1U) != 0) {
+          contradictory_ = true;
+        }
+        marked[letter]++;
+      } else {
+        capped |= LetterMask{1} << letter;
+      }
+    }
+  }
+  for (LetterMask bits = seen; bits != 0; bits &= bits - 1) {
+    const int letter = std::countr_zero(bits);
+    min_count_[letter] = std::max(min_count_[letter], marked[letter]);
+    if ((capped >> letter & 1U) != 0) {
+      max_count_[letter] = std::min(max_count_[letter], marked[letter]);
+    }
+  }
+  ++hints_;
+  Recompile();
+  return true;
+}
+
+void HintConstraints::Recompile() {
+  required_ = 0;
+  excluded_ = 0;
+  counted_ = 0;
+  int total_min = 0;
+  for (int letter = 0; letter < kAlphabet; ++letter) {
+    const uint8_t low = min_count_[letter];
+    const uint8_t high = max_count_[letter];
+    total_min += low;
+    if (low > high) {
+      contradictory_ = true;
+    }
+    if (low > 0) {
+      required_ |= LetterMask{1} << letter;
+    }
+    if (high == 0) {
+      excluded_ |= LetterMask{1} << letter;
+    }
+    if (low > 1 || (high > 0 && high < kUnbounded)) {
+      counted_ |= LetterMask{1} << letter;
+    }
+  }
+  if (total_min > kWordLen) {
+    contradictory_ = true;
+  }
+  for (int i = 0; i < kWordLen; ++i) {
+    const int shift = i * kLetterBits;
+    if ((fixed_mask_ >> shift & kLetterMask) != 0 &&
+        (banned_[i] >> (fixed_letters_ >> shift & kLetterMask) & 1U) != 0) {
+      contradictory_ = true;
+    }
+  }
+}
+
+bool HintConstraints::Matches(const PackedWord& word) const {
+  if (contradictory_ || (word.mask & required_) != required_ ||
+      (word.mask & excluded_) != 0 ||
+      (word.letters & fixed_mask_) != fixed_letters_) {
+    return false;
+  }
+  std::array<uint8_t, kAlphabet> counts{};
+  for (int i = 0; i < kWordLen; ++i) {
+    const Letters letter = word.letters >> (i * kLetterBits) & kLetterMask;
+    if ((banned_[i] >> letter & 1U) != 0) {
+      return false;
+    }
+    counts[letter]++;
+  }
+  for (LetterMask bits = counted_ & word.mask; bits != 0; bits &= bits - 1) {
+    const int letter = std::countr_zero(bits);
+    if (counts[letter] < min_count_[letter] ||
+        counts[letter] > max_count_[letter]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HintConstraints::AllowsGuess(const PackedWord& word) const {
+  if ((word.mask & required_) != required_ ||
+      (word.letters & fixed_mask_) != fixed_letters_) {
+    return false;
+  }
+  for (LetterMask bits = counted_ & required_; bits != 0; bits &= bits - 1) {
+    const int letter = std::countr_zero(bits);
+    if (min_count_[letter] < 2) {
+      continue;
+    }
+    int count = 0;
+    for (int i = 0; i < kWordLen; ++i) {
+      count += (word.letters >> (i * kLetterBits) & kLetterMask) ==
+               static_cast<Letters>(letter);
+    }
+    if (count < min_count_[letter]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DecisionTree::Reset(uint64_t fingerprint,
+                         size_t word_count,
+                         bool hard_mode,
+                         Policy policy) {
+  Clear();
+  fingerprint_ = fingerprint;
+  word_count_ = word_count;
+  hard_mode_ = hard_mode;
+  policy_ = policy;
+}
+
+void DecisionTree::Clear() {
+  fingerprint_ = 0;
+  word_count_ = 0;
+  hard_mode_ = false;
+  policy_ = Policy::kGreedy;
+  guesses_.clear();
+  entropies_.clear();
+  child_base_.clear();
+  children_.clear();
+}
+
+uint32_t DecisionTree::AddNode(size_t guess_index, double entropy) {
+  uint32_t node = static_cast<uint32_t>(guesses_.size());
+  guesses_.push_back(static_cast<uint32_t>(guess_index));
+  entropies_.push_back(entropy);
+  child_base_.push_back(kNoNode);
+  return node;
+}
+
+void DecisionTree::SetChild(uint32_t node, int pattern, uint32_t child) {
+  if (child_base_[node] == kNoNode) {
+    child_base_[node] = static_cast<uint32_t>(children_.size());
+    children_.resize(children_.size() + kPatternSlots, kNoNode);
+  }
+  children_[child_base_[node] + static_cast<uint32_t>(pattern)] = child;
+}
+
+bool DecisionTree::Write(std::ostream& out) const {
+  DecisionTreeHeader header{};
+  std::memcpy(header.magic, kDecisionTreeMagic, sizeof(header.magic));
+  header.version = kFormatVersion;
+  header.pattern_slots = kPatternSlots;
+  header.flags = (hard_mode_ ? 1U : 0U) |
+                 (static_cast<uint32_t>(policy_) << 8);
+  header.word_count = word_count_;
+  header.fingerprint = fingerprint_;
+  header.node_count = guesses_.size();
+  header.child_count = children_.size();
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return WriteArray(out, guesses_) && WriteArray(out, entropies_) &&
+         WriteArray(out, child_base_) && WriteArray(out, children_);
+}
+
+bool DecisionTree::Read(std::istream& in) {
+  Clear();
+  DecisionTreeHeader header{};
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in ||
+      std::memcmp(header.magic, kDecisionTreeMagic, sizeof(header.magic)) !=
+          0 ||
+      header.version != kFormatVersion ||
+      header.pattern_slots != kPatternSlots ||
+      (header.flags & ~0xFF01U) != 0 ||
+      (header.flags >> 8) > static_cast<uint32_t>(Policy::kMinWorstCase) ||
+      header.node_count >= kNoNode || header.child_count >= kNoNode ||
+      header.child_count % kPatternSlots != 0) {
+    return false;
+  }
+  const size_t nodes = static_cast<size_t>(header.node_count);
+  const size_t child_count = static_cast<size_t>(header.child_count);
+  if (!ReadArray(in, nodes, &guesses_) ||
+      !ReadArray(in, nodes, &entropies_) ||
+      !ReadArray(in, nodes, &child_base_) ||
+      !ReadArray(in, child_count, &children_)) {
+    Clear();
+    return false;
+  }
+  for (size_t i = 0; i < nodes; ++i) {
+    if (guesses_[i] >= header.word_count ||
+        (child_base_[i] != kNoNode &&
+         (child_base_[i] % kPatternSlots != 0 ||
+          child_base_[i] >= child_count))) {
+      Clear();
+      return false;
+    }
+  }
+  for (uint32_t child : children_) {
+    if (child != kNoNode && child >= nodes) {
+      Clear();
+      return false;
+    }
+  }
+  fingerprint_ = header.fingerprint;
+  word_count_ = header.word_count;
+  hard_mode_ = (header.flags & 1U) != 0;
+  policy_ = static_cast<Policy>(header.flags >> 8);
+  return true;
+}
+
+bool DecisionTree::Save(const std::string& path) const {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  return out && Write(out);
+}
+
+bool DecisionTree::Load(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return in && Read(in);
+}
+
+GuessCache::Key GuessCache::MakeKey(const std::vector<size_t>& candidates,
+                                    const std::vector<size_t>& targets,
+                                    uint64_t salt) {
+  // Two independent 64-bit hashes; the lengths keep the two lists apart.
+  Key key{1469598103934665603ULL ^ salt, Mix64(salt + 0x9E3779B97F4A7C15ULL)};
+  auto add = [&key](uint64_t value) {
+    key.hi = (key.hi ^ value) * 1099511628211ULL;
+    key.lo = Mix64(key.lo ^ (value + 0x9E3779B97F4A7C15ULL));
+  };
+  add(candidates.size());
+  for (size_t index : candidates) {
+    add(index);
+  }
+  add(targets.size());
+  for (size_t index : targets) {
+    add(index);
+  }
+  key.hi = Mix64(key.hi);
+  return key;
+}
+
+void GuessCache::SetCapacity(size_t capacity) {
+  Clear();
+  capacity_ = capacity;
+  shard_capacity_ = (capacity + kShardCount - 1) / kShardCount;
+}
+
+bool GuessCache::Find(const Key& key, Entry* out) {
+  if (capacity_ == 0) {
+    return false;
+  }
+  Shard& shard = ShardFor(key);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+      *out = it->second->second;
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void GuessCache::Store(const Key& key, const Entry& entry) {
+  if (capacity_ == 0) {
+    return;
+  }
+  Shard& shard = ShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    it->second->second = entry;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return;
+  }
+  if (shard.lru.size() >= shard_capacity_) {
+    shard.index.erase(shard.lru.back().first);
+    shard.lru.pop_back();
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+  shard.lru.emplace_front(key, entry);
+  shard.index.emplace(key, shard.lru.begin());
+}
+
+void GuessCache::Clear() {
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.lru.clear();
+    shard.index.clear();
+  }
+  hits_.store(0, std::memory_order_relaxed);
+  misses_.store(0, std::memory_order_relaxed);
+  evictions_.store(0, std::memory_order_relaxed);
+}
+
+GuessCache::Stats GuessCache::stats() const {
+  Stats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.evictions = evictions_.load(std::memory_order_relaxed);
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    stats.size += shard.lru.size();
+  }
+  return stats;
+}
+
+bool GuessCache::Save(const std::string& path,
+                      uint64_t fingerprint,
+                      size_t word_count) const {
+  // Least recently used first, so that loading replays the recency order.
+  std::vector<GuessCacheRecord> records;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto it = shard.lru.rbegin(); it != shard.lru.rend(); ++it) {
+      records.push_back(GuessCacheRecord{it->first.hi, it->first.lo,
+                                         it->second.guess, 0,
+                                         it->second.entropy});
+    }
+  }
+  GuessCacheHeader header{};
+  std::memcpy(header.magic, kGuessCacheMagic, sizeof(header.magic));
+  header.version = kFormatVersion;
+  header.word_count = word_count;
+  header.fingerprint = fingerprint;
+  header.entry_count = records.size();
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return WriteArray(out, records);
+}
+
+bool GuessCache::Load(const std::string& path,
+                      uint64_t fingerprint,
+                      size_t word_count) {
+  std::ifstream in(path, std::ios::binary);
+  GuessCacheHeader header{};
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in ||
+      std::memcmp(header.magic, kGuessCacheMagic, sizeof(header.magic)) !=
+          0 ||
+      header.version != kFormatVersion || header.word_count != word_count ||
+      header.fingerprint != fingerprint) {
+    return false;
+  }
+  std::vector<GuessCacheRecord> records;
+  if (!ReadArray(in, static_cast<size_t>(header.entry_count), &records)) {
+    return false;
+  }
+  for (const GuessCacheRecord& record : records) {
+    if (record.guess >= word_count) {
+      return false;
+    }
+  }
+  for (const GuessCacheRecord& record : records) {
+    Store(Key{record.hi, record.lo}, Entry{record.guess, record.entropy});
+  }
+  return true;
+}
+
+void PatternMatrix::Build(const WordTable& words) {
+  Clear();
+  const size_t n = words.size();
+  if (n == 0) {
+    return;
+  }
+  storage_.resize(n * n);
+  uint8_t* data = storage_.data();
+  const uint32_t* letters = words.letters();
+  ThreadPool::Instance().ParallelFor(0, n, 16, [&](size_t g) {
+    WordleSolver::PatternBatch(words.packed(g), letters, n, data + g * n);
+  });
+  data_ = storage_.data();
+  size_ = n;
+}
+
+bool PatternMatrix::Save(const std::string& path, uint64_t fingerprint) const {
+  if (empty()) {
+    return false;
+  }
+  std::string temp_path = path + ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return false;
+    }
+    PatternMatrixHeader header{};
+    std::memcpy(header.magic, kPatternMatrixMagic, sizeof(header.magic));
+    header.version = kFormatVersion;
+    header.size = size_;
+    header.fingerprint = fingerprint;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(data_),
+              static_cast<std::streamsize>(size_ * size_));
+    if (!out) {
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+  return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+bool PatternMatrix::Load(const std::string& path,
+                         size_t size,
+                         uint64_t fingerprint) {
+  Clear();
+  if (size == 0) {
+    return false;
+  }
+  const size_t payload = size * size;
+  const size_t total = sizeof(PatternMatrixHeader) + payload;
+
+  std::ifstream infile(path, std::ios::binary);
+  if (!infile) {
+    return false;
+  }
+  PatternMatrixHeader header{};
+  infile.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!infile ||
+      std::memcmp(header.magic, kPatternMatrixMagic, sizeof(header.magic)) !=
+          0 ||
+      header.version != kFormatVersion || header.size != size ||
+      header.fingerprint != fingerprint) {
+    return false;
+  }
+
+#if defined(ALETHEIA_HAS_MMAP)
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) != total) {
+    ::close(fd);
+    return false;
+  }
+  void* base = ::mmap(nullptr, total, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+  mapping_ = base;
+  mapping_bytes_ = total;
+  data_ = static_cast<const uint8_t*>(base) + sizeof(PatternMatrixHeader);
+  size_ = size;
+  return true;
+#else
+  storage_.resize(payload);
+  infile.read(reinterpret_cast<char*>(storage_.data()),
+              static_cast<std::streamsize>(payload));
+  if (!infile || infile.peek() != std::char_traits<char>::eof()) {
+    storage_.clear();
+    return false;
+  }
+  (void)total;
+  data_ = storage_.data();
+  size_ = size;
+  return true;
+#endif
+}
+
+void PatternMatrix::Clear() {
+#if defined(ALETHEIA_HAS_MMAP)
+  if (mapping_) {
+    ::munmap(mapping_, mapping_bytes_);
+  }
+#endif
+  mapping_ = nullptr;
+  mapping_bytes_ = 0;
+  storage_.clear();
+  storage_.shrink_to_fit();
+  data_ = nullptr;
+  size_ = 0;
+}
+
+void SetSimdEnabled(bool enabled) {
+  g_simd_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool SimdEnabled() { return g_simd_enabled.load(std::memory_order_relaxed); }
+
+bool WordleSolver::LoadDictionary(const std::string& path) {
+  std::ifstream infile(path);
+  if (!infile) {
+    return false;
+  }
+  std::vector<std::string> words;
+  std::string line;
+  while (std::getline(infile, line)) {
+    words.push_back(line);
+  }
+  SetWordList(words);
+  return !words_.empty();
+}
+
+void WordleSolver::SetWordList(const std::vector<std::string>& words) {
+  words_.Clear();
+  word_storage_.clear();
+  decision_tree_.Clear();
+
+#if defined(ALETHEIA_USE_WORD_POOL)
+  size_t total_bytes = 0;
+  for (const auto& word : words) {
+    total_bytes += word.size() + 1;
+  }
+  word_pool_.Reset(total_bytes);
+
+  words_.Reserve(words.size());
+  for (const auto& word : words) {
+    std::string normalized = NormalizeWord(word);
+    if (!IsValidWord(normalized)) {
+      continue;
+    }
+    std::string_view stored = word_pool_.Store(normalized);
+    if (stored.empty()) {
+      continue;
+    }
+    words_.PushBack(EncodeWord(stored), stored);
+  }
+#else
+  words_.Reserve(words.size());
+  word_storage_.reserve(words.size());
+  for (const auto& word : words) {
+    std::string normalized = NormalizeWord(word);
+    if (!IsValidWord(normalized)) {
+      continue;
+    }
+    word_storage_.push_back(std::move(normalized));
+    words_.PushBack(EncodeWord(word_storage_.back()), word_storage_.back());
+  }
+#endif
+
+  index_by_letters_.clear();
+  index_by_letters_.reserve(words_.size());
+  for (size_t i = 0; i < words_.size(); ++i) {
+    index_by_letters_.emplace(words_.letters()[i], i);
+  }
+  all_indices_.resize(words_.size());
+  std::iota(all_indices_.begin(), all_indices_.end(), 0);
+
+  pattern_bitmaps_.clear();
+  guess_cache_.Clear();
+  pattern_matrix_.Clear();
+  if (use_pattern_matrix_) {
+    RebuildPatternMatrix();
+  }
+}
+
+const WordTable& WordleSolver::words() const { return words_; }
+
+size_t WordleSolver::IndexOf(std::string_view word) const {
+  if (!IsValidWord(word)) {
+    return kNoIndex;
+  }
+  auto it = index_by_letters_.find(EncodeWord(word).letters);
+  return it == index_by_letters_.end() ? kNoIndex : it->second;
+}
+
+void WordleSolver::EnablePatternMatrix(const std::string& cache_path) {
+  use_pattern_matrix_ = true;
+  pattern_cache_path_ = cache_path;
+  if (!words_.empty()) {
+    RebuildPatternMatrix();
+  }
+}
+
+uint64_t WordleSolver::DictionaryFingerprint() const {
+  uint64_t hash = 1469598103934665603ULL;
+  for (size_t i = 0; i < words_.size(); ++i) {
+    uint32_t letters = words_.letters()[i];
+    for (int byte = 0; byte < 4; ++byte) {
+      hash ^= static_cast<uint64_t>((letters >> (byte * 8)) & 0xFF);
+      hash *= 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+void WordleSolver::RebuildPatternMatrix() {
+  if (words_.empty()) {
+    pattern_matrix_.Clear();
+    return;
+  }
+  const uint64_t fingerprint = DictionaryFingerprint();
+  if (!pattern_cache_path_.empty() &&
+      pattern_matrix_.Load(pattern_cache_path_, words_.size(), fingerprint)) {
+    return;
+  }
+  pattern_matrix_.Build(words_);
+  if (!pattern_cache_path_.empty()) {
+    pattern_matrix_.Save(pattern_cache_path_, fingerprint);
+  }
+}
+
+int WordleSolver::PatternAt(size_t guess_index, size_t target_index) const {
+  if (!pattern_matrix_.empty()) {
+    return pattern_matrix_.At(guess_index, target_index);
+  }
+  return Pattern(words_.packed(guess_index), words_.packed(target_index));
+}
+
+bool WordleSolver::IsValidWord(std::string_view word) {
+  if (word.size() != kWordLen) {
+    return false;
+  }
+  for (char c : word) {
+    if (c < 'a' || c > 'z') {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string WordleSolver::NormalizeWord(std::string_view word) {
+  std::string normalized;
+  normalized.reserve(word.size());
+  for (char c : word) {
+    if (c >= 'A' && c <= 'Z') {
+      normalized.push_back(static_cast<char>(c - 'A' + 'a'));
+    } else if (c >= 'a' && c <= 'z') {
+      normalized.push_back(c);
+    }
+  }
+  return normalized;
+}
+
+PackedWord WordleSolver::EncodeWord(std::string_view word) {
+  PackedWord packed;
+  for (int i = 0; i < kWordLen; ++i) {
+    uint32_t letter = static_cast<uint32_t>(word[i] - 'a');
+    packed.letters |= (letter & kLetterMask) << (i * kLetterBits);
+    packed.mask |= 1U << letter;
+  }
+  return packed;
+}
+
+template <int kLength, int kAlphabetSize>
+int WordShape<kLength, kAlphabetSize>::Pattern(const Packed& guess,
+                                               const Packed& target) {
+  std::array<uint8_t, kLength> guess_letters{};
+  std::array<uint8_t, kLength> target_letters{};
+  for (int i = 0; i < kLength; ++i) {
+    guess_letters[i] = static_cast<uint8_t>(LetterAt(guess.letters, i));
+    target_letters[i] = static_cast<uint8_t>(LetterAt(target.letters, i));
+  }
+
+  std::array<int, kAlphabetSize> counts{};
+  counts.fill(0);
+  for (int i = 0; i < kLength; ++i) {
+    counts[target_letters[i]]++;
+  }
+
+  std::array<int, kLength> result{};
+  result.fill(0);
+  for (int i = 0; i < kLength; ++i) {
+    if (guess_letters[i] == target_letters[i]) {
+      result[i] = 2;
+      counts[guess_letters[i]]--;
+    }
+  }
+
+  const LetterMask target_mask = target.mask;
+  for (int i = 0; i < kLength; ++i) {
+    if (result[i] != 0) {
+      continue;
+    }
+    uint8_t letter = guess_letters[i];
+    if ((target_mask & (LetterMask{1} << letter)) == 0) {
+      continue;
+    }
+    if (counts[letter] > 0) {
+      result[i] = 1;
+      counts[letter]--;
+    }
+  }
+
+  int pattern = 0;
+  int base = 1;
+  for (int i = 0; i < kLength; ++i) {
+    pattern += result[i] * base;
+    base *= 3;
+  }
+  return pattern;
+}
+
+template <int kLength, int kAlphabetSize>
+void WordShape<kLength, kAlphabetSize>::PatternBatch(
+    const Packed& guess,
+    const Letters* target_letters,
+    size_t count,
+    PatternCode* out) {
+  // Branch-free form of Pattern(): a non-green tile is yellow iff fewer
+  // earlier non-green tiles share its letter than the target has copies of
+  // that letter outside positions where the guess repeats it.
+  constexpr Letters kLetterMask = (Letters{1} << kLetterBits) - 1;
+  constexpr std::array<Letters, kLength> kPow3 = [] {
+    std::array<Letters, kLength> pow3{};
+    Letters value = 1;
+    for (int i = 0; i < kLength; ++i) {
+      pow3[i] = value;
+      value *= 3;
+    }
+    return pow3;
+  }();
+  std::array<Letters, kLength> guess_letters{};
+  for (int i = 0; i < kLength; ++i) {
+    guess_letters[i] = LetterAt(guess.letters, i);
+  }
+
+  size_t offset = 0;
+#if defined(ALETHEIA_USE_HWY)
+  if (SimdEnabled()) {
+    namespace hn = hwy::HWY_NAMESPACE;
+    const hn::ScalableTag<Letters> d;
+    const size_t lanes = hn::Lanes(d);
+    HWY_ALIGN Letters codes[HWY_MAX_BYTES / sizeof(Letters)];
+    const auto letter_mask = hn::Set(d, kLetterMask);
+    const auto one = hn::Set(d, Letters{1});
+    for (; offset + lanes <= count; offset += lanes) {
+      const auto packed = hn::LoadU(d, target_letters + offset);
+      // Scalable vectors cannot live in arrays, so per-position letters and
+      // green masks are recomputed; fixed-width targets fold the repeats.
+      auto letter_at = [&](int k) {
+        return hn::And(hn::ShiftRightSame(packed, k * kLetterBits),
+                       letter_mask);
+      };
+      auto green_at = [&](int k) {
+        return hn::Eq(letter_at(k), hn::Set(d, guess_letters[k]));
+      };
+      auto code = hn::Zero(d);
+      for (int i = 0; i < kLength; ++i) {
+        const auto letter = hn::Set(d, guess_letters[i]);
+        auto available = hn::Zero(d);
+        auto prior = hn::Zero(d);
+        for (int k = 0; k < kLength; ++k) {
+          if (guess_letters[k] != guess_letters[i]) {
+            const auto match = hn::Eq(letter_at(k), letter);
+            available = hn::Add(available, hn::IfThenElseZero(match, one));
+          } else if (k < i) {
+            prior = hn::Add(prior, hn::IfThenZeroElse(green_at(k), one));
+          }
+        }
+        const auto green = green_at(i);
+        const auto yellow = hn::AndNot(green, hn::Lt(prior, available));
+        code = hn::Add(code,
+                       hn::IfThenElseZero(green, hn::Set(d, 2 * kPow3[i])));
+        code = hn::Add(code, hn::IfThenElseZero(yellow, hn::Set(d, kPow3[i])));
+      }
+      hn::Store(code, d, codes);
+      for (size_t lane = 0; lane < lanes; ++lane) {
+        out[offset + lane] = static_cast<PatternCode>(codes[lane]);
+      }
+    }
+  }
+#endif
+
+  for (; offset < count; ++offset) {
+    const Letters packed = target_letters[offset];
+    std::array<Letters, kLength> letters{};
+    std::array<uint32_t, kLength> green{};
+    for (int k = 0; k < kLength; ++k) {
+      letters[k] = (packed >> (k * kLetterBits)) & kLetterMask;
+      green[k] = letters[k] == guess_letters[k];
+    }
+    uint32_t code = 0;
+    for (int i = 0; i < kLength; ++i) {
+      uint32_t available = 0;
+      uint32_t prior = 0;
+      for (int k = 0; k < kLength; ++k) {
+        if (guess_letters[k] != guess_letters[i]) {
+          available += letters[k] == guess_letters[i];
+        } else if (k < i) {
+          prior += green[k] ^ 1U;
+        }
+      }
+      const uint32_t yellow = (green[i] ^ 1U) & (prior < available);
+      code += (2 * green[i] + yellow) * static_cast<uint32_t>(kPow3[i]);
+    }
+    out[offset] = static_cast<PatternCode>(code);
+  }
+}
+
+template <int kLength, int kAlphabetSize>
+std::string WordShape<kLength, kAlphabetSize>::PatternString(int pattern) {
+  std::string out(kLength, '0');
+  for (int i = 0; i < kLength; ++i) {
+    out[i] = static_cast<char>('0' + (pattern % 3));
+    pattern /= 3;
+  }
+  return out;
+}
+
+template <int kLength, int kAlphabetSize>
+int WordShape<kLength, kAlphabetSize>::ParsePattern(std::string_view pattern) {
+  if (pattern.size() != static_cast<size_t>(kLength)) {
+    return -1;
+  }
+  int value = 0;
+  int base = 1;
+  for (char c : pattern) {
+    if (c < '0' || c > '2') {
+      return -1;
+    }
+    value += (c - '0') * base;
+    base *= 3;
+  }
+  return value;
+}
+
+template struct WordShape<4>;
+template struct WordShape<5>;
+template struct WordShape<6>;
+template struct WordShape<7>;
+template struct WordShape<8>;
+
+bool WordleSolver::IsConsistent(std::string_view candidate,
+                                std::string_view guess,
+                                std::string_view pattern) {
+  if (candidate.size() != kWordLen || guess.size() != kWordLen ||
+      pattern.size() != kWordLen) {
+    return false;
+  }
+
+  std::array<int, kAlphabet> target_counts{};
+  target_counts.fill(0);
+
+  for (int i = 0; i < kWordLen; ++i) {
+    char p = pattern[i];
+    if (p == '2') {
+      if (candidate[i] != guess[i]) {
+        return false;
+      }
+    } else if (p == '0' || p == '1') {
+      char c = candidate[i];
+      if (c < 'a' || c > 'z') {
+        return false;
+      }
+      target_counts[c - 'a']++;
+    } else {
+      return false;
+    }
+  }
+
+  for (int i = 0; i < kWordLen; ++i) {
+    char p = pattern[i];
+    if (p == '2') {
+      continue;
+    }
+    char g = guess[i];
+    if (g < 'a' || g > 'z') {
+      return false;
+    }
+    int letter_index = g - 'a';
+    if (p == '1') {
+      if (candidate[i] == g) {
+        return false;
+      }
+      if (target_counts[letter_index] > 0) {
+        target_counts[letter_index]--;
+      } else {
+        return false;
+      }
+    } else {
+      if (candidate[i] == g || target_counts[letter_index] > 0) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void WordleSolver::FilterCandidates(const WordTable& words,
+                                    const std::vector<size_t>& remaining,
+                                    std::string_view guess,
+                                    std::string_view pattern,
+                                    std::vector<size_t>* out) {
+  if (!out) {
+    return;
+  }
+  out->clear();
+  if (guess.size() != kWordLen || pattern.size() != kWordLen) {
+    return;
+  }
+
+  uint32_t green_mask = 0;
+  for (int i = 0; i < kWordLen; ++i) {
+    if (pattern[i] == '2') {
+      green_mask |= kLetterMask << (i * kLetterBits);
+    }
+  }
+
+  if (remaining.empty()) {
+    return;
+  }
+
+#if defined(ALETHEIA_USE_HWY)
+  if (green_mask != 0 && SimdEnabled()) {
+    namespace hn = hwy::HWY_NAMESPACE;
+
+    const PackedWord guess_packed = EncodeWord(guess);
+    const uint32_t green_bits = guess_packed.letters & green_mask;
+
+    const hn::ScalableTag<uint32_t> d;
+    const size_t lanes = hn::Lanes(d);
+    if (lanes > 1) {
+      const uint32_t* letters = words.letters();
+      HWY_ALIGN uint32_t packed[HWY_MAX_BYTES / sizeof(uint32_t)];
+      HWY_ALIGN uint32_t pass[HWY_MAX_BYTES / sizeof(uint32_t)];
+      const auto green_mask_vec = hn::Set(d, green_mask);
+      const auto green_bits_vec = hn::Set(d, green_bits);
+
+      for (size_t offset = 0; offset < remaining.size(); offset += lanes) {
+        const size_t count = std::min(lanes, remaining.size() - offset);
+        const size_t* batch = remaining.data() + offset;
+        // Runs of consecutive indices (the full dictionary, early turns)
+        // load straight from the word table; sparse sets gather.
+        bool contiguous = count == lanes;
+        for (size_t lane = 1; contiguous && lane < lanes; ++lane) {
+          contiguous = batch[lane] == batch[0] + lane;
+        }
+        const uint32_t* source = letters + batch[0];
+        if (!contiguous) {
+          for (size_t lane = 0; lane < count; ++lane) {
+            packed[lane] = letters[batch[lane]];
+          }
+          for (size_t lane = count; lane < lanes; ++lane) {
+            packed[lane] = 0;
+          }
+          source = packed;
+        }
+
+        auto v = hn::LoadU(d, source);
+        auto cmp = hn::Eq(hn::And(v, green_mask_vec), green_bits_vec);
+        hn::Store(hn::IfThenElseZero(cmp, hn::Set(d, 1u)), d, pass);
+
+        for (size_t lane = 0; lane < count; ++lane) {
+          if (pass[lane] != 0 &&
+              IsConsistent(words.text(batch[lane]), guess, pattern)) {
+            out->push_back(batch[lane]);
+          }
+        }
+      }
+      return;
+    }
+  }
+#endif
+
+  for (size_t index : remaining) {
+    if (IsConsistent(words.text(index), guess, pattern)) {
+      out->push_back(index);
+    }
+  }
+}
+
+void WordleSolver::FilterCandidates(const std::vector<size_t>& remaining,
+                                    std::string_view guess,
+                                    std::string_view pattern,
+                                    std::vector<size_t>* out) const {
+  if (!out) {
+    return;
+  }
+  const size_t guess_index =
+      pattern_matrix_.empty() ? kNoIndex : IndexOf(guess);
+  const int pattern_value = ParsePattern(pattern);
+  if (guess_index == kNoIndex || pattern_value < 0) {
+    FilterCandidates(words_, remaining, guess, pattern, out);
+    return;
+  }
+  out->clear();
+  const uint8_t* row = pattern_matrix_.Row(guess_index);
+  const uint8_t code = static_cast<uint8_t>(pattern_value);
+  for (size_t index : remaining) {
+    if (row[index] == code) {
+      out->push_back(index);
+    }
+  }
+}
+
+void WordleSolver::PrecomputePatternBitmaps(
+    const std::vector<size_t>& guesses) {
+  std::vector<uint8_t> row(words_.size());
+  for (size_t guess_index : guesses) {
+    if (guess_index >= words_.size() ||
+        pattern_bitmaps_.count(guess_index) > 0) {
+      continue;
+    }
+    const uint8_t* codes = row.data();
+    if (!pattern_matrix_.empty()) {
+      codes = pattern_matrix_.Row(guess_index);
+    } else {
+      PatternBatch(words_.packed(guess_index), words_.letters(), words_.size(),
+                   row.data());
+    }
+    GuessBitmaps bitmaps;
+    bitmaps.slot.fill(-1);
+    for (size_t target = 0; target < words_.size(); ++target) {
+      int16_t& slot = bitmaps.slot[codes[target]];
+      if (slot < 0) {
+        slot = static_cast<int16_t>(bitmaps.sets.size());
+        bitmaps.sets.emplace_back(words_.size());
+      }
+      bitmaps.sets[slot].Insert(target);
+    }
+    pattern_bitmaps_.emplace(guess_index, std::move(bitmaps));
+  }
+}
+
+bool WordleSolver::HasPatternBitmaps(size_t guess_index) const {
+  return pattern_bitmaps_.count(guess_index) > 0;
+}
+
+void WordleSolver::FilterCandidates(const CandidateSet& remaining,
+                                    size_t guess_index,
+                                    int pattern,
+                                    CandidateSet* out) const {
+  if (!out) {
+    return;
+  }
+  out->Reset(remaining.universe());
+  if (guess_index >= words_.size() || pattern < 0 ||
+      pattern >= kPatternCount) {
+    return;
+  }
+  auto it = pattern_bitmaps_.find(guess_index);
+  if (it != pattern_bitmaps_.end()) {
+    int16_t slot = it->second.slot[pattern];
+    if (slot >= 0) {
+      *out = remaining;
+      out->IntersectWith(it->second.sets[slot]);
+    }
+    return;
+  }
+  remaining.ForEach([&](size_t index) {
+    if (PatternAt(guess_index, index) == pattern) {
+      out->Insert(index);
+    }
+  });
+}
+
+void WordleSolver::FilterCandidates(const CandidateSet& remaining,
+                                    std::string_view guess,
+                                    std::string_view pattern,
+                                    CandidateSet* out) const {
+  if (!out) {
+    return;
+  }
+  const size_t guess_index = IndexOf(guess);
+  const int pattern_value = ParsePattern(pattern);
+  if (guess_index != kNoIndex && pattern_value >= 0) {
+    FilterCandidates(remaining, guess_index, pattern_value, out);
+    return;
+  }
+  out->Reset(remaining.universe());
+  if (pattern_value < 0 || !IsValidWord(guess)) {
+    return;
+  }
+  const PackedWord guess_packed = EncodeWord(guess);
+  remaining.ForEach([&](size_t index) {
+    if (Pattern(guess_packed, words_.packed(index)) == pattern_value) {
+      out->Insert(index);
+    }
+  });
+}
+
+void WordleSolver::RestrictHardModePool(const HintConstraints& hints,
+                                        CandidateSet* pool) const {
+  if (!pool) {
+    return;
+  }
+  if (pool->universe() != words_.size()) {
+    *pool = CandidateSet::All(words_.size());
+  }
+  if (hints.empty()) {
+    return;
+  }
+  const uint32_t* letters = words_.letters();
+  const uint32_t* masks = words_.masks();
+  // ForEach snapshots each block before visiting it, so erasing the
+  // current member is safe.
+  pool->ForEach([&](size_t index) {
+    if (!hints.AllowsGuess({letters[index], masks[index]})) {
+      pool->Erase(index);
+    }
+  });
+}
+
+GameSession::GameSession(const WordleSolver& solver, bool hard_mode)
+    : solver_(&solver), hard_mode_(hard_mode) {
+  Reset();
+}
+
+void GameSession::Reset() {
+  const size_t universe = solver_->words().size();
+  turns_ = 0;
+  hints_.Reset();
+  remaining_set_ = CandidateSet::All(universe);
+  remaining_.clear();
+  hard_pool_.Reset(0);
+  hard_pool_indices_.clear();
+  book_node_ = solver_->decision_tree().root();
+}
+
+void GameSession::SetHardMode(bool hard_mode) {
+  if (hard_mode == hard_mode_) {
+    return;
+  }
+  hard_mode_ = hard_mode;
+  hard_pool_.Reset(0);
+  hard_pool_indices_.clear();
+  if (hard_mode_ && !hints_.empty()) {
+    solver_->RestrictHardModePool(hints_, &hard_pool_);
+    hard_pool_.ToIndices(&hard_pool_indices_);
+  }
+}
+
+bool GameSession::ApplyFeedback(std::string_view guess,
+                                std::string_view pattern) {
+  const std::string word = WordleSolver::NormalizeWord(guess);
+  const int code = WordleSolver::ParsePattern(pattern);
+  if (!WordleSolver::IsValidWord(word) || code < 0) {
+    return false;
+  }
+  solver_->FilterCandidates(remaining_set_, word, pattern, &next_set_);
+  if (next_set_.Empty()) {
+    return false;
+  }
+  std::swap(remaining_set_, next_set_);
+  remaining_set_.ToIndices(&remaining_);
+  hints_.Add(word, pattern);
+  if (hard_mode_) {
+    solver_->RestrictHardModePool(hints_, &hard_pool_);
+    hard_pool_.ToIndices(&hard_pool_indices_);
+  }
+  const DecisionTree& book = solver_->decision_tree();
+  if (book_node_ != DecisionTree::kNoNode &&
+      solver_->IndexOf(word) == book.Guess(book_node_)) {
+    book_node_ = book.Child(book_node_, code);
+  } else {
+    book_node_ = DecisionTree::kNoNode;
+  }
+  ++turns_;
+  return true;
+}
+
+bool GameSession::AllowsGuess(std::string_view guess) const {
+  const std::string word = WordleSolver::NormalizeWord(guess);
+  if (!WordleSolver::IsValidWord(word)) {
+    return false;
+  }
+  return !hard_mode_ || hints_.AllowsGuess(WordleSolver::EncodeWord(word));
+}
+
+bool GameSession::IsCandidate(std::string_view guess) const {
+  return remaining_set_.Contains(solver_->IndexOf(guess));
+}
+
+bool GameSession::DirectSuggestion(std::string* guess,
+                                   double* entropy_out) const {
+  if (entropy_out) {
+    *entropy_out = 0.0;
+  }
+  if (remaining_set_.Empty()) {
+    guess->clear();
+    return true;
+  }
+  if (book_node_ != DecisionTree::kNoNode &&
+      solver_->HasDecisionTree(hard_mode_)) {
+    const DecisionTree& book = solver_->decision_tree();
+    if (entropy_out) {
+      *entropy_out = book.Entropy(book_node_);
+    }
+    *guess = std::string(solver_->words().text(book.Guess(book_node_)));
+    return true;
+  }
+  // Every guess scores zero against a lone word, and a hard-mode pool may
+  // list other legal words first.
+  if (turns_ > 0 && remaining_.size() == 1) {
+    *guess = std::string(solver_->words().text(remaining_[0]));
+    return true;
+  }
+  return false;
+}
+
+std::string GameSession::Suggest(double* entropy_out,
+                                 WordleSolver::SearchStats* stats) const {
+  std::string guess;
+  if (DirectSuggestion(&guess, entropy_out)) {
+    return guess;
+  }
+  return solver_->BestGuess(guess_pool(), remaining(), entropy_out, stats,
+                            hard_mode_);
+}
+
+std::string GameSession::SuggestWithin(std::chrono::microseconds budget,
+                                       double* entropy_out,
+                                       bool* exact_out,
+                                       WordleSolver::SearchStats* stats) const {
+  WordleSolver::SearchLimits limits;
+  limits.deadline = std::chrono::steady_clock::now() + budget;
+  limits.warm_up = true;
+  return SuggestWithin(limits, entropy_out, exact_out, stats);
+}
+
+std::string GameSession::SuggestWithin(const WordleSolver::SearchLimits& limits,
+                                       double* entropy_out,
+                                       bool* exact_out,
+                                       WordleSolver::SearchStats* stats) const {
+  if (exact_out) {
+    *exact_out = true;
+  }
+  std::string guess;
+  if (DirectSuggestion(&guess, entropy_out)) {
+    return guess;
+  }
+  return solver_->BestGuessWithin(guess_pool(), remaining(), limits,
+                                  entropy_out, exact_out, stats, hard_mode_);
+}
+
+GuessFuture GameSession::SuggestAsync(std::chrono::microseconds budget) const {
+  GuessFuture::Result result;
+  if (DirectSuggestion(&result.guess, &result.entropy)) {
+    return GuessFuture::FromResult(std::move(result));
+  }
+  return solver_->BestGuessAsync(guess_pool(), remaining(), budget,
+                                 hard_mode_);
+}
+
+void SuggestionSpeculator::Start(const GameSession& session,
+                                 std::string_view guess,
+                                 size_t max_patterns,
+                                 std::chrono::microseconds budget) {
+  Cancel();
+  const WordleSolver& solver = session.solver();
+  const size_t guess_index = solver.IndexOf(guess);
+  if (guess_index == WordleSolver::kNoIndex || max_patterns == 0 ||
+      session.remaining().size() < 2) {
+    return;
+  }
+  const auto counts = solver.PatternCounts(guess_index, session.remaining());
+  const int solved = WordleSolver::kPatternCount - 1;
+  std::vector<int> patterns;
+  for (int pattern = 0; pattern < solved; ++pattern) {
+    if (counts[pattern] > 0) {
+      patterns.push_back(pattern);
+    }
+  }
+  std::stable_sort(patterns.begin(), patterns.end(),
+                   [&](int a, int b) { return counts[a] > counts[b]; });
+  patterns.resize(std::min(patterns.size(), max_patterns));
+
+  guess_ = std::string(guess);
+  shared_ = std::make_shared<Shared>();
+  token_ = CancelToken();
+  // Each follow-up is searched right here on the worker, with the token in
+  // its limits, so cancelling stops the search itself.
+  worker_ = std::thread([base = session, guess = guess_, patterns, budget,
+                         shared = shared_, token = token_] {
+    for (int pattern : patterns) {
+      if (token.cancelled()) {
+        return;
+      }
+      const auto started = std::chrono::steady_clock::now();
+      GameSession next = base;
+      if (!next.ApplyFeedback(guess, WordleSolver::PatternString(pattern))) {
+        continue;
+      }
+      WordleSolver::SearchLimits limits;
+      limits.cancel = &token;
+      if (budget != std::chrono::microseconds::max()) {
+        limits.deadline = started + budget;
+        limits.warm_up = true;
+      }
+      Outcome outcome;
+      GuessFuture::Result& result = outcome.result;
+      result.guess = next.SuggestWithin(limits, &result.entropy,
+                                        &result.exact, &result.stats);
+      if (token.cancelled()) {
+        return;
+      }
+      outcome.compute = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - started);
+      std::lock_guard<std::mutex> lock(shared->mutex);
+      shared->done.emplace(pattern, std::move(outcome));
+    }
+  });
+}
+
+bool SuggestionSpeculator::Take(std::string_view guess,
+                                std::string_view pattern,
+                                Outcome* out) {
+  bool found = false;
+  const int code = WordleSolver::ParsePattern(pattern);
+  if (shared_ && code >= 0 && guess == guess_) {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    auto it = shared_->done.find(code);
+    if (it != shared_->done.end()) {
+      *out = std::move(it->second);
+      found = true;
+    }
+  }
+  Cancel();
+  return found;
+}
+
+void SuggestionSpeculator::Wait() {
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void SuggestionSpeculator::Cancel() {
+  token_.Cancel();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+  shared_.reset();
+  guess_.clear();
+}
+
+std::vector<std::string> GameSession::SuggestBatch(
+    const std::vector<const GameSession*>& sessions,
+    std::vector<double>* entropies) {
+  std::vector<std::string> guesses(sessions.size());
+  std::vector<double> scores(sessions.size(), 0.0);
+  std::vector<bool> done(sessions.size(), false);
+  for (size_t i = 0; i < sessions.size(); ++i) {
+    done[i] = sessions[i]->DirectSuggestion(&guesses[i], &scores[i]);
+  }
+  // Group the searches by solver, mode and guess pool, in first-seen order.
+  for (size_t i = 0; i < sessions.size(); ++i) {
+    if (done[i]) {
+      continue;
+    }
+    const WordleSolver& solver = sessions[i]->solver();
+    const std::vector<size_t>& pool = sessions[i]->guess_pool();
+    std::vector<size_t> members;
+    std::vector<const std::vector<size_t>*> target_sets;
+    for (size_t j = i; j < sessions.size(); ++j) {
+      if (!done[j] && &sessions[j]->solver() == &solver &&
+          sessions[j]->hard_mode() == sessions[i]->hard_mode() &&
+          (&sessions[j]->guess_pool() == &pool ||
+           sessions[j]->guess_pool() == pool)) {
+        members.push_back(j);
+        target_sets.push_back(&sessions[j]->remaining());
+        done[j] = true;
+      }
+    }
+    std::vector<double> group_scores;
+    const std::vector<size_t> picks =
+        solver.BestGuessBatch(pool, target_sets, &group_scores,
+                              sessions[i]->hard_mode());
+    for (size_t m = 0; m < members.size(); ++m) {
+      if (picks[m] != WordleSolver::kNoIndex) {
+        guesses[members[m]] = std::string(solver.words().text(picks[m]));
+      }
+      scores[members[m]] = group_scores[m];
+    }
+  }
+  if (entropies) {
+    *entropies = std::move(scores);
+  }
+  return guesses;
+}
+
+std::vector<WordleSolver::ScoredGuess> GameSession::TopGuesses(
+    size_t k) const {
+  return solver_->TopGuesses(guess_pool(), remaining(), k);
+}
+
+void WordleSolver::FilterCandidates(const HintConstraints& hints,
+                                    std::vector<size_t>* out) const {
+  if (!out) {
+    return;
+  }
+  out->clear();
+  if (hints.contradictory()) {
+    return;
+  }
+  const uint32_t* letters = words_.letters();
+  const uint32_t* masks = words_.masks();
+  const size_t n = words_.size();
+  size_t index = 0;
+
+#if defined(ALETHEIA_USE_HWY)
+  if (SimdEnabled()) {
+    namespace hn = hwy::HWY_NAMESPACE;
+    const hn::ScalableTag<uint32_t> d;
+    const size_t lanes = hn::Lanes(d);
+    // Required/excluded letters and greens are rejected a vector at a time
+    // straight from the aligned table; the few survivors get the per-
+    // position bans and letter counts.
+    const auto required = hn::Set(d, hints.required());
+    const auto excluded = hn::Set(d, hints.excluded());
+    const auto fixed_mask = hn::Set(d, hints.fixed_mask());
+    const auto fixed_letters = hn::Set(d, hints.fixed_letters());
+    const auto zero = hn::Zero(d);
+    HWY_ALIGN uint32_t pass[HWY_MAX_BYTES / sizeof(uint32_t)];
+    for (; index + lanes <= n; index += lanes) {
+      const auto mask = hn::Load(d, masks + index);
+      const auto packed = hn::Load(d, letters + index);
+      const auto ok = hn::And(
+          hn::And(hn::Eq(hn::And(mask, required), required),
+                  hn::Eq(hn::And(mask, excluded), zero)),
+          hn::Eq(hn::And(packed, fixed_mask), fixed_letters));
+      if (hn::AllFalse(d, ok)) {
+        continue;
+      }
+      hn::Store(hn::IfThenElseZero(ok, hn::Set(d, 1u)), d, pass);
+      for (size_t lane = 0; lane < lanes; ++lane) {
+        if (pass[lane] != 0 &&
+            hints.Matches({letters[index + lane], masks[index + lane]})) {
+          out->push_back(index + lane);
+        }
+      }
+    }
+  }
+#endif
+
+  for (; index < n; ++index) {
+    if (hints.Matches({letters[index], masks[index]})) {
+      out->push_back(index);
+    }
+  }
+}
+
+DecisionTree WordleSolver::BuildDecisionTree(bool hard_mode,
+                                             size_t max_depth) const {
+  DecisionTree tree;
+  tree.Reset(DictionaryFingerprint(), words_.size(), hard_mode);
+  if (words_.empty() || max_depth == 0) {
+    return tree;
+  }
+  std::vector<size_t> all_indices(words_.size());
+  std::iota(all_indices.begin(), all_indices.end(), 0);
+  BuildTreeNode(all_indices, all_indices, hard_mode, 1, max_depth, &tree);
+  return tree;
+}
+
+uint32_t WordleSolver::BuildTreeNode(const std::vector<size_t>& remaining,
+                                     const std::vector<size_t>& all_indices,
+                                     bool hard_mode,
+                                     size_t depth,
+                                     size_t max_depth,
+                                     DecisionTree* tree) const {
+  double entropy = 0.0;
+  const size_t guess_index = ChooseGuessIndex(
+      hard_mode ? remaining : all_indices, remaining, hard_mode, &entropy);
+  const uint32_t node = tree->AddNode(guess_index, entropy);
+  if (depth >= max_depth) {
+    return node;
+  }
+
+  std::array<std::vector<size_t>, kPatternCount> buckets;
+  for (size_t index : remaining) {
+    buckets[PatternAt(guess_index, index)].push_back(index);
+  }
+  for (int pattern = 0; pattern < kPatternCount; ++pattern) {
+    if (pattern == kSolvedPattern || buckets[pattern].empty()) {
+      continue;
+    }
+    uint32_t child = BuildTreeNode(buckets[pattern], all_indices, hard_mode,
+                                   depth + 1, max_depth, tree);
+    tree->SetChild(node, pattern, child);
+  }
+  return node;
+}
+
+bool WordleSolver::LoadDecisionTree(const std::string& path) {
+  DecisionTree tree;
+  if (!tree.Load(path)) {
+    return false;
+  }
+  return SetDecisionTree(std::move(tree));
+}
+
+bool WordleSolver::SaveGuessCache(const std::string& path) const {
+  return guess_cache_.Save(path, DictionaryFingerprint(), words_.size());
+}
+
+bool WordleSolver::LoadGuessCache(const std::string& path) {
+  return guess_cache_.Load(path, DictionaryFingerprint(), words_.size());
+}
+
+bool WordleSolver::SetDecisionTree(DecisionTree tree) {
+  if (tree.word_count() != words_.size() ||
+      tree.fingerprint() != DictionaryFingerprint()) {
+    return false;
+  }
+  decision_tree_ = std::move(tree);
+  return true;
+}
+
+// Shared state of one optimal-policy search. Costs are total guesses over
+// the remaining targets (expected objective) or the most guesses any target
+// needs (worst case). The memo is keyed by remaining set and guesses left,
+// and records either the exact cost with its guess or a proven lower bound.
+struct WordleSolver::OptimalContext {
+  static constexpr int64_t kInfeasible = int64_t{1} << 40;
+  static constexpr size_t kShards = 64;
+
+  struct Entry {
+    std::vector<size_t> remaining;
+    size_t guesses_left = 0;
+    int64_t value = 0;
+    bool exact = false;
+    size_t guess = 0;
+  };
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_multimap<uint64_t, Entry> entries;
+  };
+
+  bool worst_case = false;
+  bool hard_mode = false;
+  size_t guess_limit = 0;
+  size_t max_guesses = 0;
+  std::vector<size_t> all_indices;
+  std::array<Shard, kShards> shards;
+  std::atomic<size_t> states{0};
+  std::atomic<size_t> memo_hits{0};
+  size_t total_guesses = 0;
+  size_t worst_guesses = 0;
+
+  static uint64_t Hash(const std::vector<size_t>& remaining,
+                       size_t guesses_left) {
+    uint64_t hash = 1469598103934665603ULL ^ guesses_left;
+    for (size_t index : remaining) {
+      hash ^= static_cast<uint64_t>(index);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  bool Find(const std::vector<size_t>& remaining,
+            size_t guesses_left,
+            Entry* out) {
+    const uint64_t hash = Hash(remaining, guesses_left);
+    Shard& shard = shards[hash % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto range = shard.entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second.guesses_left == guesses_left &&
+          it->second.remaining == remaining) {
+        out->value = it->second.value;
+        out->exact = it->second.exact;
+        out->guess = it->second.guess;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Store(const std::vector<size_t>& remaining,
+             size_t guesses_left,
+             int64_t value,
+             bool exact,
+             size_t guess) {
+    const uint64_t hash = Hash(remaining, guesses_left);
+    Shard& shard = shards[hash % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto range = shard.entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      Entry& entry = it->second;
+      if (entry.guesses_left == guesses_left && entry.remaining == remaining) {
+        if (!entry.exact && (exact || value > entry.value)) {
+          entry.value = value;
+          entry.exact = exact;
+          entry.guess = guess;
+        }
+        return;
+      }
+    }
+    Entry entry;
+    entry.remaining = remaining;
+    entry.guesses_left = guesses_left;
+    entry.value = value;
+    entry.exact = exact;
+    entry.guess = guess;
+    shard.entries.emplace(hash, std::move(entry));
+  }
+
+  // Cheapest conceivable cost of a set: one target guessed outright and
+  // every other one on the next guess.
+  int64_t LowerBound(size_t size, size_t guesses_left) const {
+    if (size == 0) {
+      return 0;
+    }
+    if (guesses_left == 0 || (size > 1 && guesses_left == 1) ||
+        (guesses_left == 2 && size > static_cast<size_t>(kPatternCount))) {
+      return kInfeasible;
+    }
+    if (size == 1) {
+      return 1;
+    }
+    return worst_case ? 2 : static_cast<int64_t>(2 * size - 1);
+  }
+};
+
+DecisionTree WordleSolver::BuildOptimalTree(const OptimalOptions& options,
+                                            OptimalStats* stats) const {
+  DecisionTree tree;
+  tree.Reset(DictionaryFingerprint(), words_.size(), options.hard_mode,
+             options.objective == DecisionTree::Policy::kMinWorstCase
+                 ? DecisionTree::Policy::kMinWorstCase
+                 : DecisionTree::Policy::kMinExpected);
+  if (stats) {
+    *stats = OptimalStats{};
+  }
+  if (words_.empty() || options.max_guesses == 0) {
+    return tree;
+  }
+
+  OptimalContext context;
+  context.worst_case =
+      options.objective == DecisionTree::Policy::kMinWorstCase;
+  context.hard_mode = options.hard_mode;
+  context.guess_limit = options.guess_limit;
+  context.max_guesses = options.max_guesses;
+  context.all_indices.resize(words_.size());
+  std::iota(context.all_indices.begin(), context.all_indices.end(), 0);
+  const std::vector<size_t>& all = context.all_indices;
+
+  const size_t guesses = context.worst_case
+                            ? OptimalWorstCaseRoot(&context, all,
+                                                   options.max_guesses)
+                            : OptimalExpectedRoot(&context, options.max_guesses);
+  if (guesses > 0) {
+    context.max_guesses = guesses;
+    OptimalTreeNode(&context, all, guesses, &tree);
+  }
+  if (stats) {
+    stats->feasible = !tree.empty();
+    stats->expected_guesses =
+        static_cast<double>(context.total_guesses) /
+        static_cast<double>(all.size());
+    stats->worst_case = context.worst_guesses;
+    stats->states = context.states.load();
+    stats->memo_hits = context.memo_hits.load();
+  }
+  return tree;
+}
+
+size_t WordleSolver::OptimalExpectedRoot(OptimalContext* context,
+                                         size_t max_guesses) const {
+  const std::vector<size_t>& all = context->all_indices;
+  if (all.size() <= 2) {
+    return context->LowerBound(all.size(), max_guesses) <
+                   OptimalContext::kInfeasible
+               ? max_guesses
+               : 0;
+  }
+  // Split the root across threads. Each opening is scored against the best
+  // cost so far plus one so ties are settled by rank, not by timing.
+  const std::vector<OptimalChoice> choices =
+      RankOptimalGuesses(*context, all, max_guesses);
+  std::atomic<int64_t> shared_best(OptimalContext::kInfeasible);
+  using Ranked = std::pair<int64_t, size_t>;
+  const auto [best_cost, best_rank] = ThreadPool::Instance().ParallelReduce(
+      0, choices.size(), 1, Ranked(OptimalContext::kInfeasible, kNoIndex),
+      [&](size_t rank, size_t) {
+        int64_t current = shared_best.load(std::memory_order_relaxed);
+        if (choices[rank].lower > current) {
+          return Ranked(OptimalContext::kInfeasible, kNoIndex);
+        }
+        const int64_t cost = OptimalGuessCost(context, all, max_guesses,
+                                              choices[rank].guess,
+                                              current + 1);
+        if (cost >= OptimalContext::kInfeasible) {
+          return Ranked(OptimalContext::kInfeasible, kNoIndex);
+        }
+        while (cost < current &&
+               !shared_best.compare_exchange_weak(current, cost,
+                                                  std::memory_order_relaxed)) {
+        }
+        return Ranked(cost, rank);
+      },
+      [](const Ranked& a, const Ranked& b) { return std::min(a, b); });
+  if (best_rank == kNoIndex) {
+    return 0;
+  }
+  context->Store(all, max_guesses, best_cost, true, choices[best_rank].guess);
+  return max_guesses;
+}
+
+size_t WordleSolver::OptimalWorstCaseRoot(OptimalContext* context,
+                                          const std::vector<size_t>& all,
+                                          size_t max_guesses) const {
+  // Iterative deepening: the smallest guess budget that admits any policy
+  // is the optimal worst case, and the first policy found achieves it.
+  for (size_t guesses = 1; guesses <= max_guesses; ++guesses) {
+    if (all.size() <= 2) {
+      if (context->LowerBound(all.size(), guesses) <
+          OptimalContext::kInfeasible) {
+        return guesses;
+      }
+      continue;
+    }
+    const std::vector<OptimalChoice> choices =
+        RankOptimalGuesses(*context, all, guesses);
+    // The lowest feasible rank wins; threads skip ranks past one that is
+    // already known to work.
+    std::atomic<size_t> found(choices.size());
+    ThreadPool::Instance().ParallelFor(0, choices.size(), 1, [&](size_t rank) {
+      if (rank > found.load(std::memory_order_relaxed) ||
+          choices[rank].lower >= OptimalContext::kInfeasible) {
+        return;
+      }
+      if (OptimalGuessFeasible(context, all, guesses, choices[rank].guess)) {
+        size_t current = found.load(std::memory_order_relaxed);
+        while (rank < current &&
+               !found.compare_exchange_weak(current, rank,
+                                            std::memory_order_relaxed)) {
+        }
+      }
+    });
+    if (found.load() < choices.size()) {
+      context->Store(all, guesses, static_cast<int64_t>(guesses), true,
+                     choices[found.load()].guess);
+      return guesses;
+    }
+  }
+  return 0;
+}
+
+std::vector<WordleSolver::OptimalChoice> WordleSolver::RankOptimalGuesses(
+    const OptimalContext& context,
+    const std::vector<size_t>& remaining,
+    size_t guesses_left) const {
+  const std::vector<size_t>& pool =
+      context.hard_mode ? remaining : context.all_indices;
+  const size_t n = remaining.size();
+  std::vector<OptimalChoice> choices;
+  std::unordered_set<std::string> partitions;
+  std::string signature(n, '\0');
+  std::array<int, kPatternCount> counts{};
+  std::array<uint8_t, kPatternCount> label{};
+  for (size_t guess : pool) {
+    // Guesses that split the set identically are interchangeable; keep the
+    // first. Buckets are relabelled in order of appearance, with the solved
+    // bucket kept distinct since it costs nothing further.
+    counts.fill(0);
+    label.fill(0);
+    uint8_t next_label = 1;
+    for (size_t i = 0; i < n; ++i) {
+      int pattern = PatternAt(guess, remaining[i]);
+      counts[pattern]++;
+      if (pattern == kSolvedPattern) {
+        signature[i] = static_cast<char>(0xFF);
+        continue;
+      }
+      if (label[pattern] == 0) {
+        label[pattern] = next_label++;
+      }
+      signature[i] = static_cast<char>(label[pattern]);
+    }
+    if (counts[kSolvedPattern] == 0 && next_label == 2) {
+      continue;
+    }
+    if (!partitions.insert(signature).second) {
+      continue;
+    }
+
+    OptimalChoice choice;
+    choice.guess = guess;
+    int64_t sum = 0;
+    int64_t worst = 0;
+    for (int pattern = 0; pattern < kPatternCount; ++pattern) {
+      if (pattern == kSolvedPattern || counts[pattern] == 0) {
+        continue;
+      }
+      int64_t bound = context.LowerBound(static_cast<size_t>(counts[pattern]),
+                                         guesses_left - 1);
+      sum += bound;
+      worst = std::max(worst, bound);
+    }
+    choice.lower = context.worst_case ? 1 + worst
+                                      : static_cast<int64_t>(n) + sum;
+    choice.lower = std::min(choice.lower, OptimalContext::kInfeasible);
+    choice.entropy = EntropyFromCounts(counts, n);
+    choices.push_back(choice);
+  }
+
+  auto by_entropy = [](const OptimalChoice& a, const OptimalChoice& b) {
+    return a.entropy > b.entropy;
+  };
+  if (context.guess_limit > 0 && choices.size() > context.guess_limit) {
+    std::stable_sort(choices.begin(), choices.end(), by_entropy);
+    choices.resize(context.guess_limit);
+  }
+  std::stable_sort(choices.begin(), choices.end(),
+                   [](const OptimalChoice& a, const OptimalChoice& b) {
+                     if (a.lower != b.lower) {
+                       return a.lower < b.lower;
+                     }
+                     return a.entropy > b.entropy;
+                   });
+  return choices;
+}
+
+int64_t WordleSolver::OptimalCost(OptimalContext* context,
+                                  const std::vector<size_t>& remaining,
+                                  size_t guesses_left,
+                                  int64_t bound) const {
+  const size_t n = remaining.size();
+  int64_t lower = context->LowerBound(n, guesses_left);
+  if (n <= 2 || lower >= bound || lower >= OptimalContext::kInfeasible) {
+    // One or two targets: guessing either one is optimal.
+    return lower;
+  }
+
+  OptimalContext::Entry entry;
+  if (context->Find(remaining, guesses_left, &entry)) {
+    context->memo_hits.fetch_add(1, std::memory_order_relaxed);
+    if (entry.exact) {
+      return entry.value;
+    }
+    lower = std::max(lower, entry.value);
+    if (lower >= bound) {
+      return lower;
+    }
+  }
+  context->states.fetch_add(1, std::memory_order_relaxed);
+
+  int64_t best = bound;
+  size_t best_guess = kNoIndex;
+  for (const OptimalChoice& choice :
+       RankOptimalGuesses(*context, remaining, guesses_left)) {
+    if (choice.lower >= best) {
+      break;
+    }
+    int64_t cost = OptimalGuessCost(context, remaining, guesses_left,
+                                    choice.guess, best);
+    if (cost < best) {
+      best = cost;
+      best_guess = choice.guess;
+    }
+  }
+  if (best_guess == kNoIndex) {
+    context->Store(remaining, guesses_left, bound, false, 0);
+    return bound;
+  }
+  context->Store(remaining, guesses_left, best, true, best_guess);
+  return best;
+}
+
+int64_t WordleSolver::OptimalGuessCost(OptimalContext* context,
+                                       const std::vector<size_t>& remaining,
+                                       size_t guesses_left,
+                                       size_t guess_index,
+                                       int64_t bound) const {
+  std::array<std::vector<size_t>, kPatternCount> buckets;
+  for (size_t index : remaining) {
+    int pattern = PatternAt(guess_index, index);
+    if (pattern != kSolvedPattern) {
+      buckets[pattern].push_back(index);
+    }
+  }
+  std::vector<int> order;
+  int64_t rest = 0;
+  for (int pattern = 0; pattern < kPatternCount; ++pattern) {
+    if (!buckets[pattern].empty()) {
+      order.push_back(pattern);
+      rest += context->LowerBound(buckets[pattern].size(), guesses_left - 1);
+    }
+  }
+  // Largest buckets first: they dominate the cost and fail the bound fastest.
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  int64_t total = static_cast<int64_t>(remaining.size());
+  for (int pattern : order) {
+    const std::vector<size_t>& bucket = buckets[pattern];
+    rest -= context->LowerBound(bucket.size(), guesses_left - 1);
+    total += OptimalCost(context, bucket, guesses_left - 1,
+                         bound - total - rest);
+    if (total + rest >= bound) {
+      return std::min(total + rest, OptimalContext::kInfeasible);
+    }
+  }
+  return total;
+}
+
+bool WordleSolver::OptimalFeasible(OptimalContext* context,
+                                   const std::vector<size_t>& remaining,
+                                   size_t guesses_left) const {
+  const size_t n = remaining.size();
+  if (context->LowerBound(n, guesses_left) >= OptimalContext::kInfeasible) {
+    return false;
+  }
+  if (n <= 2) {
+    return true;
+  }
+  OptimalContext::Entry entry;
+  if (context->Find(remaining, guesses_left, &entry)) {
+    context->memo_hits.fetch_add(1, std::memory_order_relaxed);
+    return entry.exact;
+  }
+  context->states.fetch_add(1, std::memory_order_relaxed);
+
+  if (guesses_left == 2) {
+    // Two guesses left: some guess must give every target its own pattern.
+    // Scanning for one beats ranking a full partition per guess.
+    const std::vector<size_t>& pool =
+        context->hard_mode ? remaining : context->all_indices;
+    for (size_t guess : pool) {
+      std::array<uint64_t, (kPatternCount + 63) / 64> seen{};
+      bool distinct = true;
+      for (size_t index : remaining) {
+        const int pattern = PatternAt(guess, index);
+        uint64_t& block = seen[static_cast<size_t>(pattern) >> 6];
+        const uint64_t bit = uint64_t{1} << (pattern & 63);
+        if ((block & bit) != 0) {
+          distinct = false;
+          break;
+        }
+        block |= bit;
+      }
+      if (distinct) {
+        context->Store(remaining, guesses_left, 2, true, guess);
+        return true;
+      }
+    }
+    context->Store(remaining, guesses_left, OptimalContext::kInfeasible,
+                   false, 0);
+    return false;
+  }
+
+  for (const OptimalChoice& choice :
+       RankOptimalGuesses(*context, remaining, guesses_left)) {
+    if (choice.lower >= OptimalContext::kInfeasible) {
+      break;
+    }
+    if (OptimalGuessFeasible(context, remaining, guesses_left, choice.guess)) {
+      context->Store(remaining, guesses_left,
+                     static_cast<int64_t>(guesses_left), true, choice.guess);
+      return true;
+    }
+  }
+  context->Store(remaining, guesses_left, OptimalContext::kInfeasible, false,
+                 0);
+  return false;
+}
+
+bool WordleSolver::OptimalGuessFeasible(OptimalContext* context,
+                                        const std::vector<size_t>& remaining,
+                                        size_t guesses_left,
+                                        size_t guess_index) const {
+  std::array<std::vector<size_t>, kPatternCount> buckets;
+  for (size_t index : remaining) {
+    int pattern = PatternAt(guess_index, index);
+    if (pattern != kSolvedPattern) {
+      buckets[pattern].push_back(index);
+    }
+  }
+  std::vector<int> order;
+  for (int pattern = 0; pattern < kPatternCount; ++pattern) {
+    if (!buckets[pattern].empty()) {
+      order.push_back(pattern);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+  for (int pattern : order) {
+    if (!OptimalFeasible(context, buckets[pattern], guesses_left - 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t WordleSolver::OptimalTreeNode(OptimalContext* context,
+                                       const std::vector<size_t>& remaining,
+                                       size_t guesses_left,
+                                       DecisionTree* tree) const {
+  size_t guess_index = remaining[0];
+  if (remaining.size() > 2) {
+    OptimalContext::Entry entry;
+    if (context->Find(remaining, guesses_left, &entry) && entry.exact) {
+      guess_index = entry.guess;
+    }
+  }
+  const uint32_t node =
+      tree->AddNode(guess_index, EntropyForGuess(guess_index, remaining));
+  const size_t depth = context->max_guesses - guesses_left + 1;
+
+  std::array<std::vector<size_t>, kPatternCount> buckets;
+  for (size_t index : remaining) {
+    int pattern = PatternAt(guess_index, index);
+    if (pattern == kSolvedPattern) {
+      context->total_guesses += depth;
+      context->worst_guesses = std::max(context->worst_guesses, depth);
+    } else {
+      buckets[pattern].push_back(index);
+    }
+  }
+  for (int pattern = 0; pattern < kPatternCount; ++pattern) {
+    if (buckets[pattern].empty()) {
+      continue;
+    }
+    uint32_t child =
+        OptimalTreeNode(context, buckets[pattern], guesses_left - 1, tree);
+    tree->SetChild(node, pattern, child);
+  }
+  return node;
+}
+
+WordleSolver::AdversarialResult WordleSolver::SolveAdversarial(
+    const std::vector<size_t>& remaining,
+    const AdversarialOptions& options) const {
+  AdversarialResult result;
+  if (remaining.empty() || options.max_guesses == 0) {
+    return result;
+  }
+  // Against an adversary free to pick any consistent bucket, the fewest
+  // guesses that force a win is the optimal worst case from `remaining`,
+  // so this reuses the worst-case policy search rooted there.
+  OptimalContext context;
+  context.worst_case = true;
+  context.hard_mode = options.hard_mode;
+  context.guess_limit = options.guess_limit;
+  context.max_guesses = options.max_guesses;
+  context.all_indices.resize(words_.size());
+  std::iota(context.all_indices.begin(), context.all_indices.end(), 0);
+
+  result.guesses =
+      OptimalWorstCaseRoot(&context, remaining, options.max_guesses);
+  if (result.guesses > 0) {
+    result.guess = remaining[0];
+    OptimalContext::Entry entry;
+    if (remaining.size() > 2 &&
+        context.Find(remaining, result.guesses, &entry) && entry.exact) {
+      result.guess = entry.guess;
+    }
+    result.proven_optimal = options.guess_limit == 0;
+  }
+  result.states = context.states.load();
+  result.memo_hits = context.memo_hits.load();
+  return result;
+}
+
+int WordleSolver::AdversarialPattern(size_t guess_index,
+                                     const std::vector<size_t>& remaining,
+                                     const AdversarialOptions& options) const {
+  std::array<std::vector<size_t>, kPatternCount> buckets;
+  for (size_t index : remaining) {
+    buckets[PatternAt(guess_index, index)].push_back(index);
+  }
+  OptimalContext context;
+  context.worst_case = true;
+  context.hard_mode = options.hard_mode;
+  context.guess_limit = options.guess_limit;
+  context.max_guesses = options.max_guesses;
+  context.all_indices.resize(words_.size());
+  std::iota(context.all_indices.begin(), context.all_indices.end(), 0);
+
+  // Buckets that no budget within max_guesses solves rank above all others.
+  int best_pattern = kSolvedPattern;
+  size_t best_cost = 0;
+  size_t best_size = 0;
+  for (int pattern = 0; pattern < kPatternCount; ++pattern) {
+    const std::vector<size_t>& bucket = buckets[pattern];
+    if (pattern == kSolvedPattern || bucket.empty()) {
+      continue;
+    }
+    size_t cost = 1;
+    while (cost <= options.max_guesses &&
+           !OptimalFeasible(&context, bucket, cost)) {
+      ++cost;
+    }
+    if (cost > best_cost || (cost == best_cost && bucket.size() > best_size)) {
+      best_pattern = pattern;
+      best_cost = cost;
+      best_size = bucket.size();
+    }
+  }
+  return best_pattern;
+}
+
+uint32_t WordleSolver::PolicyRoot() const {
+  // The greedy hard-mode tree replays exactly the search SolveToTarget runs;
+  // an optimal tree is followed whichever mode it was built for.
+  if (decision_tree_.empty() ||
+      (decision_tree_.policy() == DecisionTree::Policy::kGreedy &&
+       !decision_tree_.hard_mode())) {
+    return DecisionTree::kNoNode;
+  }
+  return decision_tree_.root();
+}
+
+size_t WordleSolver::BestGuessIndex(const std::vector<size_t>& candidates,
+                                    const std::vector<size_t>& targets,
+                                    double* entropy_out,
+                                    SearchStats* stats) const {
+  size_t guess = 0;
+  BoundedGuessIndex(candidates, targets, SearchLimits{}, &guess, entropy_out,
+                    stats);
+  return guess;
+}
+
+bool WordleSolver::BoundedGuessIndex(const std::vector<size_t>& candidates,
+                                     const std::vector<size_t>& targets,
+                                     const SearchLimits& limits,
+                                     size_t* guess_out,
+                                     double* entropy_out,
+                                     SearchStats* stats) const {
+  return GuessSearch<Shape>(words_, MatrixOf(*this))
+      .Run(candidates, targets, limits, guess_out, entropy_out, stats);
+}
+
+size_t WordleSolver::ChooseGuessIndex(const std::vector<size_t>& candidates,
+                                      const std::vector<size_t>& targets,
+                                      bool hard_mode,
+                                      double* entropy_out,
+                                      SearchStats* stats) const {
+  size_t guess = kNoIndex;
+  ChooseGuessIndex(candidates, targets, hard_mode, SearchLimits{}, &guess,
+                   entropy_out, stats);
+  return guess;
+}
+
+bool WordleSolver::ChooseGuessIndex(const std::vector<size_t>& candidates,
+                                    const std::vector<size_t>& targets,
+                                    bool hard_mode,
+                                    const SearchLimits& limits,
+                                    size_t* guess_out,
+                                    double* entropy_out,
+                                    SearchStats* stats) const {
+  const bool cacheable = guess_cache_.enabled() && !candidates.empty();
+  GuessCache::Key key;
+  if (cacheable) {
+    // Lookahead answers depend on the mode; greedy ones do not.
+    const uint64_t salt = lookahead_beam_ <= 1
+                              ? lookahead_beam_
+                              : lookahead_beam_ * 2 + (hard_mode ? 1 : 0);
+    key = GuessCache::MakeKey(candidates, targets, salt);
+    GuessCache::Entry entry;
+    if (guess_cache_.Find(key, &entry)) {
+      if (stats) {
+        *stats = SearchStats{};
+        stats->candidates = candidates.size();
+      }
+      if (entropy_out) {
+        *entropy_out = entry.entropy;
+      }
+      *guess_out = entry.guess;
+      return true;
+    }
+  }
+
+  size_t guess = kNoIndex;
+  double entropy = 0.0;
+  bool exact = true;
+  if (lookahead_beam_ <= 1 || candidates.empty() || targets.size() < 3) {
+    exact = BoundedGuessIndex(candidates, targets, limits, &guess, &entropy,
+                              stats);
+  } else {
+    LookaheadResult result = BestGuessLookahead(candidates, targets,
+                                                lookahead_beam_, hard_mode,
+                                                limits);
+    if (stats) {
+      *stats = SearchStats{};
+      stats->candidates = candidates.size();
+    }
+    guess = result.guess;
+    entropy = result.entropy;
+    exact = result.exact;
+  }
+  if (exact && cacheable) {
+    guess_cache_.Store(key, {static_cast<uint32_t>(guess), entropy});
+  }
+  if (entropy_out) {
+    *entropy_out = entropy;
+  }
+  *guess_out = guess;
+  return exact;
+}
+
+std::vector<WordleSolver::ScoredGuess> WordleSolver::TopGuesses(
+    const std::vector<size_t>& candidates,
+    const std::vector<size_t>& targets,
+    size_t k,
+    const SearchLimits& limits) const {
+  std::vector<ScoredGuess> top;
+  k = std::min(k, candidates.size());
+  if (k == 0) {
+    return top;
+  }
+  if (targets.empty()) {
+    for (size_t i = 0; i < k; ++i) {
+      top.push_back({candidates[i], 0.0});
+    }
+    return top;
+  }
+
+  // Same bounds as BestGuessIndex, pruned against the k-th best entropy.
+  // Each thread's k-th best is a lower bound on the global one, so the
+  // shared threshold never drops a guess that belongs in the result.
+  const size_t total = targets.size();
+  const double log_total = std::log2(static_cast<double>(total));
+  const GuessSearch<Shape> scorer(words_, MatrixOf(*this));
+  WordTable packed_targets;
+  scorer.CompactTargets(targets, &packed_targets);
+  const TargetLetters summary = SummarizeTargets(words_, targets);
+  std::vector<double> xlogx(total + 1, 0.0);
+  for (size_t c = 2; c <= total; ++c) {
+    double value = static_cast<double>(c);
+    xlogx[c] = value * std::log2(value);
+  }
+  std::vector<double> bounds(candidates.size());
+  std::vector<size_t> patterns(candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    bounds[i] = EntropyBound(words_.packed(candidates[i]), summary, xlogx,
+                             &patterns[i]);
+  }
+  std::vector<size_t> order(candidates.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return bounds[a] > bounds[b];
+  });
+
+  // Positions ordered best first: higher entropy, then earlier candidate.
+  struct Ranked {
+    double entropy;
+    size_t position;
+    bool operator<(const Ranked& other) const {
+      return entropy > other.entropy ||
+             (entropy == other.entropy && position < other.position);
+    }
+  };
+  std::atomic<double> threshold(-std::numeric_limits<double>::infinity());
+  const bool timed =
+      limits.deadline != std::chrono::steady_clock::time_point::max();
+  std::atomic<bool> expired(false);
+
+  // Any k scored guesses bound the k-th best from below, so each task's own
+  // list can raise the shared threshold. The first guess always runs.
+  auto search = [&](size_t begin, size_t end) {
+    std::vector<Ranked> local;
+    std::array<int, kPatternCount> counts{};
+    for (size_t i = begin; i < end; ++i) {
+      const size_t position = order[i];
+      if (bounds[position] <
+          threshold.load(std::memory_order_relaxed) - kPruneSlack) {
+        continue;
+      }
+      if (i > 0 &&
+          (expired.load(std::memory_order_relaxed) ||
+           (limits.cancel && limits.cancel->cancelled()) ||
+           (timed && std::chrono::steady_clock::now() >= limits.deadline))) {
+        expired.store(true, std::memory_order_relaxed);
+        break;
+      }
+      if (!scorer.BoundedCounts(candidates[position], targets, packed_targets,
+                                log_total, patterns[position], &threshold,
+                                &counts, limits.cancel)) {
+        continue;
+      }
+      Ranked entry{EntropyFromCounts(counts, total), position};
+      local.insert(std::upper_bound(local.begin(), local.end(), entry),
+                   entry);
+      if (local.size() > k) {
+        local.pop_back();
+      }
+      if (local.size() == k) {
+        AtomicMax(&threshold, local.back().entropy);
+      }
+    }
+    return local;
+  };
+
+  auto merge = [k](std::vector<Ranked> a, std::vector<Ranked> b) {
+    a.insert(a.end(), b.begin(), b.end());
+    std::sort(a.begin(), a.end());
+    a.resize(std::min(a.size(), k));
+    return a;
+  };
+  const std::vector<Ranked> merged = ThreadPool::Instance().ParallelReduce(
+      0, order.size(), kGuessGrain, std::vector<Ranked>(), search, merge);
+
+  top.reserve(merged.size());
+  for (const Ranked& entry : merged) {
+    top.push_back({candidates[entry.position], entry.entropy});
+  }
+  return top;
+}
+
+WordleSolver::LookaheadResult WordleSolver::BestGuessLookahead(
+    const std::vector<size_t>& candidates,
+    const std::vector<size_t>& targets,
+    size_t beam,
+    bool hard_mode,
+    const SearchLimits& limits) const {
+  LookaheadResult result;
+  if (candidates.empty()) {
+    return result;
+  }
+  // Limits running out in either ply leave the greedy leader of what was
+  // scored, since partly scored beams are not comparable.
+  const bool timed =
+      limits.deadline != std::chrono::steady_clock::time_point::max();
+  auto out_of_time = [&] {
+    return (limits.cancel && limits.cancel->cancelled()) ||
+           (timed && std::chrono::steady_clock::now() >= limits.deadline);
+  };
+  const std::vector<ScoredGuess> top =
+      TopGuesses(candidates, targets, std::max<size_t>(beam, 1), limits);
+  if (top.empty()) {
+    result.guess = candidates[0];
+    result.exact = false;
+    return result;
+  }
+  result.beam = top.size();
+  result.guess = top[0].index;
+  result.entropy = top[0].entropy;
+  result.score = top[0].entropy;
+  if (out_of_time()) {
+    result.exact = false;
+    return result;
+  }
+  if (targets.size() < 3 || top.size() < 2) {
+    return result;
+  }
+
+  // Partition the targets once per beam guess. Identical buckets across
+  // guesses share one second-ply search; singletons score zero. In hard
+  // mode a bucket's second guesses are the candidates its feedback still
+  // allows, so buckets only merge when those pools agree too.
+  std::vector<std::vector<size_t>> buckets;
+  std::vector<std::vector<size_t>> pools;
+  std::unordered_map<uint64_t, std::vector<size_t>> bucket_ids;
+  std::vector<std::vector<std::pair<size_t, size_t>>> parts(top.size());
+  for (size_t g = 0; g < top.size(); ++g) {
+    if (out_of_time()) {
+      result.exact = false;
+      return result;
+    }
+    std::array<std::vector<size_t>, kPatternCount> split;
+    for (size_t index : targets) {
+      split[PatternAt(top[g].index, index)].push_back(index);
+    }
+    for (int pattern = 0; pattern < kPatternCount; ++pattern) {
+      std::vector<size_t>& bucket = split[pattern];
+      if (pattern == kSolvedPattern || bucket.size() < 2) {
+        continue;
+      }
+      std::vector<size_t> pool;
+      if (hard_mode) {
+        HintConstraints hint;
+        hint.Add(words_.text(top[g].index), PatternString(pattern));
+        for (size_t index : candidates) {
+          if (hint.AllowsGuess(words_.packed(index))) {
+            pool.push_back(index);
+          }
+        }
+      }
+      uint64_t hash = 1469598103934665603ULL;
+      for (size_t index : bucket) {
+        hash ^= static_cast<uint64_t>(index);
+        hash *= 1099511628211ULL;
+      }
+      std::vector<size_t>& ids = bucket_ids[hash];
+      size_t id = buckets.size();
+      for (size_t candidate : ids) {
+        if (buckets[candidate] == bucket && pools[candidate] == pool) {
+          id = candidate;
+          break;
+        }
+      }
+      if (id == buckets.size()) {
+        ids.push_back(id);
+        buckets.push_back(std::move(bucket));
+        pools.push_back(std::move(pool));
+      }
+      parts[g].emplace_back(id, buckets[id].size());
+    }
+  }
+
+  SearchLimits bucket_limits = limits;
+  bucket_limits.warm_up = false;
+  std::vector<double> second(buckets.size(), 0.0);
+  std::atomic<bool> finished(true);
+  ThreadPool::Instance().ParallelFor(0, buckets.size(), 1, [&](size_t b) {
+    size_t guess = 0;
+    if (!finished.load(std::memory_order_relaxed)) {
+      return;
+    }
+    if (!BoundedGuessIndex(hard_mode ? pools[b] : candidates, buckets[b],
+                           bucket_limits, &guess, &second[b], nullptr)) {
+      finished.store(false, std::memory_order_relaxed);
+    }
+  });
+  result.second_ply_searches = buckets.size();
+  if (!finished.load(std::memory_order_relaxed)) {
+    result.exact = false;
+    return result;
+  }
+
+  const double inv_total = 1.0 / static_cast<double>(targets.size());
+  for (size_t g = 0; g < top.size(); ++g) {
+    double score = top[g].entropy;
+    for (const auto& [id, size] : parts[g]) {
+      score += static_cast<double>(size) * inv_total * second[id];
+    }
+    if (g == 0 || score > result.score) {
+      result.guess = top[g].index;
+      result.entropy = top[g].entropy;
+      result.score = score;
+    }
+  }
+  return result;
+}
+
+double WordleSolver::EntropyOf(const std::array<int, kPatternCount>& counts,
+                               size_t total) {
+  return EntropyFromCounts(counts, total);
+}
+
+double WordleSolver::EntropyForGuess(
+    size_t guess_index,
+    const std::vector<size_t>& targets) const {
+  if (targets.empty()) {
+    return 0.0;
+  }
+  return EntropyFromCounts(PatternCounts(guess_index, targets),
+                           targets.size());
+}
+
+std::array<int, WordleSolver::kPatternCount> WordleSolver::PatternCounts(
+    size_t guess_index,
+    const std::vector<size_t>& targets,
+    const CancelToken* cancel) const {
+  return GuessSearch<Shape>(words_, MatrixOf(*this))
+      .PatternCounts(guess_index, targets, cancel);
+}
+
+std::array<int, WordleSolver::kPatternCount> WordleSolver::PatternCounts(
+    size_t guess_index,
+    const CandidateSet& targets) const {
+  std::array<int, kPatternCount> counts{};
+  counts.fill(0);
+  auto it = pattern_bitmaps_.find(guess_index);
+  if (it != pattern_bitmaps_.end()) {
+    // Popcounting every live bucket touches sets.size() full bitmaps, which
+    // only beats walking the members once the set bits outnumber them.
+    const GuessBitmaps& bitmaps = it->second;
+    const size_t popcount_cost = bitmaps.sets.size() * targets.blocks().size();
+    if (popcount_cost < targets.Count()) {
+      for (int pattern = 0; pattern < kPatternCount; ++pattern) {
+        int16_t slot = bitmaps.slot[pattern];
+        if (slot >= 0) {
+          counts[pattern] =
+              static_cast<int>(targets.IntersectCount(bitmaps.sets[slot]));
+        }
+      }
+      return counts;
+    }
+  }
+  PatternTally tally(&counts, targets.Count());
+  constexpr size_t kBatch = 256;
+  std::array<uint8_t, kBatch> codes;
+  size_t batch = 0;
+  if (!pattern_matrix_.empty()) {
+    const uint8_t* row = pattern_matrix_.Row(guess_index);
+    targets.ForEach([&](size_t index) {
+      codes[batch++] = row[index];
+      if (batch == kBatch) {
+        tally.Add(codes.data(), batch);
+        batch = 0;
+      }
+    });
+    if (batch > 0) {
+      tally.Add(codes.data(), batch);
+    }
+    tally.Fold();
+    return counts;
+  }
+
+  std::array<uint32_t, kBatch> letters{};
+  const PackedWord guess = words_.packed(guess_index);
+  auto flush = [&]() {
+    PatternBatch(guess, letters.data(), batch, codes.data());
+    tally.Add(codes.data(), batch);
+    batch = 0;
+  };
+  targets.ForEach([&](size_t index) {
+    letters[batch++] = words_.letters()[index];
+    if (batch == kBatch) {
+      flush();
+    }
+  });
+  if (batch > 0) {
+    flush();
+  }
+  tally.Fold();
+  return counts;
+}
+
+std::array<int, WordleSolver::kPatternCount> WordleSolver::PatternCounts(
+    size_t guess_index,
+    const WordTable& targets) const {
+  std::array<int, kPatternCount> counts{};
+  counts.fill(0);
+  PatternTally tally(&counts, targets.size());
+  constexpr size_t kBatch = 256;
+  std::array<uint8_t, kBatch> codes;
+  const PackedWord guess = words_.packed(guess_index);
+  for (size_t offset = 0; offset < targets.size(); offset += kBatch) {
+    const size_t batch = std::min(kBatch, targets.size() - offset);
+    PatternBatch(guess, targets.letters() + offset, batch, codes.data());
+    tally.Add(codes.data(), batch);
+  }
+  tally.Fold();
+  return counts;
+}
+
+std::string WordleSolver::BestGuess(const std::vector<size_t>& candidates,
+                                    const std::vector<size_t>& targets,
+                                    double* entropy_out,
+                                    SearchStats* stats,
+                                    bool hard_mode) const {
+  size_t best_index =
+      ChooseGuessIndex(candidates, targets, hard_mode, entropy_out, stats);
+  if (candidates.empty()) {
+    return {};
+  }
+  return std::string(words_.text(best_index));
+}
+
+std::string WordleSolver::BestGuessWithin(const std::vector<size_t>& candidates,
+                                          const std::vector<size_t>& targets,
+                                          std::chrono::microseconds budget,
+                                          double* entropy_out,
+                                          bool* exact_out,
+                                          SearchStats* stats,
+                                          bool hard_mode) const {
+  SearchLimits limits;
+  limits.deadline = std::chrono::steady_clock::now() + budget;
+  limits.warm_up = true;
+  return BestGuessWithin(candidates, targets, limits, entropy_out, exact_out,
+                         stats, hard_mode);
+}
+
+std::string WordleSolver::BestGuessWithin(const std::vector<size_t>& candidates,
+                                          const std::vector<size_t>& targets,
+                                          const SearchLimits& limits,
+                                          double* entropy_out,
+                                          bool* exact_out,
+                                          SearchStats* stats,
+                                          bool hard_mode) const {
+  if (exact_out) {
+    *exact_out = true;
+  }
+  if (entropy_out) {
+    *entropy_out = 0.0;
+  }
+  if (stats) {
+    *stats = SearchStats{};
+    stats->candidates = candidates.size();
+  }
+  if (candidates.empty()) {
+    return {};
+  }
+  size_t guess = 0;
+  const bool exact = ChooseGuessIndex(candidates, targets, hard_mode, limits,
+                                      &guess, entropy_out, stats);
+  if (exact_out) {
+    *exact_out = exact;
+  }
+  return std::string(words_.text(guess));
+}
+
+GuessFuture WordleSolver::BestGuessAsync(
+    std::vector<size_t> candidates,
+    std::vector<size_t> targets,
+    std::chrono::microseconds budget,
+    bool hard_mode) const {
+  if (candidates.empty()) {
+    return GuessFuture::FromResult({});
+  }
+  const bool bounded = budget != std::chrono::microseconds::max();
+  const auto deadline =
+      bounded ? std::chrono::steady_clock::now() + budget
+              : std::chrono::steady_clock::time_point::max();
+  return GuessFuture::Launch(
+      [this, candidates = std::move(candidates), targets = std::move(targets),
+       bounded, deadline, hard_mode](const CancelToken& cancel) {
+        GuessFuture::Result result;
+        size_t guess = 0;
+        SearchLimits limits;
+        limits.deadline = deadline;
+        limits.warm_up = bounded;
+        limits.cancel = &cancel;
+        result.exact = ChooseGuessIndex(candidates, targets, hard_mode, limits,
+                                        &guess, &result.entropy,
+                                        &result.stats);
+        result.guess = std::string(words_.text(guess));
+        result.cancelled = cancel.cancelled();
+        return result;
+      });
+}
+
+// Shared between the handle and the thread computing its result, so a
+// handle may be moved while the thread runs.
+struct GuessFuture::State {
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  bool done = false;
+  Result result;
+};
+
+GuessFuture GuessFuture::Launch(
+    std::function<Result(const CancelToken&)> work) {
+  GuessFuture future;
+  future.state_ = std::make_shared<State>();
+  auto run = [state = future.state_, token = future.token_,
+              work = std::move(work)] {
+    Result result = work(token);
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->result = std::move(result);
+    state->done = true;
+    state->done_cv.notify_all();
+  };
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  run();
+#else
+  future.thread_ = std::thread(std::move(run));
+#endif
+  return future;
+}
+
+GuessFuture GuessFuture::FromResult(Result result) {
+  GuessFuture future;
+  future.state_ = std::make_shared<State>();
+  future.state_->result = std::move(result);
+  future.state_->done = true;
+  return future;
+}
+
+GuessFuture::GuessFuture(GuessFuture&& other) noexcept
+    : state_(std::move(other.state_)),
+      token_(std::exchange(other.token_, CancelToken())),
+      thread_(std::move(other.thread_)) {}
+
+GuessFuture& GuessFuture::operator=(GuessFuture&& other) noexcept {
+  if (this != &other) {
+    Release();
+    state_ = std::move(other.state_);
+    token_ = std::exchange(other.token_, CancelToken());
+    thread_ = std::move(other.thread_);
+  }
+  return *this;
+}
+
+GuessFuture::~GuessFuture() { Release(); }
+
+void GuessFuture::Release() {
+  // An abandoned search is no longer wanted; stop it before waiting.
+  if (thread_.joinable()) {
+    token_.Cancel();
+    thread_.join();
+  }
+  state_.reset();
+}
+
+bool GuessFuture::ready() const {
+  if (!state_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->done;
+}
+
+bool GuessFuture::WaitFor(std::chrono::microseconds timeout) const {
+  if (!state_) {
+    return false;
+  }
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  return state_->done_cv.wait_for(lock, timeout,
+                                  [this] { return state_->done; });
+}
+
+const GuessFuture::Result& GuessFuture::Get() {
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  return state_->result;
+}
+
+std::vector<WordleSolver::Step> WordleSolver::SolveToTarget(
+    const std::string& target,
+    size_t max_steps) const {
+  std::vector<Step> steps;
+  if (words_.empty()) {
+    return steps;
+  }
+
+  std::string normalized = NormalizeWord(target);
+  if (!IsValidWord(normalized)) {
+    return steps;
+  }
+  PackedWord target_packed = EncodeWord(normalized);
+
+  std::vector<size_t> remaining(words_.size());
+  std::iota(remaining.begin(), remaining.end(), 0);
+  std::vector<size_t> next;
+  next.reserve(remaining.size());
+
+  uint32_t book_node = PolicyRoot();
+  for (size_t step = 0; step < max_steps && !remaining.empty(); ++step) {
+    double entropy = 0.0;
+    size_t best_index = 0;
+    if (book_node != DecisionTree::kNoNode) {
+      best_index = decision_tree_.Guess(book_node);
+      entropy = decision_tree_.Entropy(book_node);
+    } else {
+      best_index = ChooseGuessIndex(remaining, remaining, true, &entropy);
+    }
+    const PackedWord guess = words_.packed(best_index);
+    int pattern = Pattern(guess, target_packed);
+    auto counts = PatternCounts(best_index, remaining);
+
+    int pattern_count = counts[pattern];
+    double info_bits = 0.0;
+    if (pattern_count > 0) {
+      double p = static_cast<double>(pattern_count) /
+                 static_cast<double>(remaining.size());
+      info_bits = -std::log2(p);
+    }
+
+    next.clear();
+    if (next.capacity() < remaining.size()) {
+      next.reserve(remaining.size());
+    }
+    if (!pattern_matrix_.empty()) {
+      const uint8_t* row = pattern_matrix_.Row(best_index);
+      for (size_t index : remaining) {
+        if (row[index] == pattern) {
+          next.push_back(index);
+        }
+      }
+    } else {
+      for (size_t index : remaining) {
+        if (Pattern(guess, words_.packed(index)) == pattern) {
+          next.push_back(index);
+        }
+      }
+    }
+
+    Step entry;
+    entry.guess = words_.text(best_index);
+    entry.pattern = PatternString(pattern);
+    entry.entropy = entropy;
+    entry.info_bits = info_bits;
+    entry.remaining = remaining.size();
+    entry.remaining_after = next.size();
+    steps.push_back(std::move(entry));
+
+    if (pattern == kSolvedPattern) {
+      break;
+    }
+    book_node = decision_tree_.Child(book_node, pattern);
+    remaining.swap(next);
+  }
+
+  return steps;
+}
+
+WordleSolver::SolveAllResult WordleSolver::SolveAll(
+    const std::vector<std::string>& targets,
+    size_t max_steps) const {
+  SolveAllResult result;
+  result.games.resize(targets.size());
+  std::vector<PackedWord> packed(targets.size());
+  std::vector<size_t> playable;
+  playable.reserve(targets.size());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    std::string normalized = NormalizeWord(targets[i]);
+    result.games[i].target = normalized;
+    if (!IsValidWord(normalized)) {
+      continue;
+    }
+    packed[i] = EncodeWord(normalized);
+    playable.push_back(i);
+  }
+  if (words_.empty() || playable.empty() || max_steps == 0) {
+    return result;
+  }
+
+  std::vector<size_t> remaining(words_.size());
+  std::iota(remaining.begin(), remaining.end(), 0);
+  uint32_t book_node = PolicyRoot();
+  SolveAllNode(remaining, playable, packed, 0, max_steps, book_node, &result);
+  return result;
+}
+
+void WordleSolver::SolveAllNode(const std::vector<size_t>& remaining,
+                                const std::vector<size_t>& games,
+                                const std::vector<PackedWord>& targets,
+                                size_t depth,
+                                size_t max_steps,
+                                uint32_t book_node,
+                                SolveAllResult* result) const {
+  auto start = std::chrono::steady_clock::now();
+  double entropy = 0.0;
+  size_t best_index = 0;
+  if (book_node != DecisionTree::kNoNode) {
+    best_index = decision_tree_.Guess(book_node);
+    entropy = decision_tree_.Entropy(book_node);
+  } else {
+    best_index = ChooseGuessIndex(remaining, remaining, true, &entropy);
+  }
+  auto end = std::chrono::steady_clock::now();
+  const double elapsed_ms =
+      std::chrono::duration<double, std::milli>(end - start).count();
+  if (book_node == DecisionTree::kNoNode) {
+    std::atomic_ref<size_t>(result->decisions)
+        .fetch_add(1, std::memory_order_relaxed);
+  }
+
+  const PackedWord guess = words_.packed(best_index);
+  const auto counts = PatternCounts(best_index, remaining);
+  std::array<std::vector<size_t>, kPatternCount> next_games;
+  for (size_t game : games) {
+    int pattern = Pattern(guess, targets[game]);
+    int pattern_count = counts[pattern];
+    double info_bits = 0.0;
+    if (pattern_count > 0) {
+      double p = static_cast<double>(pattern_count) /
+                 static_cast<double>(remaining.size());
+      info_bits = -std::log2(p);
+    }
+
+    Step entry;
+    entry.guess = words_.text(best_index);
+    entry.pattern = PatternString(pattern);
+    entry.entropy = entropy;
+    entry.info_bits = info_bits;
+    entry.remaining = remaining.size();
+    entry.remaining_after = static_cast<size_t>(pattern_count);
+    GameResult& record = result->games[game];
+    record.steps.push_back(std::move(entry));
+    record.step_ms.push_back(elapsed_ms);
+    if (pattern == kSolvedPattern) {
+      record.solved = true;
+    } else if (pattern_count > 0 && depth + 1 < max_steps) {
+      next_games[pattern].push_back(game);
+    }
+  }
+
+  std::vector<int> branches;
+  for (int pattern = 0; pattern < kPatternCount; ++pattern) {
+    if (!next_games[pattern].empty()) {
+      branches.push_back(pattern);
+    }
+  }
+  auto solve_branch = [&](int pattern) {
+    std::vector<size_t> next;
+    next.reserve(static_cast<size_t>(counts[pattern]));
+    for (size_t index : remaining) {
+      if (PatternAt(best_index, index) == pattern) {
+        next.push_back(index);
+      }
+    }
+    SolveAllNode(next, next_games[pattern], targets, depth + 1, max_steps,
+                 decision_tree_.Child(book_node, pattern), result);
+  };
+
+  // Games in different buckets never meet again, so each opening branch is
+  // an independent task. Deeper levels run serially inside their task; the
+  // guess searches they start share the same pool.
+  if (depth == 0) {
+    ThreadPool::Instance().ParallelFor(
+        0, branches.size(), 1, [&](size_t i) { solve_branch(branches[i]); });
+    return;
+  }
+  for (int pattern : branches) {
+    solve_branch(pattern);
+  }
+}
+
+
+std::vector<size_t> WordleSolver::BestGuessBatch(
+    const std::vector<size_t>& candidates,
+    const std::vector<const std::vector<size_t>*>& target_sets,
+    std::vector<double>* entropies,
+    bool hard_mode) const {
+  const size_t count = target_sets.size();
+  std::vector<size_t> guesses(count, kNoIndex);
+  std::vector<double> scores(count, 0.0);
+  if (!candidates.empty()) {
+    // Lookahead, cache hits and trivial sets take the single-set path.
+    // Sets with equal contents share one histogram.
+    const bool cacheable = guess_cache_.enabled();
+    std::vector<const std::vector<size_t>*> distinct;
+    std::vector<size_t> slot(count, kNoIndex);
+    for (size_t i = 0; i < count; ++i) {
+      const std::vector<size_t>& targets = *target_sets[i];
+      if (lookahead_beam_ > 1 || targets.empty()) {
+        guesses[i] =
+            ChooseGuessIndex(candidates, targets, hard_mode, &scores[i]);
+        continue;
+      }
+      if (cacheable) {
+        GuessCache::Entry entry;
+        if (guess_cache_.Find(
+                GuessCache::MakeKey(candidates, targets, lookahead_beam_),
+                &entry)) {
+          guesses[i] = entry.guess;
+          scores[i] = entry.entropy;
+          continue;
+        }
+      }
+      size_t d = 0;
+      while (d < distinct.size() && *distinct[d] != targets) {
+        ++d;
+      }
+      if (d == distinct.size()) {
+        distinct.push_back(&targets);
+      }
+      slot[i] = d;
+    }
+
+    std::vector<size_t> distinct_guesses(distinct.size(), kNoIndex);
+    std::vector<double> distinct_scores(distinct.size(), 0.0);
+    for (size_t begin = 0; begin < distinct.size(); begin += kMaxBoards) {
+      const size_t end = std::min(distinct.size(), begin + kMaxBoards);
+      std::vector<const std::vector<size_t>*> sets(distinct.begin() + begin,
+                                                   distinct.begin() + end);
+      std::vector<size_t> sweep_guesses;
+      std::vector<double> sweep_scores;
+      BatchSweep(candidates, sets, &sweep_guesses, &sweep_scores);
+      std::copy(sweep_guesses.begin(), sweep_guesses.end(),
+                distinct_guesses.begin() + begin);
+      std::copy(sweep_scores.begin(), sweep_scores.end(),
+                distinct_scores.begin() + begin);
+    }
+    for (size_t d = 0; d < distinct.size() && cacheable; ++d) {
+      guess_cache_.Store(
+          GuessCache::MakeKey(candidates, *distinct[d], lookahead_beam_),
+          {static_cast<uint32_t>(distinct_guesses[d]), distinct_scores[d]});
+    }
+    for (size_t i = 0; i < count; ++i) {
+      if (slot[i] != kNoIndex) {
+        guesses[i] = distinct_guesses[slot[i]];
+        scores[i] = distinct_scores[slot[i]];
+      }
+    }
+  }
+  if (entropies) {
+    *entropies = std::move(scores);
+  }
+  return guesses;
+}
+
+void WordleSolver::BatchSweep(
+    const std::vector<size_t>& candidates,
+    const std::vector<const std::vector<size_t>*>& sets,
+    std::vector<size_t>* guesses,
+    std::vector<double>* entropies) const {
+  const size_t set_count = sets.size();
+  const size_t candidate_count = candidates.size();
+
+  // Union of the sets' targets, each tagged with the sets holding it.
+  std::vector<uint64_t> membership(words_.size(), 0);
+  size_t largest = 0;
+  for (size_t s = 0; s < set_count; ++s) {
+    largest = std::max(largest, sets[s]->size());
+    for (size_t index : *sets[s]) {
+      membership[index] |= uint64_t{1} << s;
+    }
+  }
+  std::vector<size_t> union_targets;
+  std::vector<uint64_t> union_sets;
+  std::vector<uint32_t> union_letters;
+  for (size_t index = 0; index < membership.size(); ++index) {
+    if (membership[index] != 0) {
+      union_targets.push_back(index);
+      union_sets.push_back(membership[index]);
+      union_letters.push_back(words_.letters()[index]);
+    }
+  }
+  const size_t union_size = union_targets.size();
+
+  // Per-set bounds, exactly as BestGuessIndex computes them, and the same
+  // split-key merge: a guess that splits a set like an earlier candidate
+  // is dead for that set. Guesses are visited by their loosest bound over
+  // the sets they are alive for, so every set sees its strong guesses early.
+  std::vector<double> xlogx(largest + 1, 0.0);
+  for (size_t c = 2; c <= largest; ++c) {
+    double value = static_cast<double>(c);
+    xlogx[c] = value * std::log2(value);
+  }
+  std::vector<double> bounds(set_count * candidate_count);
+  std::vector<double> loosest(candidate_count,
+                              -std::numeric_limits<double>::infinity());
+  std::vector<uint64_t> dead(candidate_count, 0);
+  std::vector<WordTable> packed_targets(set_count);
+  for (size_t s = 0; s < set_count; ++s) {
+    if (pattern_matrix_.empty()) {
+      packed_targets[s].Assign(words_, *sets[s]);
+    }
+    const TargetLetters summary = SummarizeTargets(words_, *sets[s]);
+    const SplitKeys<Shape> split_key(summary);
+    SplitKeySet<SplitKeys<Shape>::Key> splits(
+        split_key.merges() ? candidate_count : 0);
+    for (size_t i = 0; i < candidate_count; ++i) {
+      const PackedWord guess = words_.packed(candidates[i]);
+      if (split_key.merges() && !splits.Insert(split_key(guess))) {
+        dead[i] |= uint64_t{1} << s;
+        continue;
+      }
+      const double bound = EntropyBound(guess, summary, xlogx, nullptr);
+      bounds[s * candidate_count + i] = bound;
+      loosest[i] = std::max(loosest[i], bound);
+    }
+  }
+  const uint64_t all_sets =
+      set_count == 64 ? ~uint64_t{0} : (uint64_t{1} << set_count) - 1;
+  std::vector<size_t> order;
+  order.reserve(candidate_count);
+  for (size_t i = 0; i < candidate_count; ++i) {
+    if (dead[i] != all_sets) {
+      order.push_back(i);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return loosest[a] > loosest[b];
+  });
+
+  std::vector<std::atomic<double>> shared_best(set_count);
+  for (auto& best : shared_best) {
+    best.store(-std::numeric_limits<double>::infinity(),
+               std::memory_order_relaxed);
+  }
+  using Best = std::vector<std::pair<double, size_t>>;
+  auto search = [&](size_t begin, size_t end) {
+    Best best(set_count, {-std::numeric_limits<double>::infinity(),
+                          candidate_count});
+    std::vector<std::array<int, kPatternCount>> counts(set_count);
+    std::vector<uint8_t> codes(std::max(union_size, largest));
+    for (size_t k = begin; k < end; ++k) {
+      const size_t position = order[k];
+      // Sets for which this guess can still win, by the same rule as the
+      // single-set search.
+      uint64_t live = 0;
+      for (size_t s = 0; s < set_count; ++s) {
+        if ((dead[position] >> s & 1U) == 0 &&
+            bounds[s * candidate_count + position] >=
+            shared_best[s].load(std::memory_order_relaxed) - kPruneSlack) {
+          live |= uint64_t{1} << s;
+        }
+      }
+      if (live == 0) {
+        continue;
+      }
+      const size_t guess_index = candidates[position];
+      const uint8_t* row = pattern_matrix_.empty()
+                               ? nullptr
+                               : pattern_matrix_.Row(guess_index);
+      size_t live_targets = 0;
+      for (uint64_t bits = live; bits != 0; bits &= bits - 1) {
+        const size_t s = static_cast<size_t>(std::countr_zero(bits));
+        counts[s].fill(0);
+        live_targets += sets[s]->size();
+      }
+      if (live_targets <= union_size) {
+        // The live sets overlap too little for a union pass to pay off.
+        for (uint64_t bits = live; bits != 0; bits &= bits - 1) {
+          const size_t s = static_cast<size_t>(std::countr_zero(bits));
+          const std::vector<size_t>& targets = *sets[s];
+          if (row) {
+            for (size_t index : targets) {
+              counts[s][row[index]]++;
+            }
+          } else {
+            PatternBatch(words_.packed(guess_index),
+                         packed_targets[s].letters(), targets.size(),
+                         codes.data());
+            PatternTally tally(&counts[s], targets.size());
+            tally.Add(codes.data(), targets.size());
+            tally.Fold();
+          }
+        }
+      } else {
+        if (row) {
+          for (size_t j = 0; j < union_size; ++j) {
+            codes[j] = row[union_targets[j]];
+          }
+        } else {
+          PatternBatch(words_.packed(guess_index), union_letters.data(),
+                       union_size, codes.data());
+        }
+        for (size_t j = 0; j < union_size; ++j) {
+          for (uint64_t bits = union_sets[j] & live; bits != 0;
+               bits &= bits - 1) {
+            counts[static_cast<size_t>(std::countr_zero(bits))][codes[j]]++;
+          }
+        }
+      }
+      for (uint64_t bits = live; bits != 0; bits &= bits - 1) {
+        const size_t s = static_cast<size_t>(std::countr_zero(bits));
+        const double entropy = EntropyFromCounts(counts[s], sets[s]->size());
+        if (entropy > best[s].first ||
+            (entropy == best[s].first && position < best[s].second)) {
+          best[s] = {entropy, position};
+        }
+        AtomicMax(&shared_best[s], entropy);
+      }
+    }
+    return best;
+  };
+  auto merge = [](Best a, const Best& b) {
+    for (size_t s = 0; s < a.size(); ++s) {
+      if (b[s].first > a[s].first ||
+          (b[s].first == a[s].first && b[s].second < a[s].second)) {
+        a[s] = b[s];
+      }
     }
+    return a;
+  };
+  const Best best = ThreadPool::Instance().ParallelReduce(
+      0, order.size(), kGuessGrain,
+      Best(set_count,
+           {-std::numeric_limits<double>::infinity(), candidate_count}),
+      search, merge);
+
+  guesses->resize(set_count);
+  entropies->resize(set_count);
+  for (size_t s = 0; s < set_count; ++s) {
+    (*guesses)[s] = candidates[best[s].second];
+    (*entropies)[s] = best[s].first;
   }
+}
 
-  uint32_t target_mask = target.mask;
-  for (int i = 0; i < kWordLen; ++i) {
-    if (result[i] != 0) {
+size_t WordleSolver::MultiGuessIndex(
+    const std::vector<size_t>& candidates,
+    const std::vector<std::vector<size_t>>& boards,
+    double* entropy_out) const {
+  if (entropy_out) {
+    *entropy_out = 0.0;
+  }
+  if (candidates.empty()) {
+    return kNoIndex;
+  }
+  if (boards.size() > kMaxBoards) {
+    return kNoIndex;
+  }
+  // Boards with the same remaining set share one histogram, weighted by
+  // how many of them there are.
+  std::vector<const std::vector<size_t>*> active;
+  std::vector<double> weights;
+  for (const auto& board : boards) {
+    if (board.size() < 2) {
       continue;
     }
-    uint8_t letter = guess_letters[i];
-    if ((target_mask & (1U << letter)) == 0) {
-      continue;
+    size_t b = 0;
+    while (b < active.size() && *active[b] != board) {
+      ++b;
     }
-    if (counts[letter] > 0) {
-      result[i] = 1;
-      counts[letter]--;
+    if (b == active.size()) {
+      active.push_back(&board);
+      weights.push_back(0.0);
     }
+    weights[b] += 1.0;
   }
-
-  int pattern = 0;
-  int base = 1;
-  for (int i = 0; i < kWordLen; ++i) {
-    pattern += result[i] * base;
-    base *= 3;
+  if (active.empty()) {
+    return candidates[0];
   }
-  return pattern;
-}
-
-std::string WordleSolver::PatternString(int pattern) {
-  std::string out(kWordLen, '0');
-  for (int i = 0; i < kWordLen; ++i) {
-    out[i] = static_cast<char>('0' + (pattern % 3));
-    pattern /= 3;
+  if (active.size() == 1) {
+    // Typically the opening, where every board is still the dictionary.
+    size_t guess = BestGuessIndex(candidates, *active[0], entropy_out);
+    if (entropy_out) {
+      *entropy_out *= weights[0];
+    }
+    return guess;
   }
-  return out;
-}
 
-bool WordleSolver::IsConsistent(std::string_view candidate,
-                                std::string_view guess,
-                                std::string_view pattern) {
-  if (candidate.size() != kWordLen || guess.size() != kWordLen ||
-      pattern.size() != kWordLen) {
-    return false;
+  // Union of the boards' targets, each tagged with the boards holding it.
+  // A guess's pattern row is computed once over the union and every code
+  // is added to the histogram of each board in its tag.
+  std::vector<uint64_t> membership(words_.size(), 0);
+  for (size_t b = 0; b < active.size(); ++b) {
+    for (size_t index : *active[b]) {
+      membership[index] |= uint64_t{1} << b;
+    }
   }
-
-  std::array<int, kAlphabet> target_counts{};
-  target_counts.fill(0);
-
-  for (int i = 0; i < kWordLen; ++i) {
-    char p = pattern[i];
-    if (p == '2') {
-      if (candidate[i] != guess[i]) {
-        return false;
-      }
-    } else if (p == '0' || p == '1') {
-      char c = candidate[i];
-      if (c < 'a' || c > 'z') {
-        return false;
-      }
-      target_counts[c - 'a']++;
-    } else {
-      return false;
+  std::vector<size_t> union_targets;
+  std::vector<uint64_t> union_boards;
+  std::vector<uint32_t> union_letters;
+  for (size_t index = 0; index < membership.size(); ++index) {
+    if (membership[index] != 0) {
+      union_targets.push_back(index);
+      union_boards.push_back(membership[index]);
+      union_letters.push_back(words_.letters()[index]);
     }
   }
+  const size_t board_count = active.size();
+  const size_t union_size = union_targets.size();
 
-  for (int i = 0; i < kWordLen; ++i) {
-    char p = pattern[i];
-    if (p == '2') {
-      continue;
-    }
-    char g = guess[i];
-    if (g < 'a' || g > 'z') {
-      return false;
+  // Branch and bound as in BestGuessIndex: the weighted sum of a guess's
+  // per-board bounds caps its score, so guesses are visited from the
+  // loosest bound down and skipped once a scored guess beats their bound.
+  size_t largest = 0;
+  for (const auto* board : active) {
+    largest = std::max(largest, board->size());
+  }
+  std::vector<double> xlogx(largest + 1, 0.0);
+  for (size_t c = 2; c <= largest; ++c) {
+    double value = static_cast<double>(c);
+    xlogx[c] = value * std::log2(value);
+  }
+  std::vector<double> bounds(candidates.size(), 0.0);
+  for (size_t b = 0; b < board_count; ++b) {
+    const TargetLetters summary = SummarizeTargets(words_, *active[b]);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      bounds[i] += weights[b] * EntropyBound(words_.packed(candidates[i]),
+                                             summary, xlogx, nullptr);
     }
-    int letter_index = g - 'a';
-    if (p == '1') {
-      if (candidate[i] == g) {
-        return false;
+  }
+  std::vector<size_t> order(candidates.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return bounds[a] > bounds[b];
+  });
+  std::atomic<double> shared_best(-std::numeric_limits<double>::infinity());
+
+  using Best = std::pair<double, size_t>;
+  auto search = [&](size_t begin, size_t end) {
+    Best best(-std::numeric_limits<double>::infinity(), candidates.size());
+    std::vector<std::array<int, kPatternCount>> counts(board_count);
+    std::vector<uint8_t> codes(union_size);
+    for (size_t k = begin; k < end; ++k) {
+      const size_t i = order[k];
+      if (bounds[i] <
+          shared_best.load(std::memory_order_relaxed) - kPruneSlack) {
+        continue;
       }
-      if (target_counts[letter_index] > 0) {
-        target_counts[letter_index]--;
+      const size_t guess_index = candidates[i];
+      if (!pattern_matrix_.empty()) {
+        const uint8_t* row = pattern_matrix_.Row(guess_index);
+        for (size_t j = 0; j < union_size; ++j) {
+          codes[j] = row[union_targets[j]];
+        }
       } else {
-        return false;
+        PatternBatch(words_.packed(guess_index), union_letters.data(),
+                     union_size, codes.data());
       }
-    } else {
-      if (target_counts[letter_index] > 0) {
-        return false;
+      for (auto& board_counts : counts) {
+        board_counts.fill(0);
+      }
+      for (size_t j = 0; j < union_size; ++j) {
+        uint64_t bits = union_boards[j];
+        while (bits != 0) {
+          counts[static_cast<size_t>(std::countr_zero(bits))][codes[j]]++;
+          bits &= bits - 1;
+        }
+      }
+      double entropy = 0.0;
+      for (size_t b = 0; b < board_count; ++b) {
+        entropy += weights[b] * EntropyFromCounts(counts[b], active[b]->size());
       }
+      if (entropy > best.first ||
+          (entropy == best.first && i < best.second)) {
+        best = Best(entropy, i);
+      }
+      AtomicMax(&shared_best, entropy);
     }
+    return best;
+  };
+
+  // Ties go to the earliest candidate, whatever order the chunks ran in.
+  const auto [best_entropy, best_position] =
+      ThreadPool::Instance().ParallelReduce(
+          0, order.size(), kGuessGrain,
+          Best(-std::numeric_limits<double>::infinity(), candidates.size()),
+          search, [](const Best& a, const Best& b) {
+            return b.first > a.first ||
+                           (b.first == a.first && b.second < a.second)
+                       ? b
+                       : a;
+          });
+
+  if (entropy_out) {
+    *entropy_out = best_entropy;
   }
+  return candidates[best_position];
+}
 
-  return true;
+std::string WordleSolver::BestMultiGuess(
+    const std::vector<size_t>& candidates,
+    const std::vector<std::vector<size_t>>& boards,
+    double* entropy_out) const {
+  size_t index = MultiGuessIndex(candidates, boards, entropy_out);
+  return index == kNoIndex ? std::string() : std::string(words_.text(index));
 }
 
-void WordleSolver::FilterCandidates(const std::vector<WordEntry>& words,
-                                    const std::vector<size_t>& remaining,
-                                    std::string_view guess,
-                                    std::string_view pattern,
-                                    std::vector<size_t>* out) {
-  if (!out) {
-    return;
-  }
-  out->clear();
-  if (guess.size() != kWordLen || pattern.size() != kWordLen) {
-    return;
+WordleSolver::MultiGameResult WordleSolver::SolveMultiToTargets(
+    const std::vector<std::string>& targets,
+    size_t max_steps) const {
+  MultiGameResult result;
+  if (words_.empty() || targets.empty() || targets.size() > kMaxBoards) {
+    return result;
   }
-
-  uint32_t green_mask = 0;
-  for (int i = 0; i < kWordLen; ++i) {
-    if (pattern[i] == '2') {
-      green_mask |= kLetterMask << (i * kLetterBits);
+  std::vector<PackedWord> packed;
+  for (const std::string& target : targets) {
+    std::string normalized = NormalizeWord(target);
+    if (!IsValidWord(normalized)) {
+      return result;
     }
+    result.targets.push_back(normalized);
+    packed.push_back(EncodeWord(normalized));
   }
 
-  if (remaining.empty()) {
-    return;
-  }
-
-#if defined(ALETHEIA_USE_HWY)
-  if (green_mask != 0 && SimdEnabled()) {
-    namespace hn = hwy::HWY_NAMESPACE;
+  const size_t board_count = targets.size();
+  std::vector<size_t> all_indices(words_.size());
+  std::iota(all_indices.begin(), all_indices.end(), 0);
+  std::vector<std::vector<size_t>> boards(board_count, all_indices);
+  result.solved_turn.assign(board_count, 0);
+  size_t unsolved = board_count;
+  std::vector<size_t> next;
 
-    const PackedWord guess_packed = EncodeWord(guess);
-    const uint32_t green_bits = guess_packed.letters & green_mask;
+  for (size_t turn = 0; turn < max_steps && unsolved > 0; ++turn) {
+    auto start = std::chrono::steady_clock::now();
+    // A board narrowed to one word is worth a guess of its own: it solves
+    // that board now and still informs the others.
+    std::vector<size_t> forced;
+    for (size_t b = 0; b < board_count; ++b) {
+      if (result.solved_turn[b] == 0 && boards[b].size() == 1) {
+        forced.push_back(boards[b][0]);
+        break;
+      }
+    }
+    double entropy = 0.0;
+    const size_t guess_index = MultiGuessIndex(
+        forced.empty() ? all_indices : forced, boards, &entropy);
+    const PackedWord guess = words_.packed(guess_index);
 
-    const hn::ScalableTag<uint32_t> d;
-    const size_t lanes = hn::Lanes(d);
-    if (lanes > 1) {
-      std::vector<uint32_t> packed(lanes);
-      std::vector<uint32_t> pass(lanes);
-      std::vector<size_t> indices(lanes);
-
-      size_t offset = 0;
-      while (offset < remaining.size()) {
-        size_t batch = 0;
-        for (; batch < lanes && (offset + batch) < remaining.size(); ++batch) {
-          size_t index = remaining[offset + batch];
-          indices[batch] = index;
-          packed[batch] = words[index].packed.letters;
-        }
-        for (; batch < lanes; ++batch) {
-          indices[batch] = static_cast<size_t>(-1);
-          packed[batch] = 0;
-        }
-
-        auto v = hn::LoadU(d, packed.data());
-        auto masked = hn::And(v, hn::Set(d, green_mask));
-        auto cmp = hn::Eq(masked, hn::Set(d, green_bits));
-        auto pass_vec = hn::IfThenElse(cmp, hn::Set(d, 1u), hn::Zero(d));
-        hn::StoreU(pass_vec, d, pass.data());
-
-        for (size_t lane = 0; lane < lanes; ++lane) {
-          size_t index = indices[lane];
-          if (index == static_cast<size_t>(-1)) {
-            continue;
-          }
-          if (pass[lane] == 0) {
-            continue;
-          }
-          if (IsConsistent(words[index].text, guess, pattern)) {
-            out->push_back(index);
-          }
+    std::vector<std::string> patterns(board_count);
+    for (size_t b = 0; b < board_count; ++b) {
+      if (result.solved_turn[b] != 0) {
+        continue;
+      }
+      const int pattern = Pattern(guess, packed[b]);
+      patterns[b] = PatternString(pattern);
+      if (pattern == kSolvedPattern) {
+        result.solved_turn[b] = turn + 1;
+        boards[b].clear();
+        --unsolved;
+        continue;
+      }
+      next.clear();
+      for (size_t index : boards[b]) {
+        if (PatternAt(guess_index, index) == pattern) {
+          next.push_back(index);
         }
-        offset += lanes;
       }
-      return;
+      boards[b].swap(next);
     }
+    auto end = std::chrono::steady_clock::now();
+
+    result.guesses.emplace_back(words_.text(guess_index));
+    result.patterns.push_back(std::move(patterns));
+    result.entropies.push_back(entropy);
+    result.step_ms.push_back(
+        std::chrono::duration<double, std::milli>(end - start).count());
   }
-#endif
+  result.solved = unsolved == 0;
+  return result;
+}
 
-  for (size_t index : remaining) {
-    if (IsConsistent(words[index].text, guess, pattern)) {
-      out->push_back(index);
+template <int kLength, int kAlphabetSize>
+BasicWordleSolver<kLength, kAlphabetSize>::BasicWordleSolver(
+    std::string_view alphabet) {
+  letter_index_.fill(-1);
+  if (alphabet.size() != static_cast<size_t>(kAlphabetSize)) {
+    return;
+  }
+  for (size_t i = 0; i < alphabet.size(); ++i) {
+    int16_t& slot = letter_index_[static_cast<unsigned char>(alphabet[i])];
+    if (slot >= 0) {
+      letter_index_.fill(-1);
+      return;
     }
+    slot = static_cast<int16_t>(i);
   }
+  alphabet_valid_ = true;
 }
 
-size_t WordleSolver::BestGuessIndex(const std::vector<size_t>& candidates,
-                                    const std::vector<size_t>& targets,
-                                    double* entropy_out) const {
-  if (candidates.empty()) {
-    if (entropy_out) {
-      *entropy_out = 0.0;
+template <int kLength, int kAlphabetSize>
+bool BasicWordleSolver<kLength, kAlphabetSize>::LoadDictionary(
+    const std::string& path) {
+  std::ifstream infile(path);
+  if (!infile) {
+    return false;
+  }
+  std::vector<std::string> words;
+  std::string line;
+  while (std::getline(infile, line)) {
+    words.push_back(line);
+  }
+  SetWordList(words);
+  return !words_.empty();
+}
+
+template <int kLength, int kAlphabetSize>
+void BasicWordleSolver<kLength, kAlphabetSize>::SetWordList(
+    const std::vector<std::string>& words) {
+  words_.clear();
+  table_.Clear();
+  index_by_letters_.clear();
+  if (!alphabet_valid_) {
+    return;
+  }
+  words_.reserve(words.size());
+  for (const auto& word : words) {
+    std::string normalized = NormalizeWord(word);
+    if (!IsValidWord(normalized)) {
+      continue;
     }
-    return 0;
+    const Letters letters = EncodeWord(normalized).letters;
+    if (!index_by_letters_.emplace(letters, words_.size()).second) {
+      continue;
+    }
+    words_.push_back(std::move(normalized));
+  }
+  // The table views words_, which no longer moves.
+  table_.Reserve(words_.size());
+  for (const auto& word : words_) {
+    table_.PushBack(EncodeWord(word), word);
   }
-  double best_entropy = -std::numeric_limits<double>::infinity();
-  size_t best_index = candidates[0];
+}
 
-#ifdef _OPENMP
-#pragma omp parallel
-  {
-    double local_best_entropy = -std::numeric_limits<double>::infinity();
-    size_t local_best_index = candidates[0];
+template <int kLength, int kAlphabetSize>
+size_t BasicWordleSolver<kLength, kAlphabetSize>::IndexOf(
+    std::string_view word) const {
+  if (!IsValidWord(word)) {
+    return kNoIndex;
+  }
+  auto it = index_by_letters_.find(EncodeWord(word).letters);
+  return it == index_by_letters_.end() ? kNoIndex : it->second;
+}
 
-#pragma omp for schedule(static)
-    for (size_t i = 0; i < candidates.size(); ++i) {
-      size_t guess_index = candidates[i];
-      double entropy = EntropyForGuess(guess_index, targets);
-      if (entropy > local_best_entropy) {
-        local_best_entropy = entropy;
-        local_best_index = guess_index;
-      }
+template <int kLength, int kAlphabetSize>
+bool BasicWordleSolver<kLength, kAlphabetSize>::IsValidWord(
+    std::string_view word) const {
+  if (word.size() != static_cast<size_t>(kLength)) {
+    return false;
+  }
+  for (char c : word) {
+    if (letter_index_[static_cast<unsigned char>(c)] < 0) {
+      return false;
     }
+  }
+  return true;
+}
 
-#pragma omp critical
-    {
-      if (local_best_entropy > best_entropy) {
-        best_entropy = local_best_entropy;
-        best_index = local_best_index;
-      }
+template <int kLength, int kAlphabetSize>
+std::string BasicWordleSolver<kLength, kAlphabetSize>::NormalizeWord(
+    std::string_view word) const {
+  std::string normalized;
+  normalized.reserve(word.size());
+  for (char c : word) {
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
     }
-  }
-#else
-  for (size_t guess_index : candidates) {
-    double entropy = EntropyForGuess(guess_index, targets);
-    if (entropy > best_entropy) {
-      best_entropy = entropy;
-      best_index = guess_index;
+    if (letter_index_[static_cast<unsigned char>(c)] >= 0) {
+      normalized.push_back(c);
     }
   }
-#endif
+  return normalized;
+}
 
-  if (entropy_out) {
-    *entropy_out = best_entropy;
+template <int kLength, int kAlphabetSize>
+typename BasicWordleSolver<kLength, kAlphabetSize>::Packed
+BasicWordleSolver<kLength, kAlphabetSize>::EncodeWord(
+    std::string_view word) const {
+  Packed packed;
+  for (int i = 0; i < kLength; ++i) {
+    Letters letter = static_cast<Letters>(
+        letter_index_[static_cast<unsigned char>(word[i])]);
+    packed.letters |= letter << (i * kLetterBits);
+    packed.mask |= LetterMask{1} << letter;
   }
-  return best_index;
+  return packed;
 }
 
-double WordleSolver::EntropyForGuess(
+template <int kLength, int kAlphabetSize>
+std::array<int, BasicWordleSolver<kLength, kAlphabetSize>::kPatternCount>
+BasicWordleSolver<kLength, kAlphabetSize>::PatternCounts(
     size_t guess_index,
     const std::vector<size_t>& targets) const {
-  if (targets.empty()) {
-    return 0.0;
-  }
-  auto counts = PatternCounts(guess_index, targets);
-  double entropy = 0.0;
-  const double inv_total = 1.0 / static_cast<double>(targets.size());
-  for (int count : counts) {
-    if (count == 0) {
-      continue;
-    }
-    double p = count * inv_total;
-    entropy -= p * std::log2(p);
-  }
-  return entropy;
+  return GuessSearch<Shape>(table_, nullptr)
+      .PatternCounts(guess_index, targets, nullptr);
 }
 
-std::array<int, WordleSolver::kPatternCount> WordleSolver::PatternCounts(
+template <int kLength, int kAlphabetSize>
+void BasicWordleSolver<kLength, kAlphabetSize>::FilterCandidates(
+    const std::vector<size_t>& remaining,
     size_t guess_index,
-    const std::vector<size_t>& targets) const {
-  std::array<int, kPatternCount> counts{};
-  counts.fill(0);
-  const PackedWord& guess = words_[guess_index].packed;
-  for (size_t target_index : targets) {
-    const PackedWord& target = words_[target_index].packed;
-    int pattern = Pattern(guess, target);
-    counts[pattern]++;
+    int pattern,
+    std::vector<size_t>* out) const {
+  out->clear();
+  constexpr size_t kBatch = 256;
+  std::array<Letters, kBatch> letters;
+  std::array<PatternCode, kBatch> codes;
+  const Packed guess = table_.packed(guess_index);
+  for (size_t offset = 0; offset < remaining.size(); offset += kBatch) {
+    const size_t batch = std::min(kBatch, remaining.size() - offset);
+    for (size_t i = 0; i < batch; ++i) {
+      letters[i] = table_.letters()[remaining[offset + i]];
+    }
+    Shape::PatternBatch(guess, letters.data(), batch, codes.data());
+    for (size_t i = 0; i < batch; ++i) {
+      if (codes[i] == pattern) {
+        out->push_back(remaining[offset + i]);
+      }
+    }
   }
-  return counts;
 }
 
-std::string WordleSolver::BestGuess(const std::vector<size_t>& candidates,
-                                    const std::vector<size_t>& targets,
-                                    double* entropy_out) const {
-  size_t best_index = BestGuessIndex(candidates, targets, entropy_out);
+template <int kLength, int kAlphabetSize>
+size_t BasicWordleSolver<kLength, kAlphabetSize>::BestGuessIndex(
+    const std::vector<size_t>& candidates,
+    const std::vector<size_t>& targets,
+    double* entropy_out,
+    SearchStats* stats) const {
   if (candidates.empty()) {
-    return {};
+    if (entropy_out) {
+      *entropy_out = 0.0;
+    }
+    return kNoIndex;
   }
-  return std::string(words_[best_index].text);
+  size_t guess = 0;
+  GuessSearch<Shape>(table_, nullptr)
+      .Run(candidates, targets, WordleSolver::SearchLimits{}, &guess,
+           entropy_out, stats);
+  return guess;
 }
 
-std::vector<WordleSolver::Step> WordleSolver::SolveToTarget(
+template <int kLength, int kAlphabetSize>
+std::string BasicWordleSolver<kLength, kAlphabetSize>::BestGuess(
+    const std::vector<size_t>& candidates,
+    const std::vector<size_t>& targets,
+    double* entropy_out,
+    SearchStats* stats) const {
+  size_t index = BestGuessIndex(candidates, targets, entropy_out, stats);
+  return index == kNoIndex ? std::string() : words_[index];
+}
+
+template <int kLength, int kAlphabetSize>
+std::vector<typename BasicWordleSolver<kLength, kAlphabetSize>::Step>
+BasicWordleSolver<kLength, kAlphabetSize>::SolveToTarget(
     const std::string& target,
     size_t max_steps) const {
   std::vector<Step> steps;
-  if (words_.empty()) {
-    return steps;
-  }
-
   std::string normalized = NormalizeWord(target);
-  if (!IsValidWord(normalized)) {
+  if (words_.empty() || !IsValidWord(normalized)) {
     return steps;
   }
-  PackedWord target_packed = EncodeWord(normalized);
+  const Packed target_packed = EncodeWord(normalized);
 
   std::vector<size_t> remaining(words_.size());
   std::iota(remaining.begin(), remaining.end(), 0);
   std::vector<size_t> next;
-  next.reserve(remaining.size());
-
   for (size_t step = 0; step < max_steps && !remaining.empty(); ++step) {
     double entropy = 0.0;
-    size_t best_index = BestGuessIndex(remaining, remaining, &entropy);
-    const PackedWord& guess = words_[best_index].packed;
-    int pattern = Pattern(guess, target_packed);
-    auto counts = PatternCounts(best_index, remaining);
-
-    int pattern_count = counts[pattern];
-    double info_bits = 0.0;
-    if (pattern_count > 0) {
-      double p = static_cast<double>(pattern_count) /
-                 static_cast<double>(remaining.size());
-      info_bits = -std::log2(p);
-    }
-
-    next.clear();
-    if (next.capacity() < remaining.size()) {
-      next.reserve(remaining.size());
-    }
-    for (size_t index : remaining) {
-      if (Pattern(guess, words_[index].packed) == pattern) {
-        next.push_back(index);
-      }
-    }
+    const size_t best_index = BestGuessIndex(remaining, remaining, &entropy);
+    const int pattern = Pattern(table_.packed(best_index), target_packed);
+    FilterCandidates(remaining, best_index, pattern, &next);
 
     Step entry;
-    entry.guess = words_[best_index].text;
+    entry.guess = words_[best_index];
     entry.pattern = PatternString(pattern);
     entry.entropy = entropy;
-    entry.info_bits = info_bits;
+    if (!next.empty()) {
+      entry.info_bits = -std::log2(static_cast<double>(next.size()) /
+                                   static_cast<double>(remaining.size()));
+    }
     entry.remaining = remaining.size();
     entry.remaining_after = next.size();
     steps.push_back(std::move(entry));
@@ -477,8 +4686,13 @@ std::vector<WordleSolver::Step> WordleSolver::SolveToTarget(
     }
     remaining.swap(next);
   }
-
   return steps;
 }
 
+template class BasicWordleSolver<4>;
+template class BasicWordleSolver<5>;
+template class BasicWordleSolver<6>;
+template class BasicWordleSolver<7>;
+template class BasicWordleSolver<8>;
+
 }  // namespace aletheia
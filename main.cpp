@@ -6,30 +6,63 @@
 #include <cmath>
 #include <cctype>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <numeric>
+#include <optional>
 #include <random>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define ALETHEIA_HAS_POLL 1
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 namespace {
 struct Config {
   std::string wordle_dict;
   std::string wordle_target;
   size_t wordle_max_steps = 6;
+  bool wordle_max_steps_set = false;
   bool wordle_interactive = false;
   bool wordle_adversarial = false;
   bool wordle_profile = false;
   bool wordle_hard = false;
+  bool wordle_pattern_matrix = false;
+  std::string wordle_pattern_cache;
+  std::string wordle_book;
+  std::string wordle_build_book;
+  std::string wordle_solve_all;
+  std::string wordle_optimal;
+  size_t wordle_optimal_limit = 0;
+  size_t wordle_lookahead = 0;
+  size_t wordle_deadline_ms = 0;
+  size_t wordle_speculate = 0;
+  int wordle_length = 5;
+  size_t wordle_boards = 1;
+  size_t wordle_cache = 0;
+  std::string wordle_cache_file;
+  std::string wordle_report;
   std::string connections_words;
   std::string embeddings_path;
   std::string embeddings_format = "word2vec";
   bool allow_fallback = false;
+  size_t threads = 0;
+  bool pin_threads = false;
+  bool serve = false;
+  std::string serve_socket;
+  size_t serve_workers = 0;
+  size_t serve_queue = 256;
   std::string connections_dot;
   int connections_pca_dims = 2;
   size_t connections_red_herrings = 3;
@@ -51,16 +84,56 @@ void PrintUsage(const char* argv0) {
       << "  " << argv0
       << " --wordle-dict WORDS.txt --interactive --adversarial\n"
       << "  " << argv0
+      << " --wordle-dict WORDS.txt --wordle-solve-all TARGETS.txt "
+         "[--wordle-report REPORT.json]\n"
+      << "  " << argv0
       << " --connections-words WORDS16.txt --embeddings VECTORS.bin "
          "[--embeddings-format word2vec|text]\n"
       << "Options:\n"
       << "  --wordle-dict PATH         5-letter dictionary (one word per line)\n"
       << "  --wordle-target WORD       Target word for solution path or auto feedback\n"
       << "  --wordle-max-steps N       Max guesses to simulate (default 6)\n"
+      << "  --wordle-length N          Word length, 4-8 (default 5; other lengths\n"
+      << "                             support --wordle-target and the best guess)\n"
       << "  --interactive              Interactive Wordle loop using feedback\n"
-      << "  --adversarial              Absurdle-style mode (auto pattern, worst case)\n"
+      << "  --adversarial              Absurdle-style mode: minimax guesses against\n"
+      << "                             an adversary choosing the hardest pattern\n"
       << "  --profile                  Log allocation vs compute timing per turn\n"
       << "  --wordle-hard              Enforce Wordle hard mode in interactive play\n"
+      << "  --pattern-matrix           Precompute the guess x target pattern matrix\n"
+      << "  --pattern-cache PATH       Map the pattern matrix from PATH (built and\n"
+      << "                             saved there on first use)\n"
+      << "  --wordle-book PATH         Follow a saved decision tree before searching\n"
+      << "  --wordle-build-book PATH   Build the greedy decision tree (hard mode with\n"
+      << "                             --wordle-hard, depth --wordle-max-steps)\n"
+      << "  --wordle-optimal MODE      Search the optimal policy (expected|worst)\n"
+      << "                             and play it; saved by --wordle-build-book\n"
+      << "  --wordle-optimal-limit N   Only try the N best-entropy guesses per state\n"
+      << "                             (faster, not provably optimal; also applies\n"
+      << "                             to --adversarial)\n"
+      << "  --wordle-boards N          Play N boards at once (Quordle: 4); targets\n"
+      << "                             are comma-separated, solve-all groups N\n"
+      << "                             targets per game (default max steps N+5)\n"
+      << "  --wordle-lookahead K       Rescore the K best guesses with a second ply\n"
+      << "  --wordle-deadline-ms N     Answer interactive suggestions within N ms,\n"
+      << "                             falling back to the best guess found so far\n"
+      << "  --speculate N              While waiting for feedback, precompute the\n"
+      << "                             next suggestion for the N likeliest patterns\n"
+      << "  --wordle-cache N           Reuse chosen guesses for up to N repeated states\n"
+      << "  --wordle-cache-file PATH   Load the guess cache from PATH and save it on\n"
+      << "                             exit (default 65536 entries)\n"
+      << "  --wordle-solve-all PATH    Solve every target in PATH in one process\n"
+      << "  --wordle-report PATH       Write the --wordle-solve-all JSON report\n"
+      << "  --serve                    Answer JSON-lines requests on stdin/stdout\n"
+      << "                             with the dictionary and embeddings loaded\n"
+      << "                             once (see README for the protocol)\n"
+      << "  --serve-socket PATH        Serve on a UNIX domain socket instead\n"
+      << "  --serve-workers N          Request workers (default: --threads)\n"
+      << "  --serve-queue N            Requests queued per worker before reading\n"
+      << "                             pauses (default 256)\n"
+      << "  --threads N                Worker threads including the caller\n"
+      << "                             (default: hardware concurrency)\n"
+      << "  --pin-threads              Pin each worker thread to one CPU\n"
       << "  --connections-words PATH   16 words for Connections (whitespace or line-separated)\n"
       << "  --connections-demo         Use the built-in demo puzzle + categories\n"
       << "  --connections-shuffle      Shuffle word order for display each run\n"
@@ -130,20 +203,6 @@ std::vector<std::string> LoadWordList(const std::string& path) {
   return words;
 }
 
-Eigen::VectorXd FallbackEmbedding(const std::string& word, int dims) {
-  Eigen::VectorXd vec(dims);
-  uint64_t hash = 1469598103934665603ULL;
-  for (char c : word) {
-    hash ^= static_cast<uint64_t>(c);
-    hash *= 1099511628211ULL;
-  }
-  for (int i = 0; i < dims; ++i) {
-    double value = static_cast<double>((hash >> (i * 3)) & 0xFFFF);
-    vec[i] = std::sin(value * 0.001 + static_cast<double>(i));
-  }
-  return vec;
-}
-
 bool IsPatternOnly(const std::string& input) {
   if (input.size() != 5) {
     return false;
@@ -172,6 +231,36 @@ bool ParsePatternString(const std::string& pattern_str, int* pattern_out) {
   return true;
 }
 
+// Waits for a background suggestion. On a terminal the user may type ahead:
+// a line that needs no suggestion (a guess, or a guess and pattern)
+// supersedes it, so the search is cancelled. Returns true with that line,
+// or with a line that does need the suggestion once it has arrived.
+bool AwaitSuggestion(aletheia::GuessFuture* pending, std::string* line) {
+#if defined(ALETHEIA_HAS_POLL)
+  if (::isatty(STDIN_FILENO)) {
+    while (!pending->WaitFor(std::chrono::milliseconds(1))) {
+      pollfd input{STDIN_FILENO, POLLIN, 0};
+      if (::poll(&input, 1, 0) <= 0) {
+        continue;
+      }
+      if (!std::getline(std::cin, *line)) {
+        return false;
+      }
+      *line = TrimWhitespace(*line);
+      if (!line->empty() && !IsPatternOnly(*line)) {
+        pending->Cancel();
+        return true;
+      }
+      pending->Get();
+      return true;
+    }
+  }
+#endif
+  (void)line;
+  pending->Get();
+  return false;
+}
+
 void PrintInteractiveHelp() {
   std::cout
       << "Interactive commands:\n"
@@ -793,15 +882,24 @@ void RunConnectionsInteractive(
 }
 
 int SelectAdversarialPattern(
-    const aletheia::PackedWord& guess,
+    const aletheia::WordleSolver& wordle,
+    const std::string& guess,
     const std::vector<size_t>& remaining,
-    const std::vector<aletheia::WordEntry>& words,
     int* count_out) {
-  std::array<int, 243> counts{};
+  std::array<int, aletheia::WordleSolver::kPatternCount> counts{};
   counts.fill(0);
-  for (size_t index : remaining) {
-    int pattern = aletheia::WordleSolver::Pattern(guess, words[index].packed);
-    counts[pattern]++;
+  size_t guess_index = wordle.IndexOf(guess);
+  if (guess_index != aletheia::WordleSolver::kNoIndex) {
+    counts = wordle.PatternCounts(guess_index, remaining);
+  } else {
+    const aletheia::PackedWord guess_packed =
+        aletheia::WordleSolver::EncodeWord(guess);
+    const auto& words = wordle.words();
+    for (size_t index : remaining) {
+      int pattern =
+          aletheia::WordleSolver::Pattern(guess_packed, words.packed(index));
+      counts[pattern]++;
+    }
   }
 
   int best_pattern = 0;
@@ -843,6 +941,489 @@ int SelectAdversarialPattern(
   }
   return best_pattern;
 }
+
+double Percentile(std::vector<double> values, double pct) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  double rank = std::ceil(pct / 100.0 * static_cast<double>(values.size()));
+  size_t index = rank < 1.0 ? 0 : static_cast<size_t>(rank) - 1;
+  return values[std::min(index, values.size() - 1)];
+}
+
+// One finished game as the solve-all reports see it.
+struct GameRecord {
+  bool solved = false;
+  size_t guesses = 0;
+  std::vector<double> step_ms;
+};
+
+// Win rate, guess distribution and latency over a solve-all run, shared by
+// the single- and multi-board modes.
+struct SolveAllStats {
+  size_t count = 0;
+  size_t solved = 0;
+  size_t failed = 0;
+  size_t max_guesses = 0;
+  double win_rate = 0.0;
+  double average_guesses = 0.0;
+  double total_ms = 0.0;
+  // distribution[g]: games solved in g guesses. Entries below
+  // first_bucket cannot occur (one guess per board at least).
+  std::vector<size_t> distribution;
+  size_t first_bucket = 1;
+  std::vector<std::vector<double>> turn_ms;
+  // Summed step latency of each solved game.
+  std::vector<double> game_ms;
+};
+
+SolveAllStats SummarizeGames(const std::vector<GameRecord>& games,
+                             size_t max_steps,
+                             size_t first_bucket,
+                             double total_ms) {
+  SolveAllStats stats;
+  stats.count = games.size();
+  stats.first_bucket = first_bucket;
+  stats.total_ms = total_ms;
+  stats.distribution.assign(max_steps + 1, 0);
+  stats.turn_ms.resize(max_steps);
+  size_t guess_total = 0;
+  for (const auto& game : games) {
+    for (size_t turn = 0; turn < game.step_ms.size(); ++turn) {
+      stats.turn_ms[turn].push_back(game.step_ms[turn]);
+    }
+    if (!game.solved) {
+      continue;
+    }
+    ++stats.solved;
+    guess_total += game.guesses;
+    stats.max_guesses = std::max(stats.max_guesses, game.guesses);
+    stats.distribution[game.guesses]++;
+    stats.game_ms.push_back(
+        std::accumulate(game.step_ms.begin(), game.step_ms.end(), 0.0));
+  }
+  stats.failed = stats.count - stats.solved;
+  stats.win_rate =
+      static_cast<double>(stats.solved) / static_cast<double>(stats.count);
+  stats.average_guesses =
+      stats.solved > 0 ? static_cast<double>(guess_total) / stats.solved
+                       : 0.0;
+  return stats;
+}
+
+void PrintSolveAllStats(const SolveAllStats& stats) {
+  std::cout << "Win rate: " << std::fixed << std::setprecision(2)
+            << stats.win_rate * 100.0 << "% (" << stats.failed
+            << " failed)\n";
+  std::cout << "Average guesses: " << std::setprecision(4)
+            << stats.average_guesses << "  max=" << stats.max_guesses << "\n";
+  std::cout << "Distribution:";
+  for (size_t guesses = stats.first_bucket;
+       guesses < stats.distribution.size(); ++guesses) {
+    std::cout << " " << guesses << ":" << stats.distribution[guesses];
+  }
+  std::cout << " X:" << stats.failed << "\n";
+  for (size_t turn = 0; turn < stats.turn_ms.size(); ++turn) {
+    if (stats.turn_ms[turn].empty()) {
+      continue;
+    }
+    std::cout << "Turn " << (turn + 1) << " latency (ms): p50="
+              << std::setprecision(3) << Percentile(stats.turn_ms[turn], 50)
+              << " p90=" << Percentile(stats.turn_ms[turn], 90)
+              << " p99=" << Percentile(stats.turn_ms[turn], 99) << "\n";
+  }
+}
+
+// Writes the --wordle-report JSON: "count", the mode's own fields from
+// write_fields (each line ending in a comma), the shared statistics, and
+// "games" with one object per game from write_game.
+bool WriteSolveAllReport(
+    const std::string& path,
+    const SolveAllStats& stats,
+    const std::function<void(std::ostream&)>& write_fields,
+    const std::function<void(std::ostream&, size_t)>& write_game) {
+  std::ofstream out(path);
+  if (!out) {
+    std::cerr << "Failed to write report: " << path << "\n";
+    return false;
+  }
+  out << std::setprecision(6);
+  out << "{\n";
+  out << "  \"count\": " << stats.count << ",\n";
+  write_fields(out);
+  out << "  \"win_rate\": " << stats.win_rate << ",\n";
+  out << "  \"average_guesses\": " << stats.average_guesses << ",\n";
+  out << "  \"max_guesses\": " << stats.max_guesses << ",\n";
+  out << "  \"failed\": " << stats.failed << ",\n";
+  out << "  \"total_ms\": " << stats.total_ms << ",\n";
+  out << "  \"p99_latency_ms\": " << Percentile(stats.game_ms, 99) << ",\n";
+  out << "  \"distribution\": {";
+  for (size_t guesses = stats.first_bucket;
+       guesses < stats.distribution.size(); ++guesses) {
+    out << (guesses > stats.first_bucket ? ", " : "") << "\"" << guesses
+        << "\": " << stats.distribution[guesses];
+  }
+  out << "},\n";
+  out << "  \"turn_latency_ms\": [";
+  for (size_t turn = 0; turn < stats.turn_ms.size(); ++turn) {
+    out << (turn > 0 ? "," : "") << "\n    {\"turn\": " << (turn + 1)
+        << ", \"samples\": " << stats.turn_ms[turn].size()
+        << ", \"p50\": " << Percentile(stats.turn_ms[turn], 50)
+        << ", \"p90\": " << Percentile(stats.turn_ms[turn], 90)
+        << ", \"p99\": " << Percentile(stats.turn_ms[turn], 99) << "}";
+  }
+  out << "\n  ],\n";
+  out << "  \"games\": [";
+  for (size_t i = 0; i < stats.count; ++i) {
+    out << (i > 0 ? "," : "") << "\n    ";
+    write_game(out, i);
+  }
+  out << "\n  ]\n}\n";
+  if (!out) {
+    std::cerr << "Failed to write report: " << path << "\n";
+    return false;
+  }
+  std::cout << "Report: " << path << "\n";
+  return true;
+}
+
+template <int kLength>
+bool RunWordleVariant(const Config& config) {
+  aletheia::BasicWordleSolver<kLength> wordle;
+  if (!wordle.LoadDictionary(config.wordle_dict)) {
+    std::cerr << "Failed to load " << kLength
+              << "-letter wordle dictionary: " << config.wordle_dict << "\n";
+    return false;
+  }
+  std::cout << "\n[Wordle] Dictionary size: " << wordle.words().size()
+            << " (" << kLength << " letters)\n";
+  auto start = std::chrono::high_resolution_clock::now();
+  if (!config.wordle_target.empty()) {
+    auto steps =
+        wordle.SolveToTarget(config.wordle_target, config.wordle_max_steps);
+    auto end = std::chrono::high_resolution_clock::now();
+    auto micros =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+            .count();
+    std::cout << "Target: " << config.wordle_target << "\n";
+    std::cout << "Solution path:\n";
+    for (size_t i = 0; i < steps.size(); ++i) {
+      const auto& step = steps[i];
+      std::cout << "  Step " << (i + 1) << ": guess=" << step.guess
+                << " pattern=" << step.pattern
+                << " entropy=" << std::fixed << std::setprecision(4)
+                << step.entropy << " bits=" << step.info_bits
+                << " remaining=" << step.remaining
+                << " -> " << step.remaining_after << "\n";
+    }
+    std::cout << "Total latency: " << micros << "us\n";
+    return true;
+  }
+  std::vector<size_t> all_indices(wordle.words().size());
+  std::iota(all_indices.begin(), all_indices.end(), 0);
+  double entropy = 0.0;
+  std::string guess = wordle.BestGuess(all_indices, all_indices, &entropy);
+  auto end = std::chrono::high_resolution_clock::now();
+  auto micros =
+      std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+          .count();
+  std::cout << "Best next guess: " << guess << " entropy=" << std::fixed
+            << std::setprecision(4) << entropy << "\n";
+  std::cout << "Total latency: " << micros << "us\n";
+  return true;
+}
+
+std::vector<std::string> SplitCommaList(const std::string& text) {
+  std::vector<std::string> items;
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    item = TrimWhitespace(item);
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// Multi-board play: one game from a comma-separated --wordle-target, or
+// --wordle-solve-all with consecutive targets grouped into games (the
+// last group wraps around to the first targets).
+bool RunWordleMulti(const aletheia::WordleSolver& wordle,
+                    const Config& config) {
+  const size_t boards = config.wordle_boards;
+  const size_t max_steps =
+      config.wordle_max_steps_set ? config.wordle_max_steps : boards + 5;
+  std::vector<std::vector<std::string>> games;
+  if (!config.wordle_target.empty()) {
+    games.push_back(SplitCommaList(config.wordle_target));
+    if (games.back().size() != boards) {
+      std::cerr << "--wordle-boards " << boards << " expects " << boards
+                << " comma-separated targets.\n";
+      return false;
+    }
+  } else if (!config.wordle_solve_all.empty()) {
+    std::vector<std::string> targets = LoadWordList(config.wordle_solve_all);
+    if (targets.empty()) {
+      std::cerr << "No targets in " << config.wordle_solve_all << "\n";
+      return false;
+    }
+    for (size_t first = 0; first < targets.size(); first += boards) {
+      std::vector<std::string> game;
+      for (size_t b = 0; b < boards; ++b) {
+        game.push_back(targets[(first + b) % targets.size()]);
+      }
+      games.push_back(std::move(game));
+    }
+  } else {
+    std::vector<size_t> all_indices(wordle.words().size());
+    std::iota(all_indices.begin(), all_indices.end(), 0);
+    std::vector<std::vector<size_t>> remaining(boards, all_indices);
+    double entropy = 0.0;
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string guess = wordle.BestMultiGuess(all_indices, remaining, &entropy);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "\n[Wordle] " << boards << " boards, dictionary size: "
+              << all_indices.size() << "\n";
+    std::cout << "Best next guess: " << guess << " entropy=" << std::fixed
+              << std::setprecision(4) << entropy << "\n";
+    std::cout << "Total latency: "
+              << std::chrono::duration_cast<std::chrono::microseconds>(
+                     end - start)
+                     .count()
+              << "us\n";
+    return true;
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  std::vector<aletheia::WordleSolver::MultiGameResult> results;
+  results.reserve(games.size());
+  for (const auto& game : games) {
+    results.push_back(wordle.SolveMultiToTargets(game, max_steps));
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double total_ms =
+      std::chrono::duration<double, std::milli>(end - start).count();
+
+  if (games.size() == 1 && config.wordle_solve_all.empty()) {
+    const auto& result = results.front();
+    std::cout << "\n[Wordle] " << boards << " boards, dictionary size: "
+              << wordle.words().size() << "\n";
+    std::cout << "Targets: " << config.wordle_target << "\n";
+    for (size_t turn = 0; turn < result.guesses.size(); ++turn) {
+      std::cout << "  Step " << (turn + 1) << ": guess="
+                << result.guesses[turn] << " entropy=" << std::fixed
+                << std::setprecision(4) << result.entropies[turn]
+                << " patterns=";
+      for (size_t b = 0; b < boards; ++b) {
+        const std::string& pattern = result.patterns[turn][b];
+        std::cout << (b > 0 ? "," : "")
+                  << (pattern.empty() ? std::string("-----") : pattern);
+      }
+      std::cout << "\n";
+    }
+    std::cout << (result.solved ? "Solved" : "Not solved") << " in "
+              << result.guesses.size() << " guesses\n";
+    std::cout << "Total latency: " << std::setprecision(1) << total_ms
+              << "ms\n";
+    return true;
+  }
+
+  std::vector<GameRecord> records;
+  records.reserve(results.size());
+  for (const auto& result : results) {
+    records.push_back({result.solved, result.guesses.size(), result.step_ms});
+  }
+  const SolveAllStats stats =
+      SummarizeGames(records, max_steps, boards, total_ms);
+  std::cout << "\n[Wordle] Solve-all: " << stats.count << " games of "
+            << boards << " boards, " << wordle.words().size() << " words\n";
+  PrintSolveAllStats(stats);
+  std::cout << "Total: " << std::setprecision(1) << total_ms << "ms\n";
+
+  if (config.wordle_report.empty()) {
+    return true;
+  }
+  return WriteSolveAllReport(
+      config.wordle_report, stats,
+      [&](std::ostream& out) {
+        out << "  \"boards\": " << boards << ",\n";
+        out << "  \"dictionary_size\": " << wordle.words().size() << ",\n";
+        out << "  \"max_steps\": " << max_steps << ",\n";
+      },
+      [&](std::ostream& out, size_t i) {
+        const auto& result = results[i];
+        out << "{\"targets\": [";
+        for (size_t b = 0; b < games[i].size(); ++b) {
+          out << (b > 0 ? ", " : "") << "\""
+              << aletheia::JsonEscape(games[i][b]) << "\"";
+        }
+        out << "], \"solved\": " << (result.solved ? "true" : "false")
+            << ", \"guesses\": [";
+        for (size_t turn = 0; turn < result.guesses.size(); ++turn) {
+          out << (turn > 0 ? ", " : "") << "\"" << result.guesses[turn]
+              << "\"";
+        }
+        out << "], \"solved_turn\": [";
+        for (size_t b = 0; b < result.solved_turn.size(); ++b) {
+          out << (b > 0 ? ", " : "") << result.solved_turn[b];
+        }
+        out << "]}";
+      });
+}
+
+#if defined(ALETHEIA_HAS_POLL)
+// Write end of the pipe through which SIGINT and SIGTERM reach the thread
+// that stops the socket server; only write() is safe in the handler.
+int g_stop_pipe = -1;
+
+void RequestServerStop(int) {
+  const char byte = 0;
+  // A full pipe already holds a pending stop.
+  [[maybe_unused]] const ssize_t written = ::write(g_stop_pipe, &byte, 1);
+}
+#endif
+
+// Loads the whole embeddings file (any word may be asked about) and serves
+// requests until stdin closes, or on a socket until SIGINT or SIGTERM lets
+// the open connections drain.
+bool RunServe(const aletheia::WordleSolver& wordle, const Config& config) {
+  aletheia::EmbeddingStore embeddings;
+  aletheia::SolverServer::Options options;
+  options.workers = config.serve_workers;
+  options.queue_depth = config.serve_queue;
+  options.allow_fallback = config.allow_fallback;
+  if (config.connections_hard) {
+    options.lexical_weight = config.connections_lexical_weight;
+  }
+  if (!config.embeddings_path.empty()) {
+    const std::unordered_set<std::string> every_word;
+    bool loaded = false;
+    if (config.embeddings_format == "word2vec") {
+      loaded = embeddings.LoadWord2VecBinary(config.embeddings_path,
+                                             every_word);
+    } else if (config.embeddings_format == "text") {
+      loaded = embeddings.LoadText(config.embeddings_path, every_word);
+    } else {
+      std::cerr << "Unknown embeddings format: " << config.embeddings_format
+                << "\n";
+      return false;
+    }
+    if (!loaded && !config.allow_fallback) {
+      std::cerr << "Failed to load embeddings: " << config.embeddings_path
+                << "\n";
+      return false;
+    }
+    if (loaded) {
+      options.embeddings = &embeddings;
+    }
+  }
+
+  aletheia::SolverServer server(wordle, options);
+  if (config.serve_socket.empty()) {
+    std::cerr << "[Serve] " << wordle.words().size()
+              << " words; reading requests from stdin.\n";
+    server.Serve(std::cin, std::cout);
+    return true;
+  }
+  std::cerr << "[Serve] " << wordle.words().size() << " words; listening on "
+            << config.serve_socket << "\n";
+#if defined(ALETHEIA_HAS_POLL)
+  int stop_pipe[2];
+  std::thread stopper;
+  if (::pipe(stop_pipe) == 0) {
+    g_stop_pipe = stop_pipe[1];
+    struct sigaction action{};
+    action.sa_handler = RequestServerStop;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+    stopper = std::thread([&server, fd = stop_pipe[0]] {
+      char byte;
+      while (::read(fd, &byte, 1) < 0 && errno == EINTR) {
+      }
+      server.Stop();
+    });
+  }
+#endif
+  const bool served = server.ServeUnixSocket(config.serve_socket);
+#if defined(ALETHEIA_HAS_POLL)
+  if (stopper.joinable()) {
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    // Wakes the stopper when the server ended without a signal.
+    RequestServerStop(0);
+    stopper.join();
+    ::close(stop_pipe[0]);
+    ::close(stop_pipe[1]);
+    g_stop_pipe = -1;
+  }
+#endif
+  if (!served) {
+    std::cerr << "Failed to listen on " << config.serve_socket << "\n";
+    return false;
+  }
+  std::cerr << "[Serve] Stopped.\n";
+  return true;
+}
+
+bool RunWordleSolveAll(const aletheia::WordleSolver& wordle,
+                       const Config& config) {
+  std::vector<std::string> targets = LoadWordList(config.wordle_solve_all);
+  if (targets.empty()) {
+    std::cerr << "No targets in " << config.wordle_solve_all << "\n";
+    return false;
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  aletheia::WordleSolver::SolveAllResult result =
+      wordle.SolveAll(targets, config.wordle_max_steps);
+  auto end = std::chrono::high_resolution_clock::now();
+  double total_ms =
+      std::chrono::duration<double, std::milli>(end - start).count();
+
+  std::vector<GameRecord> records;
+  records.reserve(result.games.size());
+  for (const auto& game : result.games) {
+    records.push_back({game.solved, game.steps.size(), game.step_ms});
+  }
+  const SolveAllStats stats =
+      SummarizeGames(records, config.wordle_max_steps, 1, total_ms);
+  std::cout << "\n[Wordle] Solve-all: " << stats.count << " targets, "
+            << wordle.words().size() << " words\n";
+  PrintSolveAllStats(stats);
+  std::cout << "Searches: " << result.decisions << "  total="
+            << std::setprecision(1) << total_ms << "ms\n";
+
+  if (config.wordle_report.empty()) {
+    return true;
+  }
+  return WriteSolveAllReport(
+      config.wordle_report, stats,
+      [&](std::ostream& out) {
+        out << "  \"dictionary_size\": " << wordle.words().size() << ",\n";
+        out << "  \"max_steps\": " << config.wordle_max_steps << ",\n";
+        out << "  \"decisions\": " << result.decisions << ",\n";
+      },
+      [&](std::ostream& out, size_t i) {
+        const auto& game = result.games[i];
+        out << "{\"target\": \"" << aletheia::JsonEscape(game.target)
+            << "\", \"solved\": " << (game.solved ? "true" : "false")
+            << ", \"guesses\": " << game.steps.size() << ", \"steps\": [";
+        for (size_t s = 0; s < game.steps.size(); ++s) {
+          const auto& step = game.steps[s];
+          out << (s > 0 ? ", " : "") << "{\"guess\": \"" << step.guess
+              << "\", \"pattern\": \"" << step.pattern
+              << "\", \"entropy\": " << step.entropy
+              << ", \"bits\": " << step.info_bits
+              << ", \"remaining\": " << step.remaining
+              << ", \"ms\": " << game.step_ms[s] << "}";
+        }
+        out << "]}";
+      });
+}
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -855,6 +1436,7 @@ int main(int argc, char** argv) {
       config.wordle_target = ToLowerAscii(argv[++i]);
     } else if (arg == "--wordle-max-steps" && i + 1 < argc) {
       config.wordle_max_steps = static_cast<size_t>(std::stoul(argv[++i]));
+      config.wordle_max_steps_set = true;
     } else if (arg == "--interactive") {
       config.wordle_interactive = true;
     } else if (arg == "--adversarial") {
@@ -863,6 +1445,38 @@ int main(int argc, char** argv) {
       config.wordle_profile = true;
     } else if (arg == "--wordle-hard") {
       config.wordle_hard = true;
+    } else if (arg == "--pattern-matrix") {
+      config.wordle_pattern_matrix = true;
+    } else if (arg == "--pattern-cache" && i + 1 < argc) {
+      config.wordle_pattern_cache = argv[++i];
+      config.wordle_pattern_matrix = true;
+    } else if (arg == "--wordle-book" && i + 1 < argc) {
+      config.wordle_book = argv[++i];
+    } else if (arg == "--wordle-build-book" && i + 1 < argc) {
+      config.wordle_build_book = argv[++i];
+    } else if (arg == "--wordle-optimal" && i + 1 < argc) {
+      config.wordle_optimal = ToLowerAscii(argv[++i]);
+    } else if (arg == "--wordle-optimal-limit" && i + 1 < argc) {
+      config.wordle_optimal_limit =
+          static_cast<size_t>(std::stoul(argv[++i]));
+    } else if (arg == "--wordle-boards" && i + 1 < argc) {
+      config.wordle_boards = static_cast<size_t>(std::stoul(argv[++i]));
+    } else if (arg == "--wordle-length" && i + 1 < argc) {
+      config.wordle_length = std::stoi(argv[++i]);
+    } else if (arg == "--wordle-lookahead" && i + 1 < argc) {
+      config.wordle_lookahead = static_cast<size_t>(std::stoul(argv[++i]));
+    } else if (arg == "--wordle-deadline-ms" && i + 1 < argc) {
+      config.wordle_deadline_ms = static_cast<size_t>(std::stoul(argv[++i]));
+    } else if (arg == "--speculate" && i + 1 < argc) {
+      config.wordle_speculate = static_cast<size_t>(std::stoul(argv[++i]));
+    } else if (arg == "--wordle-cache" && i + 1 < argc) {
+      config.wordle_cache = static_cast<size_t>(std::stoul(argv[++i]));
+    } else if (arg == "--wordle-cache-file" && i + 1 < argc) {
+      config.wordle_cache_file = argv[++i];
+    } else if (arg == "--wordle-solve-all" && i + 1 < argc) {
+      config.wordle_solve_all = argv[++i];
+    } else if (arg == "--wordle-report" && i + 1 < argc) {
+      config.wordle_report = argv[++i];
     } else if (arg == "--connections-words" && i + 1 < argc) {
       config.connections_words = argv[++i];
     } else if (arg == "--embeddings" && i + 1 < argc) {
@@ -887,6 +1501,19 @@ int main(int argc, char** argv) {
       config.connections_lexical_weight = std::stod(argv[++i]);
     } else if (arg == "--allow-fallback") {
       config.allow_fallback = true;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      config.threads = static_cast<size_t>(std::stoul(argv[++i]));
+    } else if (arg == "--pin-threads") {
+      config.pin_threads = true;
+    } else if (arg == "--serve") {
+      config.serve = true;
+    } else if (arg == "--serve-socket" && i + 1 < argc) {
+      config.serve = true;
+      config.serve_socket = argv[++i];
+    } else if (arg == "--serve-workers" && i + 1 < argc) {
+      config.serve_workers = static_cast<size_t>(std::stoul(argv[++i]));
+    } else if (arg == "--serve-queue" && i + 1 < argc) {
+      config.serve_queue = static_cast<size_t>(std::stoul(argv[++i]));
     } else if (arg == "--help" || arg == "-h") {
       PrintUsage(argv[0]);
       return 0;
@@ -897,9 +1524,57 @@ int main(int argc, char** argv) {
     }
   }
 
+  aletheia::ThreadPool::Configure(config.threads, config.pin_threads);
+
+  if (config.serve &&
+      (config.wordle_dict.empty() || config.wordle_length != 5 ||
+       config.wordle_interactive || !config.wordle_target.empty() ||
+       !config.wordle_solve_all.empty() || config.wordle_boards > 1)) {
+    std::cerr << "--serve needs --wordle-dict (5 letters) and takes no "
+                 "--interactive, --wordle-target, --wordle-solve-all or "
+                 "--wordle-boards.\n";
+    return 1;
+  }
+
   bool ran_any = false;
 
-  if (!config.wordle_dict.empty() || !config.wordle_target.empty()) {
+  if (config.wordle_length != 5) {
+    if (config.wordle_dict.empty()) {
+      std::cerr << "Wordle requires --wordle-dict.\n";
+      return 1;
+    }
+    if (config.wordle_interactive || !config.wordle_solve_all.empty() ||
+        !config.wordle_optimal.empty() || !config.wordle_book.empty() ||
+        !config.wordle_build_book.empty() || config.wordle_boards > 1) {
+      std::cerr << "--wordle-length other than 5 supports only "
+                   "--wordle-target and the best opening guess.\n";
+      return 1;
+    }
+    bool ok = false;
+    switch (config.wordle_length) {
+      case 4:
+        ok = RunWordleVariant<4>(config);
+        break;
+      case 6:
+        ok = RunWordleVariant<6>(config);
+        break;
+      case 7:
+        ok = RunWordleVariant<7>(config);
+        break;
+      case 8:
+        ok = RunWordleVariant<8>(config);
+        break;
+      default:
+        std::cerr << "--wordle-length expects 4 to 8.\n";
+        return 1;
+    }
+    if (!ok) {
+      return 1;
+    }
+    ran_any = true;
+  } else if (!config.wordle_dict.empty() ||
+             !config.wordle_target.empty() ||
+             !config.wordle_solve_all.empty()) {
     if (config.wordle_dict.empty()) {
       std::cerr << "Wordle requires --wordle-dict.\n";
       return 1;
@@ -912,16 +1587,118 @@ int main(int argc, char** argv) {
       std::cerr << "Choose either --adversarial or --wordle-target.\n";
       return 1;
     }
+    if (!config.wordle_optimal.empty() && config.wordle_optimal != "expected" &&
+        config.wordle_optimal != "worst") {
+      std::cerr << "--wordle-optimal expects 'expected' or 'worst'.\n";
+      return 1;
+    }
+    if (config.wordle_boards == 0 ||
+        config.wordle_boards > aletheia::WordleSolver::kMaxBoards) {
+      std::cerr << "--wordle-boards expects 1 to "
+                << aletheia::WordleSolver::kMaxBoards << ".\n";
+      return 1;
+    }
+    if (config.wordle_boards > 1 &&
+        (config.wordle_interactive || !config.wordle_optimal.empty())) {
+      std::cerr << "--wordle-boards cannot be combined with --interactive "
+                   "or --wordle-optimal.\n";
+      return 1;
+    }
+    if (!config.wordle_solve_all.empty() &&
+        (config.wordle_interactive || !config.wordle_target.empty())) {
+      std::cerr << "--wordle-solve-all cannot be combined with "
+                   "--interactive or --wordle-target.\n";
+      return 1;
+    }
     aletheia::WordleSolver wordle;
+    if (config.wordle_pattern_matrix) {
+      wordle.EnablePatternMatrix(config.wordle_pattern_cache);
+    }
+    wordle.SetLookahead(config.wordle_lookahead);
     if (!wordle.LoadDictionary(config.wordle_dict)) {
       std::cerr << "Failed to load wordle dictionary: "
                 << config.wordle_dict << "\n";
       return 1;
     }
+    if (config.wordle_cache == 0 && !config.wordle_cache_file.empty()) {
+      config.wordle_cache = 65536;
+    }
+    wordle.EnableGuessCache(config.wordle_cache);
+    if (!config.wordle_cache_file.empty() &&
+        wordle.LoadGuessCache(config.wordle_cache_file)) {
+      (config.serve ? std::cerr : std::cout)
+          << "[Wordle] Guess cache: " << wordle.GuessCacheStats().size
+          << " entries from " << config.wordle_cache_file << "\n";
+    }
+
+    if (!config.wordle_optimal.empty()) {
+      aletheia::WordleSolver::OptimalOptions options;
+      options.objective = config.wordle_optimal == "worst"
+                              ? aletheia::DecisionTree::Policy::kMinWorstCase
+                              : aletheia::DecisionTree::Policy::kMinExpected;
+      options.hard_mode = config.wordle_hard;
+      options.max_guesses = config.wordle_max_steps;
+      options.guess_limit = config.wordle_optimal_limit;
+      aletheia::WordleSolver::OptimalStats stats;
+      auto start = std::chrono::high_resolution_clock::now();
+      aletheia::DecisionTree tree = wordle.BuildOptimalTree(options, &stats);
+      auto end = std::chrono::high_resolution_clock::now();
+      auto micros =
+          std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+              .count();
+      if (!stats.feasible) {
+        std::cerr << "No policy solves every word within "
+                  << config.wordle_max_steps << " guesses.\n";
+        return 1;
+      }
+      std::cout << "[Wordle] Optimal policy (" << config.wordle_optimal
+                << (config.wordle_hard ? ", hard" : ", easy")
+                << (config.wordle_optimal_limit > 0 ? ", limited" : "")
+                << "): expected=" << std::fixed << std::setprecision(4)
+                << stats.expected_guesses << " worst=" << stats.worst_case
+                << " states=" << stats.states << " memo_hits="
+                << stats.memo_hits << " nodes=" << tree.node_count() << " in "
+                << micros << "us\n";
+      if (!config.wordle_build_book.empty()) {
+        if (!tree.Save(config.wordle_build_book)) {
+          std::cerr << "Failed to write decision tree: "
+                    << config.wordle_build_book << "\n";
+          return 1;
+        }
+        std::cout << "[Wordle] Policy saved -> " << config.wordle_build_book
+                  << "\n";
+      }
+      wordle.SetDecisionTree(std::move(tree));
+    } else if (!config.wordle_build_book.empty()) {
+      auto start = std::chrono::high_resolution_clock::now();
+      aletheia::DecisionTree tree = wordle.BuildDecisionTree(
+          config.wordle_hard, config.wordle_max_steps);
+      auto end = std::chrono::high_resolution_clock::now();
+      auto micros =
+          std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+              .count();
+      if (!tree.Save(config.wordle_build_book)) {
+        std::cerr << "Failed to write decision tree: "
+                  << config.wordle_build_book << "\n";
+        return 1;
+      }
+      std::cout << "[Wordle] Decision tree: " << tree.node_count()
+                << " nodes (" << (tree.hard_mode() ? "hard" : "easy")
+                << " mode) built in " << micros << "us -> "
+                << config.wordle_build_book << "\n";
+      wordle.SetDecisionTree(std::move(tree));
+    } else if (!config.wordle_book.empty()) {
+      if (!wordle.LoadDecisionTree(config.wordle_book)) {
+        std::cerr << "Failed to load decision tree (missing or built for "
+                     "another dictionary): "
+                  << config.wordle_book << "\n";
+        return 1;
+      }
+    }
 
     bool has_target = false;
     aletheia::PackedWord target_packed{};
-    if (!config.wordle_target.empty()) {
+    if (!config.wordle_target.empty() && config.wordle_boards == 1) {
       std::string normalized =
           aletheia::WordleSolver::NormalizeWord(config.wordle_target);
       if (!aletheia::WordleSolver::IsValidWord(normalized)) {
@@ -934,17 +1711,15 @@ int main(int argc, char** argv) {
     }
 
     if (config.wordle_interactive) {
-      std::vector<size_t> remaining(wordle.words().size());
-      std::iota(remaining.begin(), remaining.end(), 0);
-      std::vector<size_t> all_indices(wordle.words().size());
-      std::iota(all_indices.begin(), all_indices.end(), 0);
-      const size_t initial_count = remaining.size();
       const bool adversarial = config.wordle_adversarial;
       const bool auto_pattern = has_target || adversarial;
       const bool hard_mode = config.wordle_hard;
+      // Hard mode accepts any word that reuses the revealed hints, not just
+      // the possible answers; the session narrows that pool as hints
+      // accumulate and follows the decision tree while it applies.
+      aletheia::GameSession session(wordle, hard_mode);
+      const size_t initial_count = session.remaining().size();
       size_t steps_taken = 0;
-      std::vector<size_t> next;
-      next.reserve(remaining.size());
 
       std::cout << "\n[Wordle Interactive]\n";
       if (adversarial) {
@@ -956,7 +1731,22 @@ int main(int argc, char** argv) {
         std::cout << "Hard mode enabled.\n";
       }
       std::cout << "Type '?' for help.\n";
+      aletheia::WordleSolver::AdversarialOptions adversary_options;
+      adversary_options.hard_mode = hard_mode;
+      adversary_options.guess_limit = config.wordle_optimal_limit;
+      const std::chrono::microseconds budget =
+          config.wordle_deadline_ms > 0
+              ? std::chrono::microseconds(
+                    std::chrono::milliseconds(config.wordle_deadline_ms))
+              : std::chrono::microseconds::max();
+      // Next-turn suggestions searched while the player reads and types.
+      aletheia::SuggestionSpeculator speculator;
+      std::optional<aletheia::SuggestionSpeculator::Outcome> speculated;
+      size_t speculation_turns = 0;
+      size_t speculation_hits = 0;
+      std::chrono::microseconds speculation_saved{0};
       while (true) {
+        const std::vector<size_t>& remaining = session.remaining();
         if (remaining.empty()) {
           std::cout << "Remaining possibilities: 0\n";
           std::cout << "No valid candidates remain. Check your inputs.\n";
@@ -966,38 +1756,94 @@ int main(int argc, char** argv) {
           std::cout << "Out of rounds (" << config.wordle_max_steps << ").\n";
           break;
         }
+        adversary_options.max_guesses = config.wordle_max_steps - steps_taken;
 
         double entropy = 0.0;
+        bool exact = true;
+        bool superseded = false;
+        std::string line;
+        bool typed_ahead = false;
+        aletheia::WordleSolver::SearchStats search_stats;
         auto start = std::chrono::high_resolution_clock::now();
-        const std::vector<size_t>& guess_pool =
-            hard_mode ? remaining : all_indices;
-        std::string suggestion =
-            wordle.BestGuess(guess_pool, remaining, &entropy);
+        std::string suggestion;
+        aletheia::WordleSolver::AdversarialResult forced;
+        if (adversarial) {
+          forced = wordle.SolveAdversarial(remaining, adversary_options);
+        }
+        if (forced.guesses > 0) {
+          suggestion = wordle.words()[forced.guess].text;
+          std::vector<size_t> forced_pool(1, forced.guess);
+          wordle.BestGuess(forced_pool, remaining, &entropy);
+        } else if (speculated) {
+          suggestion = speculated->result.guess;
+          entropy = speculated->result.entropy;
+          exact = speculated->result.exact;
+          search_stats = speculated->result.stats;
+          speculated.reset();
+        } else {
+          aletheia::GuessFuture pending = session.SuggestAsync(budget);
+          typed_ahead = AwaitSuggestion(&pending, &line);
+          superseded = pending.token().cancelled();
+          if (!superseded) {
+            const aletheia::GuessFuture::Result& result = pending.Get();
+            suggestion = result.guess;
+            entropy = result.entropy;
+            exact = result.exact;
+            search_stats = result.stats;
+          }
+        }
         auto end = std::chrono::high_resolution_clock::now();
         auto micros =
             std::chrono::duration_cast<std::chrono::microseconds>(end - start)
                 .count();
 
-        std::cout << "Suggested guess: " << suggestion << " entropy="
-                  << std::fixed << std::setprecision(4) << entropy << "\n";
+        if (superseded) {
+          std::cout << "Suggestion skipped: input arrived first.\n";
+        } else {
+          std::cout << "Suggested guess: " << suggestion << " entropy="
+                    << std::fixed << std::setprecision(4) << entropy
+                    << (exact ? "" : " (best so far)") << "\n";
+        }
         std::cout << "Round " << (steps_taken + 1) << " of "
                   << config.wordle_max_steps << "\n";
         std::cout << "Remaining possibilities: " << remaining.size() << "\n";
         PrintEntropyBar(remaining.size(), initial_count);
         std::cout << "Compute latency: " << micros << "us\n";
-        if (auto_pattern) {
-          std::cout << "Enter guess (or press Enter to accept suggestion), or "
-                       "22222 to finish: ";
-        } else {
-          std::cout << "Enter guess and pattern (e.g., RAISE 00102), a pattern "
-                       "(00102), or 22222 to finish: ";
+        if (adversarial) {
+          if (forced.guesses > 0) {
+            std::cout << "Forced win in " << forced.guesses << " guess"
+                      << (forced.guesses == 1 ? "" : "es")
+                      << (forced.proven_optimal ? " (proven optimal"
+                                                : " (upper bound")
+                      << ", " << forced.states << " states)\n";
+          } else {
+            std::cout << "No forced win within "
+                      << adversary_options.max_guesses << " guesses.\n";
+          }
         }
-
-        std::string line;
-        if (!std::getline(std::cin, line)) {
-          break;
+        if (config.wordle_profile && search_stats.candidates > 0) {
+          std::cout << "Search: pruned " << search_stats.pruned << " of "
+                    << search_stats.candidates << " candidates ("
+                    << search_stats.merged << " duplicate splits)\n";
+        }
+        if (config.wordle_speculate > 0 && !adversarial && !superseded &&
+            !typed_ahead) {
+          speculator.Start(session, suggestion, config.wordle_speculate,
+                           budget);
+        }
+        if (!typed_ahead) {
+          if (auto_pattern) {
+            std::cout << "Enter guess (or press Enter to accept suggestion), "
+                         "or 22222 to finish: ";
+          } else {
+            std::cout << "Enter guess and pattern (e.g., RAISE 00102), a "
+                         "pattern (00102), or 22222 to finish: ";
+          }
+          if (!std::getline(std::cin, line)) {
+            break;
+          }
+          line = TrimWhitespace(line);
         }
-        line = TrimWhitespace(line);
 
         if (line == "help" || line == "?") {
           PrintInteractiveHelp();
@@ -1059,26 +1905,22 @@ int main(int argc, char** argv) {
           std::cout << "Invalid guess: " << guess_input << "\n";
           continue;
         }
-        if (hard_mode) {
-          bool allowed = false;
-          for (size_t idx : remaining) {
-            if (wordle.words()[idx].text == guess) {
-              allowed = true;
-              break;
-            }
-          }
-          if (!allowed) {
-            std::cout << "Hard mode: guess must match all revealed hints.\n";
-            continue;
-          }
+        if (!session.AllowsGuess(guess)) {
+          std::cout << "Hard mode: guess must match all revealed hints.\n";
+          continue;
         }
 
         aletheia::PackedWord guess_packed =
             aletheia::WordleSolver::EncodeWord(guess);
 
         if (adversarial) {
-          int pattern_value = SelectAdversarialPattern(
-              guess_packed, remaining, wordle.words(), nullptr);
+          const size_t guess_index = wordle.IndexOf(guess);
+          int pattern_value =
+              guess_index != aletheia::WordleSolver::kNoIndex
+                  ? wordle.AdversarialPattern(guess_index, remaining,
+                                              adversary_options)
+                  : SelectAdversarialPattern(wordle, guess, remaining,
+                                             nullptr);
           pattern_input = aletheia::WordleSolver::PatternString(pattern_value);
         } else if (auto_pattern) {
           int pattern_value =
@@ -1092,26 +1934,36 @@ int main(int argc, char** argv) {
           }
         }
 
-        size_t before_count = remaining.size();
-        next.clear();
-        auto alloc_start = std::chrono::high_resolution_clock::now();
-        if (next.capacity() < before_count) {
-          next.reserve(before_count);
-        }
-        auto alloc_end = std::chrono::high_resolution_clock::now();
+        const size_t before_count = remaining.size();
         auto filter_start = std::chrono::high_resolution_clock::now();
-        aletheia::WordleSolver::FilterCandidates(wordle.words(),
-                                                 remaining,
-                                                 guess,
-                                                 pattern_input,
-                                                 &next);
+        // `remaining` may view the solver's index list until the first
+        // turn lands, so only the session is read after this point.
+        const bool applied = session.ApplyFeedback(guess, pattern_input);
         auto filter_end = std::chrono::high_resolution_clock::now();
-
-        size_t match_count = next.size();
-        if (match_count == 0) {
+        if (!applied) {
           std::cout << "Pattern is inconsistent with remaining words.\n";
           continue;
         }
+        const size_t match_count = session.remaining().size();
+        if (speculator.active()) {
+          ++speculation_turns;
+          aletheia::SuggestionSpeculator::Outcome outcome;
+          const bool hit = speculator.Take(guess, pattern_input, &outcome);
+          if (hit) {
+            ++speculation_hits;
+            speculation_saved += outcome.compute;
+            speculated = std::move(outcome);
+          }
+          if (config.wordle_profile) {
+            std::cout << "Speculation: "
+                      << (hit ? "hit, saved " +
+                                    std::to_string(
+                                        speculated->compute.count()) +
+                                    "us"
+                              : std::string("miss"))
+                      << "\n";
+          }
+        }
 
         double info_bits = 0.0;
         double p = static_cast<double>(match_count) /
@@ -1119,40 +1971,33 @@ int main(int argc, char** argv) {
         if (p > 0.0) {
           info_bits = -std::log2(p);
         }
-        remaining.swap(next);
 
         PrintColoredPattern(guess, pattern_input);
         std::cout << "Pattern: " << pattern_input << "\n";
         if (config.wordle_profile) {
-          auto alloc_us =
-              std::chrono::duration_cast<std::chrono::microseconds>(
-                  alloc_end - alloc_start)
-                  .count();
           auto compute_us =
               std::chrono::duration_cast<std::chrono::microseconds>(
                   filter_end - filter_start)
                   .count();
-          std::cout << "Perf: alloc=" << alloc_us
-                    << "us compute=" << compute_us << "us\n";
+          std::cout << "Perf: filter=" << compute_us << "us\n";
         }
 
         std::cout << "Information gained: " << std::fixed
                   << std::setprecision(4) << info_bits << " bits\n";
-        std::cout << "Remaining possibilities: " << remaining.size() << "\n";
-        double bits_remaining =
-            remaining.empty() ? 0.0 : std::log2(remaining.size());
+        std::cout << "Remaining possibilities: " << match_count << "\n";
+        double bits_remaining = std::log2(static_cast<double>(match_count));
         std::cout << "Bits remaining: " << std::fixed << std::setprecision(4)
                   << bits_remaining << "\n";
-        double pruned = static_cast<double>(before_count - remaining.size());
+        double pruned = static_cast<double>(before_count - match_count);
         double pruned_pct =
             before_count > 0
                 ? (pruned / static_cast<double>(before_count)) * 100.0
                 : 0.0;
         std::cout << "Optimization Summary: pruned " << before_count
-                  << " -> " << remaining.size() << " ("
+                  << " -> " << match_count << " ("
                   << std::fixed << std::setprecision(1) << pruned_pct
                   << "%)\n";
-        PrintEntropyBar(remaining.size(), initial_count);
+        PrintEntropyBar(match_count, initial_count);
 
         steps_taken++;
         if (pattern_input == "22222") {
@@ -1160,10 +2005,32 @@ int main(int argc, char** argv) {
           break;
         }
       }
+      if (config.wordle_profile && speculation_turns > 0) {
+        std::cout << "Speculation: " << speculation_hits << "/"
+                  << speculation_turns << " turns precomputed, saved "
+                  << std::fixed << std::setprecision(3)
+                  << static_cast<double>(speculation_saved.count()) / 1000.0
+                  << "ms\n";
+      }
       ran_any = true;
     }
 
-    if (!config.wordle_interactive) {
+    if (config.serve) {
+      if (!RunServe(wordle, config)) {
+        return 1;
+      }
+      ran_any = true;
+    } else if (config.wordle_boards > 1) {
+      if (!RunWordleMulti(wordle, config)) {
+        return 1;
+      }
+      ran_any = true;
+    } else if (!config.wordle_solve_all.empty()) {
+      if (!RunWordleSolveAll(wordle, config)) {
+        return 1;
+      }
+      ran_any = true;
+    } else if (!config.wordle_interactive) {
       std::vector<size_t> all_indices(wordle.words().size());
       std::iota(all_indices.begin(), all_indices.end(), 0);
 
@@ -1192,8 +2059,21 @@ int main(int argc, char** argv) {
         std::cout << "Total latency: " << micros << "us\n";
       } else {
         double entropy = 0.0;
-        std::string guess =
-            wordle.BestGuess(all_indices, all_indices, &entropy);
+        std::string guess;
+        aletheia::WordleSolver::SearchStats stats;
+        aletheia::WordleSolver::LookaheadResult lookahead;
+        if (wordle.HasDecisionTree(false)) {
+          const aletheia::DecisionTree& book = wordle.decision_tree();
+          guess = wordle.words()[book.Guess(book.root())].text;
+          entropy = book.Entropy(book.root());
+        } else if (wordle.lookahead() > 1) {
+          lookahead = wordle.BestGuessLookahead(all_indices, all_indices,
+                                                wordle.lookahead(), false);
+          guess = wordle.words()[lookahead.guess].text;
+          entropy = lookahead.entropy;
+        } else {
+          guess = wordle.BestGuess(all_indices, all_indices, &entropy, &stats);
+        }
         auto end = std::chrono::high_resolution_clock::now();
         auto micros =
             std::chrono::duration_cast<std::chrono::microseconds>(end - start)
@@ -1201,14 +2081,40 @@ int main(int argc, char** argv) {
         std::cout << "Best next guess: " << guess
                   << " entropy=" << std::fixed << std::setprecision(4)
                   << entropy << "\n";
+        if (stats.candidates > 0) {
+          std::cout << "Search: pruned " << stats.pruned << " of "
+                    << stats.candidates << " candidates (" << stats.merged
+                    << " duplicate splits)\n";
+        }
+        if (lookahead.beam > 0) {
+          std::cout << "Lookahead: beam=" << lookahead.beam
+                    << " score=" << lookahead.score << " ("
+                    << lookahead.second_ply_searches
+                    << " second-ply searches)\n";
+        }
         std::cout << "Total latency: " << micros << "us\n";
       }
       ran_any = true;
     }
+
+    if (config.wordle_cache > 0) {
+      aletheia::GuessCache::Stats cache = wordle.GuessCacheStats();
+      // stdout carries the --serve responses.
+      std::ostream& log = config.serve ? std::cerr : std::cout;
+      log << "Guess cache: " << cache.hits << " hits, " << cache.misses
+          << " misses, " << cache.evictions << " evictions, " << cache.size
+          << " entries\n";
+      if (!config.wordle_cache_file.empty() &&
+          !wordle.SaveGuessCache(config.wordle_cache_file)) {
+        std::cerr << "Failed to save guess cache: "
+                  << config.wordle_cache_file << "\n";
+      }
+    }
   }
 
-  if (!config.connections_words.empty() || !config.embeddings_path.empty() ||
-      config.allow_fallback || config.connections_demo) {
+  if (!config.serve &&
+      (!config.connections_words.empty() || !config.embeddings_path.empty() ||
+       config.allow_fallback || config.connections_demo)) {
     DemoConnectionsPuzzle demo;
     bool use_demo = config.connections_demo || config.connections_words.empty();
     std::vector<std::string> words;
@@ -1284,7 +2190,7 @@ int main(int argc, char** argv) {
       if (loaded && embeddings.GetVector(word, &vec)) {
         vectors.push_back(std::move(vec));
       } else if (config.allow_fallback) {
-        vectors.push_back(FallbackEmbedding(word, fallback_dims));
+        vectors.push_back(aletheia::FallbackEmbedding(word, fallback_dims));
       } else {
         std::cerr << "Missing embedding for word: " << word << "\n";
         return 1;
@@ -30,6 +30,7 @@ COMMON_FLAGS="$COMMON_FLAGS -s MODULARIZE=1 -s EXPORT_ES6=1"
   web/wasm_api.cpp \
   Wordle.cpp \
   Connections.cpp \
+  ThreadPool.cpp \
   -o "$OUT_DIR/aletheia_wasm.js"
 
 "$EMCC" \
@@ -37,6 +38,7 @@ COMMON_FLAGS="$COMMON_FLAGS -s MODULARIZE=1 -s EXPORT_ES6=1"
   -s ENVIRONMENT=web,worker \
   -s USE_PTHREADS=1 \
   -s PTHREAD_POOL_SIZE=4 \
+  -DALETHEIA_MAX_THREADS=4 \
   -s INITIAL_MEMORY=268435456 \
   -s ALLOW_MEMORY_GROWTH=0 \
   -pthread \
@@ -46,6 +48,7 @@ COMMON_FLAGS="$COMMON_FLAGS -s MODULARIZE=1 -s EXPORT_ES6=1"
   web/wasm_api.cpp \
   Wordle.cpp \
   Connections.cpp \
+  ThreadPool.cpp \
   -o "$OUT_DIR/aletheia_wasm_mt.js"
 
 echo "WASM build complete: $OUT_DIR/aletheia_wasm.js + $OUT_DIR/aletheia_wasm_mt.js"
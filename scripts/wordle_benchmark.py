@@ -9,6 +9,7 @@ import shutil
 import statistics
 import subprocess
 import sys
+import tempfile
 import urllib.request
 import ssl
 from typing import List, Optional
@@ -241,6 +242,62 @@ def run_solver(binary: str, dict_path: str, target: str, max_steps: int) -> dict
     }
 
 
+def run_solve_all(
+    binary: str, dict_path: str, targets: List[str], max_steps: int
+) -> tuple[List[dict], dict]:
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        targets_path = os.path.join(tmp_dir, "targets.txt")
+        report_path = os.path.join(tmp_dir, "report.json")
+        with open(targets_path, "w", encoding="utf-8") as handle:
+            handle.write("\n".join(targets) + "\n")
+        cmd = [
+            binary,
+            "--wordle-dict",
+            dict_path,
+            "--wordle-solve-all",
+            targets_path,
+            "--wordle-max-steps",
+            str(max_steps),
+            "--wordle-report",
+            report_path,
+        ]
+        proc = subprocess.run(cmd, check=False, capture_output=True, text=True)
+        if proc.returncode != 0 or not os.path.exists(report_path):
+            raise RuntimeError(
+                (proc.stderr or proc.stdout).strip() or "solve-all failed"
+            )
+        with open(report_path, "r", encoding="utf-8") as handle:
+            native = json.load(handle)
+
+    results = []
+    for game in native["games"]:
+        steps = [
+            {
+                "step": index + 1,
+                "guess": step["guess"],
+                "pattern": step["pattern"],
+                "entropy": step["entropy"],
+                "bits": step["bits"],
+            }
+            for index, step in enumerate(game["steps"])
+        ]
+        guesses = len(steps)
+        latency_us = sum(step["ms"] for step in game["steps"]) * 1000.0
+        results.append(
+            {
+                "target": game["target"],
+                "returncode": 0,
+                "solved": game["solved"],
+                "guesses": guesses,
+                "total_bits": sum(step["bits"] for step in steps),
+                "latency_us": latency_us,
+                "per_guess_us": latency_us / guesses if guesses else 0.0,
+                "steps": steps,
+            }
+        )
+    return results, native
+
+
 def render_histogram(values: list[int], out_path: str) -> bool:
     try:
         import matplotlib.pyplot as plt
@@ -323,6 +380,11 @@ def parse_args() -> argparse.Namespace:
         default="reports/wordle_benchmark.json",
         help="Output path for the JSON report.",
     )
+    parser.add_argument(
+        "--per-process",
+        action="store_true",
+        help="Launch the binary once per target instead of --wordle-solve-all.",
+    )
     parser.add_argument(
         "--progress-every",
         type=int,
@@ -402,18 +464,29 @@ def main() -> int:
     print(f"Using dictionary: {dict_path} ({len(dictionary_words)} words)")
 
     results = []
-    total = len(recent)
-    for idx, word in enumerate(recent, start=1):
-        if args.progress_every and (
-            idx == 1
-            or idx == total
-            or idx % args.progress_every == 0
-        ):
-            print(f"Running {idx}/{total}: {word}", flush=True)
-        result = run_solver(args.binary, dict_path, word, args.max_steps)
-        if result["returncode"] != 0:
-            sys.stderr.write(f"Solver failed for {word}.\n")
-        results.append(result)
+    native = None
+    if args.per_process:
+        total = len(recent)
+        for idx, word in enumerate(recent, start=1):
+            if args.progress_every and (
+                idx == 1
+                or idx == total
+                or idx % args.progress_every == 0
+            ):
+                print(f"Running {idx}/{total}: {word}", flush=True)
+            result = run_solver(args.binary, dict_path, word, args.max_steps)
+            if result["returncode"] != 0:
+                sys.stderr.write(f"Solver failed for {word}.\n")
+            results.append(result)
+    else:
+        print(f"Solving {len(recent)} targets in one process", flush=True)
+        try:
+            results, native = run_solve_all(
+                args.binary, dict_path, recent, args.max_steps
+            )
+        except Exception as exc:
+            sys.stderr.write(f"Solve-all failed: {exc}\n")
+            return 1
 
     solved_results = [r for r in results if r["solved"]]
     guess_counts = [r["guesses"] for r in solved_results]
@@ -445,6 +518,10 @@ def main() -> int:
         "average_total_bits": avg_bits,
         "total_bits": sum_bits,
         "average_guess_latency_ms": avg_guess_latency,
+        "distribution": {
+            str(guesses): guess_counts.count(guesses)
+            for guesses in range(1, args.max_steps + 1)
+        },
         "results": [
             {
                 "target": r["target"],
@@ -458,6 +535,11 @@ def main() -> int:
         ],
     }
 
+    if native is not None:
+        report["turn_latency_ms"] = native["turn_latency_ms"]
+        report["decisions"] = native["decisions"]
+        report["total_ms"] = native["total_ms"]
+
     print("Wordle Benchmark Report")
     print(f"Words evaluated: {len(results)}")
     print(f"Win rate: {win_rate:.1%}")
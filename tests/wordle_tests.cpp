@@ -2,6 +2,25 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <numeric>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define ALETHEIA_TEST_SOCKETS 1
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 namespace {
 std::string PatternFor(const std::string& guess, const std::string& target) {
   aletheia::PackedWord guess_packed = aletheia::WordleSolver::EncodeWord(guess);
@@ -10,6 +29,32 @@ std::string PatternFor(const std::string& guess, const std::string& target) {
   int pattern = aletheia::WordleSolver::Pattern(guess_packed, target_packed);
   return aletheia::WordleSolver::PatternString(pattern);
 }
+
+// Deterministic pseudo-dictionary with a skewed letter distribution so that
+// duplicate letters and shared buckets are common.
+std::vector<std::string> SampleWords(size_t count) {
+  const std::string letters = "eeeaaarrootinslcudpmhgbfywkvxzjq";
+  std::vector<std::string> words;
+  words.reserve(count);
+  uint64_t state = 88172645463325252ULL;
+  while (words.size() < count) {
+    std::string word(5, 'a');
+    for (char& c : word) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      c = letters[state % letters.size()];
+    }
+    words.push_back(word);
+  }
+  return words;
+}
+
+std::vector<size_t> AllIndices(const aletheia::WordleSolver& solver) {
+  std::vector<size_t> indices(solver.words().size());
+  std::iota(indices.begin(), indices.end(), 0);
+  return indices;
+}
 }  // namespace
 
 TEST(WordleConsistency, DuplicateLetterRule) {
@@ -51,3 +96,1705 @@ TEST(WordleConsistency, YellowPositionInvalid) {
   EXPECT_TRUE(aletheia::WordleSolver::IsConsistent(target, guess, pattern));
   EXPECT_FALSE(aletheia::WordleSolver::IsConsistent("stare", guess, pattern));
 }
+
+TEST(WordleConsistency, GrayRejectsSameLetterInPlace) {
+  std::string guess = "uvuap";
+  std::string pattern = PatternFor(guess, "ruxyz");
+  EXPECT_EQ(pattern, "10000");
+  EXPECT_FALSE(aletheia::WordleSolver::IsConsistent("mtutr", guess, pattern));
+}
+
+TEST(WordlePatternMatrix, MatchesScalarPattern) {
+  aletheia::WordleSolver solver;
+  solver.EnablePatternMatrix("");
+  solver.SetWordList(SampleWords(300));
+  ASSERT_TRUE(solver.HasPatternMatrix());
+  const auto& words = solver.words();
+  for (size_t g = 0; g < words.size(); ++g) {
+    for (size_t t = 0; t < words.size(); ++t) {
+      ASSERT_EQ(solver.PatternAt(g, t),
+                aletheia::WordleSolver::Pattern(words[g].packed,
+                                                words[t].packed));
+    }
+  }
+}
+
+TEST(WordlePatternMatrix, CacheRoundTripAndFilter) {
+  const std::string path = ::testing::TempDir() + "aletheia_matrix_test.bin";
+  std::remove(path.c_str());
+  std::vector<std::string> words = SampleWords(200);
+
+  aletheia::WordleSolver writer;
+  writer.EnablePatternMatrix(path);
+  writer.SetWordList(words);
+  ASSERT_TRUE(writer.HasPatternMatrix());
+
+  aletheia::WordleSolver reader;
+  reader.EnablePatternMatrix(path);
+  reader.SetWordList(words);
+  ASSERT_TRUE(reader.HasPatternMatrix());
+  for (size_t g = 0; g < words.size(); ++g) {
+    for (size_t t = 0; t < words.size(); ++t) {
+      ASSERT_EQ(reader.PatternAt(g, t), writer.PatternAt(g, t));
+    }
+  }
+
+  aletheia::PatternMatrix stale;
+  EXPECT_FALSE(stale.Load(path, words.size(),
+                          writer.DictionaryFingerprint() + 1));
+
+  aletheia::WordleSolver plain;
+  plain.SetWordList(words);
+  std::vector<size_t> all = AllIndices(plain);
+  for (size_t g = 0; g < 20; ++g) {
+    std::string guess(plain.words()[g].text);
+    std::string pattern = aletheia::WordleSolver::PatternString(
+        plain.PatternAt(g, words.size() - 1 - g));
+    std::vector<size_t> expected;
+    std::vector<size_t> actual;
+    aletheia::WordleSolver::FilterCandidates(plain.words(), all, guess,
+                                             pattern, &expected);
+    reader.FilterCandidates(all, guess, pattern, &actual);
+    EXPECT_EQ(actual, expected);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(WordlePatternBatch, MatchesScalarPatternExhaustively) {
+  std::vector<std::string> words = SampleWords(400);
+  for (const char* extra : {"mamma", "gamma", "sassy", "assay", "abbey",
+                            "babes", "eerie", "geese", "llama", "lolly"}) {
+    words.push_back(extra);
+  }
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+  const auto& entries = solver.words();
+  std::vector<uint32_t> letters;
+  letters.reserve(entries.size());
+  for (const auto& entry : entries) {
+    letters.push_back(entry.packed.letters);
+  }
+  std::vector<uint8_t> codes(entries.size());
+
+  const bool simd = aletheia::SimdEnabled();
+  for (bool enabled : {true, false}) {
+    aletheia::SetSimdEnabled(enabled);
+    for (const auto& guess : entries) {
+      aletheia::WordleSolver::PatternBatch(guess.packed, letters.data(),
+                                           letters.size(), codes.data());
+      for (size_t t = 0; t < entries.size(); ++t) {
+        ASSERT_EQ(codes[t], aletheia::WordleSolver::Pattern(
+                                guess.packed, entries[t].packed))
+            << guess.text << " vs " << entries[t].text;
+      }
+    }
+  }
+  aletheia::SetSimdEnabled(simd);
+}
+
+TEST(WordleWordTable, AlignedArraysMatchTextAndFilter) {
+  std::vector<std::string> words = SampleWords(300);
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+  const aletheia::WordTable& table = solver.words();
+  ASSERT_EQ(table.size(), words.size());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(table.letters()) %
+                aletheia::WordTable::kAlignment, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(table.masks()) %
+                aletheia::WordTable::kAlignment, 0u);
+  for (size_t i = 0; i < table.size(); ++i) {
+    const aletheia::PackedWord packed =
+        aletheia::WordleSolver::EncodeWord(words[i]);
+    ASSERT_EQ(table.text(i), words[i]);
+    ASSERT_EQ(table.letters()[i], packed.letters);
+    ASSERT_EQ(table.masks()[i], packed.mask);
+  }
+
+  // Contiguous, sparse and ragged-tail index sets all agree with a scalar
+  // consistency scan.
+  std::vector<size_t> all = AllIndices(solver);
+  std::vector<size_t> sparse;
+  for (size_t i = 0; i < table.size(); i += 3) {
+    sparse.push_back(i);
+  }
+  std::vector<size_t> tail(all.begin(), all.begin() + 13);
+  const bool simd = aletheia::SimdEnabled();
+  for (bool enabled : {true, false}) {
+    aletheia::SetSimdEnabled(enabled);
+    for (const auto* remaining : {&all, &sparse, &tail}) {
+      for (size_t g = 0; g < 10; ++g) {
+        std::string guess(table.text(g * 7));
+        std::string pattern = PatternFor(guess, words[words.size() - 1 - g]);
+        std::vector<size_t> expected;
+        for (size_t index : *remaining) {
+          if (aletheia::WordleSolver::IsConsistent(words[index], guess,
+                                                   pattern)) {
+            expected.push_back(index);
+          }
+        }
+        std::vector<size_t> actual;
+        aletheia::WordleSolver::FilterCandidates(table, *remaining, guess,
+                                                 pattern, &actual);
+        ASSERT_EQ(actual, expected) << guess << " " << pattern;
+      }
+    }
+  }
+  aletheia::SetSimdEnabled(simd);
+}
+
+TEST(WordleWordTable, CompactedTargetsMatchIndexedCounts) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(400));
+  const aletheia::WordTable& table = solver.words();
+  std::vector<size_t> targets;
+  for (size_t i = 5; i < table.size(); i += 7) {
+    targets.push_back(i);
+  }
+  aletheia::WordTable packed;
+  packed.Assign(table, targets);
+  ASSERT_EQ(packed.size(), targets.size());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(packed.letters()) %
+                aletheia::WordTable::kAlignment, 0u);
+  for (size_t i = 0; i < targets.size(); ++i) {
+    ASSERT_EQ(packed.letters()[i], table.letters()[targets[i]]);
+    ASSERT_EQ(packed.masks()[i], table.masks()[targets[i]]);
+    ASSERT_EQ(packed.text(i), table.text(targets[i]));
+  }
+  for (size_t guess = 0; guess < table.size(); guess += 11) {
+    ASSERT_EQ(solver.PatternCounts(guess, packed),
+              solver.PatternCounts(guess, targets));
+  }
+}
+
+TEST(WordleHintConstraints, CompiledHistoryMatchesReplayedFilters) {
+  std::vector<std::string> words = SampleWords(600);
+  for (const char* extra : {"eerie", "geese", "sassy", "assay", "llama"}) {
+    words.push_back(extra);
+  }
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+  const size_t n = solver.words().size();
+
+  aletheia::HintConstraints hints;
+  EXPECT_FALSE(hints.Add("crane", "0120"));
+  EXPECT_FALSE(hints.Add("cr4ne", "01200"));
+  EXPECT_TRUE(hints.empty());
+
+  // A yellow after a grey copy of the same letter is feedback no answer can
+  // produce: the replayed filter rejects everything, and so must the hints.
+  ASSERT_TRUE(hints.Add("ccxxx", "01000"));
+  EXPECT_TRUE(hints.contradictory());
+  EXPECT_FALSE(hints.Matches(aletheia::WordleSolver::EncodeWord("abcde")));
+  EXPECT_FALSE(
+      aletheia::WordleSolver::IsConsistent("abcde", "ccxxx", "01000"));
+  hints.Reset();
+  ASSERT_TRUE(hints.Add("ccxxx", "10000"));
+  EXPECT_FALSE(hints.contradictory());
+  EXPECT_TRUE(hints.Matches(aletheia::WordleSolver::EncodeWord("abcde")));
+  EXPECT_TRUE(
+      aletheia::WordleSolver::IsConsistent("abcde", "ccxxx", "10000"));
+  hints.Reset();
+
+  const bool simd = aletheia::SimdEnabled();
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  auto next = [&state](size_t bound) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return static_cast<size_t>(state % bound);
+  };
+  for (int game = 0; game < 60; ++game) {
+    aletheia::SetSimdEnabled(game % 2 == 0);
+    // Even games reveal real feedback against a target; odd games mix in
+    // arbitrary patterns so contradictory histories are covered too.
+    const std::string target(solver.words().text(next(n)));
+    std::vector<size_t> replayed = AllIndices(solver);
+    hints.Reset();
+    for (int turn = 0; turn < 4; ++turn) {
+      const std::string guess(solver.words().text(next(n)));
+      std::string pattern = PatternFor(guess, target);
+      if (game % 4 == 1) {
+        pattern[next(5)] = static_cast<char>('0' + next(3));
+      }
+      std::vector<size_t> filtered;
+      aletheia::WordleSolver::FilterCandidates(solver.words(), replayed,
+                                               guess, pattern, &filtered);
+      replayed = std::move(filtered);
+      ASSERT_TRUE(hints.Add(guess, pattern));
+
+      std::vector<size_t> compiled;
+      solver.FilterCandidates(hints, &compiled);
+      ASSERT_EQ(compiled, replayed) << "game " << game << " turn " << turn;
+    }
+  }
+  aletheia::SetSimdEnabled(simd);
+}
+
+TEST(WordleHintConstraints, HardModePoolFollowsRevealedHints) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(800));
+  const aletheia::WordTable& table = solver.words();
+  const std::string target(table.text(17));
+
+  // Brute-force NYT rule: greens stay put and every coloured letter is
+  // reused at least as often as it was coloured.
+  std::vector<std::pair<std::string, std::string>> history;
+  auto legal = [&history](std::string_view word) {
+    for (const auto& [guess, pattern] : history) {
+      std::array<int, 26> needed{};
+      for (int i = 0; i < 5; ++i) {
+        if (pattern[i] == '2' && word[i] != guess[i]) {
+          return false;
+        }
+        if (pattern[i] != '0') {
+          needed[guess[i] - 'a']++;
+        }
+      }
+      for (int letter = 0; letter < 26; ++letter) {
+        if (std::count(word.begin(), word.end(), 'a' + letter) <
+            needed[letter]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  aletheia::HintConstraints hints;
+  aletheia::CandidateSet pool;
+  for (size_t guess_index : {3u, 250u, 611u, 17u}) {
+    const std::string guess(table.text(guess_index));
+    const std::string pattern = PatternFor(guess, target);
+    history.emplace_back(guess, pattern);
+    ASSERT_TRUE(hints.Add(guess, pattern));
+    solver.RestrictHardModePool(hints, &pool);
+
+    aletheia::CandidateSet fresh;
+    solver.RestrictHardModePool(hints, &fresh);
+    ASSERT_EQ(fresh.blocks(), pool.blocks());
+
+    std::vector<size_t> answers;
+    solver.FilterCandidates(hints, &answers);
+    size_t non_answers = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+      ASSERT_EQ(pool.Contains(i), legal(table.text(i))) << table.text(i);
+      non_answers += pool.Contains(i) && !hints.Matches(table.packed(i));
+    }
+    for (size_t index : answers) {
+      EXPECT_TRUE(pool.Contains(index));
+    }
+    if (history.size() == 1) {
+      // Words that are ruled out as answers can still be legal guesses.
+      EXPECT_GT(non_answers, 0u);
+    }
+  }
+  EXPECT_TRUE(pool.Contains(17));
+}
+
+TEST(WordleCandidateSet, BitmapFilteringMatchesIndexFiltering) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(500));
+  const size_t n = solver.words().size();
+  std::vector<size_t> all = AllIndices(solver);
+  std::vector<size_t> subset;
+  for (size_t i = 0; i < n; i += 3) {
+    subset.push_back(i);
+  }
+  aletheia::CandidateSet subset_set = aletheia::CandidateSet::FromIndices(
+      n, subset);
+  EXPECT_EQ(subset_set.Count(), subset.size());
+  EXPECT_EQ(aletheia::CandidateSet::All(n).Count(), n);
+
+  std::vector<size_t> guesses = {0, 7, 42, 99};
+  solver.PrecomputePatternBitmaps({7, 99});
+  EXPECT_TRUE(solver.HasPatternBitmaps(7));
+  EXPECT_FALSE(solver.HasPatternBitmaps(0));
+  for (size_t guess : guesses) {
+    EXPECT_EQ(solver.PatternCounts(guess, subset_set),
+              solver.PatternCounts(guess, subset));
+    EXPECT_EQ(solver.PatternCounts(guess, aletheia::CandidateSet::All(n)),
+              solver.PatternCounts(guess, all));
+    for (size_t target : {size_t{3}, size_t{150}, n - 1}) {
+      int pattern = solver.PatternAt(guess, target);
+      std::vector<size_t> expected;
+      solver.FilterCandidates(subset, solver.words()[guess].text,
+                              aletheia::WordleSolver::PatternString(pattern),
+                              &expected);
+      aletheia::CandidateSet filtered;
+      solver.FilterCandidates(subset_set, guess, pattern, &filtered);
+      std::vector<size_t> actual;
+      filtered.ToIndices(&actual);
+      EXPECT_EQ(actual, expected);
+    }
+  }
+}
+
+TEST(WordleDecisionTree, BookMatchesLiveSearch) {
+  std::vector<std::string> words = SampleWords(150);
+  aletheia::WordleSolver live;
+  live.SetWordList(words);
+  aletheia::DecisionTree tree = live.BuildDecisionTree(true, 6);
+  ASSERT_FALSE(tree.empty());
+
+  std::stringstream buffer;
+  ASSERT_TRUE(tree.Write(buffer));
+  aletheia::DecisionTree loaded;
+  ASSERT_TRUE(loaded.Read(buffer));
+  EXPECT_EQ(loaded.node_count(), tree.node_count());
+
+  aletheia::WordleSolver booked;
+  booked.SetWordList(words);
+  ASSERT_TRUE(booked.SetDecisionTree(std::move(loaded)));
+  EXPECT_TRUE(booked.HasDecisionTree(true));
+  EXPECT_FALSE(booked.HasDecisionTree(false));
+  for (size_t t = 0; t < words.size(); t += 7) {
+    auto expected = live.SolveToTarget(words[t], 6);
+    auto actual = booked.SolveToTarget(words[t], 6);
+    ASSERT_EQ(actual.size(), expected.size()) << words[t];
+    for (size_t i = 0; i < actual.size(); ++i) {
+      EXPECT_EQ(actual[i].guess, expected[i].guess);
+      EXPECT_EQ(actual[i].pattern, expected[i].pattern);
+      EXPECT_DOUBLE_EQ(actual[i].entropy, expected[i].entropy);
+    }
+  }
+
+  aletheia::WordleSolver other;
+  other.SetWordList(SampleWords(151));
+  EXPECT_FALSE(other.SetDecisionTree(live.BuildDecisionTree(true, 1)));
+}
+
+TEST(WordleSolveAll, MatchesPerTargetSolve) {
+  std::vector<std::string> words = SampleWords(200);
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+
+  std::vector<std::string> targets(words.begin(), words.begin() + 60);
+  targets.push_back("zz");
+  auto result = solver.SolveAll(targets, 4);
+  ASSERT_EQ(result.games.size(), targets.size());
+  EXPECT_GT(result.decisions, 0u);
+  for (size_t t = 0; t < targets.size(); ++t) {
+    const auto& game = result.games[t];
+    auto expected = solver.SolveToTarget(targets[t], 4);
+    ASSERT_EQ(game.steps.size(), expected.size()) << targets[t];
+    ASSERT_EQ(game.step_ms.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(game.steps[i].guess, expected[i].guess);
+      EXPECT_EQ(game.steps[i].pattern, expected[i].pattern);
+      EXPECT_DOUBLE_EQ(game.steps[i].entropy, expected[i].entropy);
+      EXPECT_DOUBLE_EQ(game.steps[i].info_bits, expected[i].info_bits);
+      EXPECT_EQ(game.steps[i].remaining_after, expected[i].remaining_after);
+    }
+    EXPECT_EQ(game.solved,
+              !expected.empty() && expected.back().pattern == "22222");
+  }
+  EXPECT_TRUE(result.games.back().steps.empty());
+}
+
+TEST(WordleEntropy, ExactScoringOfHistograms) {
+  using Counts = std::array<int, aletheia::WordleSolver::kPatternCount>;
+  Counts uniform{};
+  for (int pattern = 0; pattern < 8; ++pattern) {
+    uniform[pattern * 30] = 4;
+  }
+  EXPECT_EQ(aletheia::WordleSolver::EntropyOf(uniform, 32), 3.0);
+  Counts single{};
+  single[17] = 40000;
+  EXPECT_EQ(aletheia::WordleSolver::EntropyOf(single, 40000), 0.0);
+
+  // The same bucket sizes score identically wherever the buckets fall.
+  Counts forward{};
+  Counts backward{};
+  size_t total = 0;
+  for (int pattern = 0; pattern < 200; ++pattern) {
+    const int count = 1 + (pattern * 37) % 90 + (pattern == 3 ? 20000 : 0);
+    forward[pattern] = count;
+    backward[aletheia::WordleSolver::kPatternCount - 1 - pattern] = count;
+    total += static_cast<size_t>(count);
+  }
+  const double entropy = aletheia::WordleSolver::EntropyOf(forward, total);
+  EXPECT_EQ(aletheia::WordleSolver::EntropyOf(backward, total), entropy);
+  double textbook = 0.0;
+  for (int count : forward) {
+    if (count > 0) {
+      const double p = count / static_cast<double>(total);
+      textbook -= p * std::log2(p);
+    }
+  }
+  EXPECT_NEAR(entropy, textbook, 1e-12);
+
+  // Long scans go through interleaved sub-histograms; short ones do not.
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(3000));
+  const std::vector<size_t> all = AllIndices(solver);
+  for (size_t guess : {size_t{0}, size_t{1234}}) {
+    for (size_t size : {size_t{100}, all.size()}) {
+      const std::vector<size_t> targets(all.begin(), all.begin() + size);
+      Counts expected{};
+      for (size_t target : targets) {
+        expected[solver.PatternAt(guess, target)]++;
+      }
+      EXPECT_EQ(solver.PatternCounts(guess, targets), expected) << size;
+    }
+  }
+}
+
+TEST(WordleBranchAndBound, MatchesExhaustiveSearch) {
+  std::vector<std::string> words = SampleWords(600);
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+  std::vector<size_t> all = AllIndices(solver);
+
+  uint32_t state = 7;
+  auto next = [&]() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  };
+  for (int trial = 0; trial < 40; ++trial) {
+    size_t size = trial == 0 ? all.size()
+                             : 1 + next() % (trial < 20 ? 30 : 300);
+    std::vector<size_t> targets;
+    for (size_t index : all) {
+      if (targets.size() < size && next() % all.size() < size * 2) {
+        targets.push_back(index);
+      }
+    }
+    if (targets.empty()) {
+      targets.push_back(next() % all.size());
+    }
+    const std::vector<size_t>& pool = trial % 2 == 0 ? all : targets;
+
+    double expected_entropy = -1.0;
+    size_t expected_index = 0;
+    for (size_t guess : pool) {
+      auto counts = solver.PatternCounts(guess, targets);
+      double entropy = 0.0;
+      const double inv_total = 1.0 / static_cast<double>(targets.size());
+      for (int count : counts) {
+        if (count > 0) {
+          double p = count * inv_total;
+          entropy -= p * std::log2(p);
+        }
+      }
+      // Ranked by the solver's exact scoring, which matches the textbook
+      // sum up to rounding.
+      const double scored =
+          aletheia::WordleSolver::EntropyOf(counts, targets.size());
+      EXPECT_NEAR(scored, entropy, 1e-12);
+      if (scored > expected_entropy) {
+        expected_entropy = scored;
+        expected_index = guess;
+      }
+    }
+
+    double entropy = 0.0;
+    aletheia::WordleSolver::SearchStats stats;
+    std::string guess = solver.BestGuess(pool, targets, &entropy, &stats);
+    EXPECT_EQ(guess, solver.words()[expected_index].text) << "trial " << trial;
+    EXPECT_EQ(entropy, expected_entropy) << "trial " << trial;
+    EXPECT_EQ(stats.candidates, pool.size());
+    EXPECT_EQ(stats.evaluated + stats.pruned, pool.size());
+    if (trial == 0) {
+      EXPECT_GT(stats.pruned, 0u);
+    }
+  }
+}
+
+TEST(WordleBranchAndBound, MergesGuessesThatSplitAlike) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(800));
+  const std::vector<size_t> all = AllIndices(solver);
+
+  size_t merged = 0;
+  for (size_t t = 0; t < 12; ++t) {
+    // Late-game positions: two informative guesses toward a target.
+    const std::string target(solver.words().text(t * 61 % all.size()));
+    std::vector<size_t> remaining = all;
+    for (int turn = 0; turn < 2 && remaining.size() > 1; ++turn) {
+      const std::string guess = solver.BestGuess(all, remaining, nullptr);
+      std::vector<size_t> next;
+      solver.FilterCandidates(remaining, guess, PatternFor(guess, target),
+                              &next);
+      remaining = next;
+    }
+    if (remaining.size() < 2) {
+      continue;
+    }
+
+    // Ties go to the earliest guess; a remaining answer is the only one
+    // that can land in the 22222 bucket.
+    double expected_entropy = -1.0;
+    size_t expected_index = 0;
+    std::set<std::vector<int>> splits;
+    for (size_t guess : all) {
+      std::vector<int> split;
+      for (size_t answer : remaining) {
+        split.push_back(aletheia::WordleSolver::Pattern(
+            solver.words().packed(guess), solver.words().packed(answer)));
+      }
+      splits.insert(split);
+      const double entropy = aletheia::WordleSolver::EntropyOf(
+          solver.PatternCounts(guess, remaining), remaining.size());
+      if (entropy > expected_entropy) {
+        expected_entropy = entropy;
+        expected_index = guess;
+      }
+    }
+
+    double entropy = 0.0;
+    aletheia::WordleSolver::SearchStats stats;
+    const std::string guess =
+        solver.BestGuess(all, remaining, &entropy, &stats);
+    EXPECT_EQ(guess, solver.words()[expected_index].text) << target;
+    EXPECT_EQ(entropy, expected_entropy) << target;
+    // Only guesses with the very same split are merged.
+    EXPECT_LE(splits.size(), all.size() - stats.merged) << target;
+    EXPECT_LE(stats.merged, stats.pruned);
+    merged += stats.merged;
+  }
+  EXPECT_GT(merged, 0u);
+}
+
+// Plain minimax over every guess, no pruning or memo. Returns total guesses
+// (or the worst case) for the remaining set, or a huge value if the set
+// cannot be finished within guesses_left.
+int64_t BruteForceCost(const aletheia::WordleSolver& solver,
+                       const std::vector<size_t>& remaining,
+                       size_t guesses_left,
+                       bool hard_mode,
+                       bool worst_case) {
+  constexpr int64_t kInfeasible = int64_t{1} << 40;
+  if (remaining.empty()) {
+    return 0;
+  }
+  if (guesses_left == 0) {
+    return kInfeasible;
+  }
+  std::vector<size_t> pool = hard_mode ? remaining : AllIndices(solver);
+  int64_t best = kInfeasible;
+  for (size_t guess : pool) {
+    std::vector<std::vector<size_t>> buckets(243);
+    for (size_t index : remaining) {
+      int pattern = solver.PatternAt(guess, index);
+      if (pattern != 242) {
+        buckets[pattern].push_back(index);
+      }
+    }
+    bool informative = true;
+    for (const auto& bucket : buckets) {
+      informative = informative && bucket.size() < remaining.size();
+    }
+    if (!informative) {
+      continue;
+    }
+    int64_t cost = worst_case ? 1 : static_cast<int64_t>(remaining.size());
+    for (const auto& bucket : buckets) {
+      if (bucket.empty()) {
+        continue;
+      }
+      int64_t sub =
+          BruteForceCost(solver, bucket, guesses_left - 1, hard_mode,
+                         worst_case);
+      cost = worst_case ? std::max(cost, 1 + sub) : cost + sub;
+    }
+    best = std::min(best, std::min(cost, kInfeasible));
+  }
+  return best;
+}
+
+TEST(WordleOptimalPolicy, MatchesBruteForceAndDrivesSolveToTarget) {
+  std::vector<std::string> words = SampleWords(14);
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+  std::vector<size_t> all = AllIndices(solver);
+
+  for (bool hard_mode : {false, true}) {
+    for (bool worst_case : {false, true}) {
+      aletheia::WordleSolver::OptimalOptions options;
+      options.hard_mode = hard_mode;
+      options.objective =
+          worst_case ? aletheia::DecisionTree::Policy::kMinWorstCase
+                     : aletheia::DecisionTree::Policy::kMinExpected;
+      options.max_guesses = 6;
+      aletheia::WordleSolver::OptimalStats stats;
+      aletheia::DecisionTree tree = solver.BuildOptimalTree(options, &stats);
+      ASSERT_TRUE(stats.feasible);
+      ASSERT_FALSE(tree.empty());
+
+      int64_t expected = BruteForceCost(solver, all, 6, hard_mode, worst_case);
+      if (worst_case) {
+        EXPECT_EQ(static_cast<int64_t>(stats.worst_case), expected);
+      } else {
+        EXPECT_NEAR(stats.expected_guesses * all.size(),
+                    static_cast<double>(expected), 1e-9);
+      }
+
+      aletheia::WordleSolver player;
+      player.SetWordList(words);
+      ASSERT_TRUE(player.SetDecisionTree(std::move(tree)));
+      EXPECT_TRUE(player.HasDecisionTree(false));
+      EXPECT_EQ(player.HasDecisionTree(true), hard_mode);
+      size_t total = 0;
+      size_t worst = 0;
+      for (const std::string& word : words) {
+        auto steps = player.SolveToTarget(word, 6);
+        ASSERT_FALSE(steps.empty());
+        EXPECT_EQ(steps.back().pattern, "22222") << word;
+        total += steps.size();
+        worst = std::max(worst, steps.size());
+      }
+      EXPECT_EQ(worst, stats.worst_case);
+      EXPECT_NEAR(static_cast<double>(total) / words.size(),
+                  stats.expected_guesses, 1e-9);
+    }
+  }
+
+  aletheia::WordleSolver::OptimalOptions tight;
+  tight.max_guesses = 1;
+  aletheia::WordleSolver::OptimalStats stats;
+  EXPECT_TRUE(solver.BuildOptimalTree(tight, &stats).empty());
+  EXPECT_FALSE(stats.feasible);
+}
+
+double ExactEntropy(const aletheia::WordleSolver& solver, size_t guess,
+                    const std::vector<size_t>& targets) {
+  auto counts = solver.PatternCounts(guess, targets);
+  double entropy = 0.0;
+  const double inv_total = 1.0 / static_cast<double>(targets.size());
+  for (int count : counts) {
+    if (count > 0) {
+      double p = count * inv_total;
+      entropy -= p * std::log2(p);
+    }
+  }
+  return entropy;
+}
+
+TEST(WordleLookahead, MatchesBruteForceTwoPly) {
+  std::vector<std::string> words = SampleWords(200);
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+  std::vector<size_t> all = AllIndices(solver);
+  std::vector<size_t> targets;
+  for (size_t i = 0; i < all.size(); i += 3) {
+    targets.push_back(all[i]);
+  }
+
+  // Both modes over the whole dictionary and over the targets alone; the
+  // mode, not whether the pool equals the targets, picks second guesses.
+  const std::vector<std::pair<const std::vector<size_t>*, bool>> modes = {
+      {&all, false}, {&all, true}, {&targets, false}, {&targets, true}};
+  for (const auto& [pool, hard_mode] : modes) {
+    std::vector<std::pair<double, size_t>> ranked;
+    for (size_t guess : *pool) {
+      ranked.emplace_back(-ExactEntropy(solver, guess, targets), guess);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const auto& a, const auto& b) {
+                       return a.first < b.first;
+                     });
+    auto top = solver.TopGuesses(*pool, targets, 8);
+    ASSERT_EQ(top.size(), 8u);
+    for (size_t i = 0; i < top.size(); ++i) {
+      EXPECT_NEAR(top[i].entropy, -ranked[i].first, 1e-12);
+    }
+
+    auto greedy = solver.BestGuessLookahead(*pool, targets, 1, hard_mode);
+    double entropy = 0.0;
+    EXPECT_EQ(solver.words()[greedy.guess].text,
+              solver.BestGuess(*pool, targets, &entropy));
+
+    const size_t beam = 6;
+    double best_score = -1.0;
+    for (size_t g = 0; g < beam; ++g) {
+      std::vector<std::vector<size_t>> buckets(243);
+      for (size_t target : targets) {
+        buckets[solver.PatternAt(top[g].index, target)].push_back(target);
+      }
+      double score = top[g].entropy;
+      for (int pattern = 0; pattern < 242; ++pattern) {
+        const std::vector<size_t>& bucket = buckets[pattern];
+        if (bucket.size() < 2) {
+          continue;
+        }
+        std::vector<size_t> second = *pool;
+        if (hard_mode) {
+          aletheia::HintConstraints hint;
+          ASSERT_TRUE(hint.Add(solver.words()[top[g].index].text,
+                               aletheia::WordleSolver::PatternString(pattern)));
+          std::erase_if(second, [&](size_t guess) {
+            return !hint.AllowsGuess(solver.words().packed(guess));
+          });
+        }
+        double best = 0.0;
+        for (size_t guess : second) {
+          best = std::max(best, ExactEntropy(solver, guess, bucket));
+        }
+        score += static_cast<double>(bucket.size()) / targets.size() * best;
+      }
+      best_score = std::max(best_score, score);
+    }
+    auto result = solver.BestGuessLookahead(*pool, targets, beam, hard_mode);
+    EXPECT_EQ(result.beam, beam);
+    EXPECT_NEAR(result.score, best_score, 1e-9);
+    EXPECT_GE(result.score, greedy.score - 1e-12);
+    EXPECT_GT(result.second_ply_searches, 0u);
+  }
+
+  solver.SetLookahead(4);
+  for (size_t i = 0; i < words.size(); i += 17) {
+    auto steps = solver.SolveToTarget(words[i], 8);
+    ASSERT_FALSE(steps.empty());
+    EXPECT_EQ(steps.back().pattern, "22222") << words[i];
+  }
+}
+
+TEST(WordleGuessCache, EvictsLeastRecentlyUsedPerShard) {
+  aletheia::GuessCache cache;
+  aletheia::GuessCache::Entry entry;
+  cache.Store({0, 1}, {1, 1.0});
+  EXPECT_FALSE(cache.Find({0, 1}, &entry));
+
+  cache.SetCapacity(2 * aletheia::GuessCache::kShardCount);
+  const uint64_t shards = aletheia::GuessCache::kShardCount;
+  cache.Store({0, 1}, {1, 1.0});
+  cache.Store({shards, 2}, {2, 2.0});
+  ASSERT_TRUE(cache.Find({0, 1}, &entry));
+  EXPECT_EQ(entry.guess, 1u);
+  cache.Store({2 * shards, 3}, {3, 3.0});
+  EXPECT_TRUE(cache.Find({0, 1}, &entry));
+  EXPECT_FALSE(cache.Find({shards, 2}, &entry));
+  EXPECT_TRUE(cache.Find({2 * shards, 3}, &entry));
+  EXPECT_DOUBLE_EQ(entry.entropy, 3.0);
+
+  aletheia::GuessCache::Stats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.size, 2u);
+}
+
+TEST(WordleGuessCache, ReusesAndPersistsSearches) {
+  std::vector<std::string> words = SampleWords(300);
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+  std::vector<size_t> all = AllIndices(solver);
+  double cold_entropy = 0.0;
+  std::string cold = solver.BestGuess(all, all, &cold_entropy);
+
+  solver.EnableGuessCache(1024);
+  double entropy = 0.0;
+  EXPECT_EQ(solver.BestGuess(all, all, &entropy), cold);
+  EXPECT_EQ(solver.BestGuess(all, all, &entropy), cold);
+  EXPECT_DOUBLE_EQ(entropy, cold_entropy);
+  EXPECT_EQ(solver.GuessCacheStats().hits, 1u);
+
+  std::vector<size_t> subset(all.begin(), all.begin() + 50);
+  std::string hard = solver.BestGuess(subset, subset, &entropy);
+  std::string easy = solver.BestGuess(all, subset, &entropy);
+  aletheia::WordleSolver reference;
+  reference.SetWordList(words);
+  EXPECT_EQ(hard, reference.BestGuess(subset, subset, &entropy));
+  EXPECT_EQ(easy, reference.BestGuess(all, subset, &entropy));
+
+  for (const std::string& word : {words[3], words[40], words[3]}) {
+    auto cached = solver.SolveToTarget(word, 8);
+    auto fresh = reference.SolveToTarget(word, 8);
+    ASSERT_EQ(cached.size(), fresh.size());
+    for (size_t i = 0; i < cached.size(); ++i) {
+      EXPECT_EQ(cached[i].guess, fresh[i].guess);
+    }
+  }
+
+  const std::string path = ::testing::TempDir() + "guess_cache.bin";
+  ASSERT_TRUE(solver.SaveGuessCache(path));
+  aletheia::WordleSolver warm;
+  warm.SetWordList(words);
+  warm.EnableGuessCache(1024);
+  ASSERT_TRUE(warm.LoadGuessCache(path));
+  EXPECT_EQ(warm.GuessCacheStats().size, solver.GuessCacheStats().size);
+  EXPECT_EQ(warm.BestGuess(all, all, &entropy), cold);
+  EXPECT_EQ(warm.GuessCacheStats().hits, 1u);
+
+  aletheia::WordleSolver other;
+  other.SetWordList(SampleWords(299));
+  other.EnableGuessCache(1024);
+  EXPECT_FALSE(other.LoadGuessCache(path));
+  std::remove(path.c_str());
+}
+
+TEST(WordleLengthVariants, FiveLetterInstanceMatchesWordleSolver) {
+  std::vector<std::string> words = SampleWords(400);
+  aletheia::WordleSolver reference;
+  reference.SetWordList(words);
+  aletheia::BasicWordleSolver<5> solver;
+  solver.SetWordList(words);
+  ASSERT_EQ(solver.words().size(), reference.words().size());
+  for (size_t g = 0; g < solver.words().size(); g += 7) {
+    for (size_t t = 0; t < solver.words().size(); ++t) {
+      ASSERT_EQ(solver.PatternAt(g, t), reference.PatternAt(g, t))
+          << solver.words()[g] << " vs " << solver.words()[t];
+    }
+  }
+  std::vector<size_t> all = AllIndices(reference);
+  double expected = 0.0;
+  double entropy = 0.0;
+  EXPECT_EQ(solver.BestGuess(all, all, &entropy),
+            reference.BestGuess(all, all, &expected));
+  EXPECT_DOUBLE_EQ(entropy, expected);
+  for (size_t i = 0; i < words.size(); i += 37) {
+    auto steps = solver.SolveToTarget(words[i], 8);
+    auto fresh = reference.SolveToTarget(words[i], 8);
+    ASSERT_EQ(steps.size(), fresh.size());
+    for (size_t s = 0; s < steps.size(); ++s) {
+      EXPECT_EQ(steps[s].guess, fresh[s].guess);
+      EXPECT_EQ(steps[s].pattern, fresh[s].pattern);
+    }
+  }
+}
+
+TEST(WordleLengthVariants, SolvesLongerWordsAndCustomAlphabets) {
+  using Seven = aletheia::BasicWordleSolver<7>;
+  EXPECT_EQ(Seven::kPatternCount, 2187);
+  static_assert(std::is_same_v<Seven::PatternCode, uint16_t>);
+  static_assert(std::is_same_v<Seven::Letters, uint64_t>);
+  static_assert(
+      std::is_same_v<aletheia::BasicWordleSolver<4>::PatternCode, uint8_t>);
+
+  Seven solver;
+  EXPECT_EQ(solver.PatternString(
+                Seven::Pattern(solver.EncodeWord("letters"),
+                               solver.EncodeWord("settler"))),
+            "1222111");
+  EXPECT_EQ(Seven::ParsePattern("2222222"), Seven::kSolvedPattern);
+
+  std::vector<std::string> base = SampleWords(600);
+  std::vector<std::string> words;
+  for (size_t i = 0; i + 1 < base.size(); i += 2) {
+    words.push_back(base[i] + base[i + 1].substr(0, 2));
+  }
+  solver.SetWordList(words);
+  ASSERT_GT(solver.words().size(), 250u);
+  // The shared branch-and-bound search on 16-bit codes agrees with
+  // scoring every guess.
+  std::vector<size_t> all(solver.words().size());
+  std::iota(all.begin(), all.end(), 0);
+  double best_entropy = -1.0;
+  size_t best_guess = 0;
+  for (size_t guess : all) {
+    auto counts = solver.PatternCounts(guess, all);
+    double entropy = 0.0;
+    for (int count : counts) {
+      if (count > 0) {
+        double p = static_cast<double>(count) / all.size();
+        entropy -= p * std::log2(p);
+      }
+    }
+    if (entropy > best_entropy + 1e-9) {
+      best_entropy = entropy;
+      best_guess = guess;
+    }
+  }
+  Seven::SearchStats stats;
+  double entropy = 0.0;
+  EXPECT_EQ(solver.BestGuess(all, all, &entropy, &stats),
+            solver.words()[best_guess]);
+  EXPECT_NEAR(entropy, best_entropy, 1e-9);
+  EXPECT_LT(stats.evaluated, all.size());
+  for (size_t i = 0; i < solver.words().size(); i += 29) {
+    auto steps = solver.SolveToTarget(solver.words()[i], 10);
+    ASSERT_FALSE(steps.empty());
+    EXPECT_EQ(steps.back().pattern, "2222222") << solver.words()[i];
+  }
+
+  aletheia::BasicWordleSolver<4> symbols("0123456789abcdefghijklmnop");
+  symbols.SetWordList({"12AB", "0p0p", "z123", "12ab", "9876"});
+  ASSERT_EQ(symbols.words().size(), 3u);
+  EXPECT_EQ(symbols.IndexOf("9876"), 2u);
+  EXPECT_EQ(symbols.PatternString(symbols.Pattern(symbols.EncodeWord("0p0p"),
+                                                  symbols.EncodeWord("p000"))),
+            "1120");
+  aletheia::BasicWordleSolver<4> duplicate("aacdefghijklmnopqrstuvwxyz");
+  duplicate.SetWordList({"acde"});
+  EXPECT_TRUE(duplicate.words().empty());
+}
+
+TEST(WordleMultiBoard, MatchesPerBoardScoringAndSolves) {
+  std::vector<std::string> words = SampleWords(500);
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+  std::vector<size_t> all = AllIndices(solver);
+
+  for (bool matrix : {false, true}) {
+    if (matrix) {
+      solver.EnablePatternMatrix("");
+    }
+    std::vector<std::vector<size_t>> boards(4);
+    for (size_t b = 0; b < boards.size(); ++b) {
+      for (size_t index : all) {
+        if ((index * 7 + b * 13) % (b + 3) == 0) {
+          boards[b].push_back(index);
+        }
+      }
+    }
+    boards.push_back(boards[1]);
+    boards.push_back({all[9]});
+
+    double expected_entropy = -1.0;
+    size_t expected_index = 0;
+    for (size_t guess : all) {
+      double entropy = 0.0;
+      for (const auto& board : boards) {
+        if (board.size() < 2) {
+          continue;
+        }
+        double board_entropy = 0.0;
+        for (int count : solver.PatternCounts(guess, board)) {
+          if (count > 0) {
+            double p = static_cast<double>(count) / board.size();
+            board_entropy -= p * std::log2(p);
+          }
+        }
+        entropy += board_entropy;
+      }
+      if (entropy > expected_entropy + 1e-12) {
+        expected_entropy = entropy;
+        expected_index = guess;
+      }
+    }
+    double entropy = 0.0;
+    EXPECT_EQ(solver.BestMultiGuess(all, boards, &entropy),
+              solver.words()[expected_index].text);
+    EXPECT_NEAR(entropy, expected_entropy, 1e-9);
+  }
+
+  double single = 0.0;
+  double multi = 0.0;
+  std::vector<std::vector<size_t>> same(3, all);
+  EXPECT_EQ(solver.BestMultiGuess(all, same, &multi),
+            solver.BestGuess(all, all, &single));
+  EXPECT_NEAR(multi, 3 * single, 1e-9);
+
+  std::vector<std::string> targets = {words[2], words[111], words[222],
+                                      words[333]};
+  auto game = solver.SolveMultiToTargets(targets, 9);
+  ASSERT_TRUE(game.solved);
+  ASSERT_EQ(game.solved_turn.size(), targets.size());
+  for (size_t b = 0; b < targets.size(); ++b) {
+    size_t turn = game.solved_turn[b];
+    ASSERT_GT(turn, 0u);
+    EXPECT_EQ(game.guesses[turn - 1], targets[b]);
+    EXPECT_EQ(game.patterns[turn - 1][b], "22222");
+  }
+  EXPECT_EQ(game.guesses.size(),
+            *std::max_element(game.solved_turn.begin(),
+                              game.solved_turn.end()));
+}
+
+TEST(WordleAdversarial, MinimaxMatchesBruteForceAndForcesWins) {
+  std::vector<std::string> words = SampleWords(40);
+  aletheia::WordleSolver solver;
+  solver.SetWordList(words);
+  std::vector<size_t> all = AllIndices(solver);
+  std::vector<size_t> subset;
+  for (size_t i = 0; i < all.size(); i += 3) {
+    subset.push_back(all[i]);
+  }
+
+  for (bool hard_mode : {false, true}) {
+    aletheia::WordleSolver::AdversarialOptions options;
+    options.hard_mode = hard_mode;
+    options.max_guesses = 6;
+    auto result = solver.SolveAdversarial(subset, options);
+    ASSERT_GT(result.guesses, 0u);
+    EXPECT_TRUE(result.proven_optimal);
+    const int64_t bound = static_cast<int64_t>(result.guesses);
+    EXPECT_EQ(BruteForceCost(solver, subset, result.guesses, hard_mode, true),
+              bound);
+    EXPECT_GT(
+        BruteForceCost(solver, subset, result.guesses - 1, hard_mode, true),
+        bound);
+
+    // The adversary answers with its hardest bucket every turn; following
+    // the solver still wins within the proven bound.
+    std::vector<size_t> remaining = subset;
+    size_t guesses = 0;
+    while (true) {
+      options.max_guesses = 6 - guesses;
+      auto step = solver.SolveAdversarial(remaining, options);
+      ASSERT_GT(step.guesses, 0u);
+      EXPECT_EQ(step.guesses + guesses, result.guesses);
+      ++guesses;
+      int pattern = solver.AdversarialPattern(step.guess, remaining, options);
+      if (pattern == 242) {
+        break;
+      }
+      std::vector<size_t> next;
+      for (size_t index : remaining) {
+        if (solver.PatternAt(step.guess, index) == pattern) {
+          next.push_back(index);
+        }
+      }
+      ASSERT_FALSE(next.empty());
+      remaining.swap(next);
+    }
+    EXPECT_EQ(guesses, result.guesses);
+  }
+
+  aletheia::WordleSolver::AdversarialOptions tight;
+  tight.max_guesses = 1;
+  EXPECT_EQ(solver.SolveAdversarial(subset, tight).guesses, 0u);
+}
+
+TEST(WordleThreadPool, ParallelLoopsMatchSerialSearch) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(500));
+  const std::vector<size_t> all = AllIndices(solver);
+
+  aletheia::ThreadPool::Configure(1);
+  double serial_entropy = 0.0;
+  const std::string serial = solver.BestGuess(all, all, &serial_entropy);
+  const auto serial_top = solver.TopGuesses(all, all, 8);
+
+  aletheia::ThreadPool::Configure(4);
+  aletheia::ThreadPool& pool = aletheia::ThreadPool::Instance();
+  EXPECT_EQ(pool.threads(), 4u);
+
+  std::vector<int> hits(1003, 0);
+  pool.ParallelFor(0, hits.size(), 7, [&](size_t i) { hits[i]++; });
+  EXPECT_TRUE(std::all_of(hits.begin(), hits.end(),
+                          [](int count) { return count == 1; }));
+
+  // Nested loops run on the same workers; chunks fold in order, so the
+  // earliest maximum wins however the chunks were scheduled.
+  using Best = std::pair<size_t, size_t>;
+  const Best best = pool.ParallelReduce(
+      0, 64, 1, Best(0, 0),
+      [&](size_t lo, size_t) {
+        std::vector<size_t> inner(100, 0);
+        pool.ParallelFor(0, inner.size(), 10,
+                         [&](size_t i) { inner[i] = (lo * 31 + i) % 17; });
+        return Best(std::accumulate(inner.begin(), inner.end(), size_t{0}) %
+                        5,
+                    lo);
+      },
+      [](const Best& a, const Best& b) { return b.first > a.first ? b : a; });
+  EXPECT_EQ(best.first, 4u);
+  for (size_t lo = 0; lo < best.second; ++lo) {
+    size_t sum = 0;
+    for (size_t i = 0; i < 100; ++i) {
+      sum += (lo * 31 + i) % 17;
+    }
+    EXPECT_LT(sum % 5, 4u);
+  }
+
+  double parallel_entropy = 0.0;
+  EXPECT_EQ(solver.BestGuess(all, all, &parallel_entropy), serial);
+  EXPECT_EQ(parallel_entropy, serial_entropy);
+  const auto parallel_top = solver.TopGuesses(all, all, 8);
+  ASSERT_EQ(parallel_top.size(), serial_top.size());
+  for (size_t i = 0; i < serial_top.size(); ++i) {
+    EXPECT_EQ(parallel_top[i].index, serial_top[i].index);
+    EXPECT_EQ(parallel_top[i].entropy, serial_top[i].entropy);
+  }
+  aletheia::ThreadPool::Configure(0);
+}
+
+TEST(WordleGameSession, ConcurrentSessionsShareOneSolver) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(600));
+  const aletheia::WordTable& words = solver.words();
+
+  // Reference games played with the solver's free functions.
+  constexpr size_t kGames = 24;
+  std::vector<std::vector<std::string>> expected(kGames);
+  for (size_t game = 0; game < kGames; ++game) {
+    const aletheia::PackedWord target = words.packed(game * 23 % words.size());
+    const bool hard_mode = game % 2 == 1;
+    std::vector<size_t> remaining = AllIndices(solver);
+    aletheia::HintConstraints hints;
+    aletheia::CandidateSet pool;
+    std::vector<size_t> pool_indices = remaining;
+    for (int turn = 0; turn < 6 && !remaining.empty(); ++turn) {
+      const std::string guess =
+          remaining.size() == 1
+              ? std::string(words.text(remaining[0]))
+              : solver.BestGuess(pool_indices, remaining, nullptr);
+      expected[game].push_back(guess);
+      const std::string pattern = aletheia::WordleSolver::PatternString(
+          aletheia::WordleSolver::Pattern(
+              aletheia::WordleSolver::EncodeWord(guess), target));
+      if (pattern == "22222") {
+        break;
+      }
+      std::vector<size_t> next;
+      solver.FilterCandidates(remaining, guess, pattern, &next);
+      remaining.swap(next);
+      hints.Add(guess, pattern);
+      if (hard_mode) {
+        solver.RestrictHardModePool(hints, &pool);
+        pool.ToIndices(&pool_indices);
+      }
+    }
+  }
+
+  std::vector<aletheia::GameSession> sessions;
+  for (size_t game = 0; game < kGames; ++game) {
+    sessions.emplace_back(solver, game % 2 == 1);
+    EXPECT_EQ(&sessions.back().remaining(), &solver.all_indices());
+  }
+  std::vector<std::vector<std::string>> played(kGames);
+  aletheia::ThreadPool::Configure(4);
+  aletheia::ThreadPool::Instance().ParallelFor(0, kGames, 1, [&](size_t game) {
+    aletheia::GameSession& session = sessions[game];
+    const aletheia::PackedWord target = words.packed(game * 23 % words.size());
+    for (int turn = 0; turn < 6; ++turn) {
+      const std::string guess = session.Suggest();
+      if (guess.empty()) {
+        break;
+      }
+      played[game].push_back(guess);
+      const std::string pattern = aletheia::WordleSolver::PatternString(
+          aletheia::WordleSolver::Pattern(
+              aletheia::WordleSolver::EncodeWord(guess), target));
+      if (pattern == "22222") {
+        break;
+      }
+      ASSERT_TRUE(session.AllowsGuess(guess));
+      ASSERT_TRUE(session.ApplyFeedback(guess, pattern));
+    }
+  });
+  aletheia::ThreadPool::Configure(0);
+  for (size_t game = 0; game < kGames; ++game) {
+    EXPECT_EQ(played[game], expected[game]) << "game " << game;
+  }
+
+  // Malformed or contradictory feedback leaves the session untouched.
+  aletheia::GameSession session(solver);
+  const std::string first(words.text(0));
+  ASSERT_TRUE(session.ApplyFeedback(first, "22222"));
+  const std::vector<size_t> solved = session.remaining();
+  EXPECT_TRUE(session.IsCandidate(first));
+  EXPECT_FALSE(session.ApplyFeedback("xx", "00000"));
+  EXPECT_FALSE(session.ApplyFeedback(first, "00300"));
+  EXPECT_FALSE(session.ApplyFeedback(first, "00000"));
+  EXPECT_EQ(session.remaining(), solved);
+  EXPECT_EQ(session.turns(), 1u);
+  session.Reset();
+  EXPECT_EQ(session.turns(), 0u);
+  EXPECT_EQ(session.remaining().size(), words.size());
+}
+
+TEST(WordleBatch, MatchesPerSetSearches) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(400));
+  const aletheia::WordTable& words = solver.words();
+  const std::vector<size_t> all = AllIndices(solver);
+
+  // Filtered sets of every size, repeats, an empty set and more sets than
+  // one sweep takes.
+  std::vector<std::vector<size_t>> sets;
+  for (size_t i = 0; sets.size() < 80; ++i) {
+    const std::string guess(words.text(i * 7 % words.size()));
+    const std::string target(words.text(i * 13 % words.size()));
+    std::vector<size_t> remaining;
+    solver.FilterCandidates(all, guess, PatternFor(guess, target), &remaining);
+    sets.push_back(remaining);
+    if (i % 9 == 0) {
+      sets.push_back(remaining);
+    }
+  }
+  sets.push_back({});
+  sets.push_back(all);
+  std::vector<const std::vector<size_t>*> set_pointers;
+  for (const auto& set : sets) {
+    set_pointers.push_back(&set);
+  }
+  const std::vector<size_t> pool(all.begin(), all.begin() + 150);
+
+  for (bool matrix : {false, true}) {
+    if (matrix) {
+      solver.EnablePatternMatrix("");
+    }
+    for (const std::vector<size_t>* candidates : {&all, &pool}) {
+      std::vector<double> entropies;
+      const std::vector<size_t> guesses =
+          solver.BestGuessBatch(*candidates, set_pointers, &entropies);
+      ASSERT_EQ(guesses.size(), sets.size());
+      for (size_t s = 0; s < sets.size(); ++s) {
+        double entropy = 0.0;
+        EXPECT_EQ(std::string(words.text(guesses[s])),
+                  solver.BestGuess(*candidates, sets[s], &entropy))
+            << "set " << s;
+        EXPECT_EQ(entropies[s], entropy) << "set " << s;
+      }
+    }
+  }
+  EXPECT_EQ(solver.BestGuessBatch({}, set_pointers, nullptr),
+            std::vector<size_t>(sets.size(), aletheia::WordleSolver::kNoIndex));
+
+  // Sessions mixing the opening, mid-game searches, hard mode and solved
+  // positions answer exactly as they do alone.
+  std::vector<aletheia::GameSession> games;
+  for (size_t game = 0; game < 12; ++game) {
+    games.emplace_back(solver, game % 3 == 2);
+    const std::string target(words.text(game * 31 % words.size()));
+    for (size_t turn = 0; turn < game % 4; ++turn) {
+      const std::string guess = games.back().Suggest();
+      games.back().ApplyFeedback(guess, PatternFor(guess, target));
+    }
+  }
+  std::vector<const aletheia::GameSession*> session_pointers;
+  for (const auto& game : games) {
+    session_pointers.push_back(&game);
+  }
+  std::vector<double> entropies;
+  const std::vector<std::string> suggestions =
+      aletheia::GameSession::SuggestBatch(session_pointers, &entropies);
+  for (size_t game = 0; game < games.size(); ++game) {
+    double entropy = 0.0;
+    EXPECT_EQ(suggestions[game], games[game].Suggest(&entropy));
+    EXPECT_EQ(entropies[game], entropy);
+  }
+
+  // The server batches a run of suggests and answers each as Handle would.
+  aletheia::SolverServer::Options options;
+  options.workers = 1;
+  aletheia::SolverServer server(solver, options);
+  std::vector<std::string> requests;
+  std::vector<std::string> expected;
+  for (size_t game = 0; game < 5; ++game) {
+    const std::string name = "b" + std::to_string(game);
+    server.Handle(R"({"op":"new","session":")" + name + "\"}");
+    requests.push_back(R"({"id":)" + std::to_string(game) +
+                       R"(,"op":"suggest","session":")" + name + "\"}");
+  }
+  requests.push_back(requests[1]);
+  requests.push_back(R"({"op":"suggest","session":"missing"})");
+  for (const std::string& request : requests) {
+    expected.push_back(server.Handle(request));
+  }
+  EXPECT_EQ(server.HandleBatch(requests), expected);
+}
+
+TEST(WordleAnytime, DeadlineTradesExactnessForLatency) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(500));
+  const aletheia::WordTable& words = solver.words();
+  const std::vector<size_t> all = AllIndices(solver);
+  std::vector<std::vector<size_t>> sets = {all};
+  for (size_t i = 0; i < 6; ++i) {
+    const std::string guess(words.text(i * 41));
+    const std::string target(words.text(i * 97 + 3));
+    std::vector<size_t> remaining;
+    solver.FilterCandidates(all, guess, PatternFor(guess, target), &remaining);
+    sets.push_back(remaining);
+  }
+
+  for (const auto& targets : sets) {
+    // With time to spare the answer is the exact search's.
+    double expected_entropy = 0.0;
+    const std::string expected =
+        solver.BestGuess(all, targets, &expected_entropy);
+    double entropy = 0.0;
+    bool exact = false;
+    EXPECT_EQ(solver.BestGuessWithin(all, targets, std::chrono::hours(1),
+                                     &entropy, &exact),
+              expected);
+    EXPECT_TRUE(exact);
+    EXPECT_EQ(entropy, expected_entropy);
+
+    // Out of time at once, the answer is still a scored guess: its reported
+    // entropy is its exact score on every target.
+    exact = true;
+    const std::string hurried = solver.BestGuessWithin(
+        all, targets, std::chrono::microseconds(0), &entropy, &exact);
+    const auto scored = solver.TopGuesses(all, targets, all.size());
+    const auto it =
+        std::find_if(scored.begin(), scored.end(), [&](const auto& item) {
+          return words.text(item.index) == hurried;
+        });
+    ASSERT_NE(it, scored.end());
+    EXPECT_NEAR(entropy, it->entropy, 1e-12);
+    EXPECT_LE(entropy, expected_entropy + 1e-12);
+    EXPECT_FALSE(exact);
+  }
+
+  // Under lookahead the budget covers both plies: with time to spare the
+  // answer is the two-ply one, and out of time it is a scored first guess.
+  solver.SetLookahead(4);
+  ASSERT_GE(sets[1].size(), 3u);
+  for (const bool hard_mode : {false, true}) {
+    const std::vector<size_t>& pool = hard_mode ? sets[1] : all;
+    aletheia::WordleSolver::SearchStats stats;
+    const std::string two_ply =
+        solver.BestGuess(pool, sets[1], nullptr, nullptr, hard_mode);
+    bool exact = false;
+    EXPECT_EQ(solver.BestGuessWithin(pool, sets[1], std::chrono::hours(1),
+                                     nullptr, &exact, &stats, hard_mode),
+              two_ply);
+    EXPECT_TRUE(exact);
+    EXPECT_EQ(stats.candidates, pool.size());
+    EXPECT_EQ(solver.BestGuessAsync(pool, sets[1], std::chrono::hours(1),
+                                    hard_mode)
+                  .Get()
+                  .guess,
+              two_ply);
+    double entropy = 0.0;
+    const std::string hurried =
+        solver.BestGuessWithin(pool, sets[1], std::chrono::microseconds(0),
+                               &entropy, &exact, nullptr, hard_mode);
+    EXPECT_FALSE(exact);
+    EXPECT_NEAR(entropy,
+                solver.EntropyOf(solver.PatternCounts(solver.IndexOf(hurried),
+                                                      sets[1]),
+                                 sets[1].size()),
+                1e-12);
+  }
+  solver.SetLookahead(0);
+
+  // A lone answer needs no search, so any budget is exact.
+  aletheia::GameSession session(solver);
+  const std::string target(words.text(7));
+  while (session.remaining().size() > 1) {
+    const std::string guess = session.Suggest();
+    ASSERT_TRUE(session.ApplyFeedback(guess, PatternFor(guess, target)));
+  }
+  bool exact = false;
+  EXPECT_EQ(session.SuggestWithin(std::chrono::microseconds(0), nullptr,
+                                  &exact),
+            target);
+  EXPECT_TRUE(exact);
+
+  aletheia::SolverServer::Options options;
+  options.workers = 1;
+  aletheia::SolverServer server(solver, options);
+  server.Handle(R"({"op":"new","session":"t"})");
+  double opening_entropy = 0.0;
+  const std::string opening = solver.BestGuess(all, all, &opening_entropy);
+  std::ostringstream expected;
+  expected << R"({"ok":true,"guess":")" << opening << R"(","entropy":)"
+           << opening_entropy << R"(,"exact":true,"remaining":500})";
+  EXPECT_EQ(
+      server.Handle(R"({"op":"suggest","session":"t","deadline_ms":60000})"),
+      expected.str());
+}
+
+TEST(WordleAsync, CancellationStopsSearchesEarly) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(1200));
+  const std::vector<size_t> all = AllIndices(solver);
+
+  // Left alone, the background search is the foreground one.
+  double expected_entropy = 0.0;
+  const std::string expected = solver.BestGuess(all, all, &expected_entropy);
+  aletheia::GuessFuture future = solver.BestGuessAsync(all, all);
+  ASSERT_TRUE(future.valid());
+  const aletheia::GuessFuture::Result& result = future.Get();
+  EXPECT_EQ(result.guess, expected);
+  EXPECT_EQ(result.entropy, expected_entropy);
+  EXPECT_TRUE(result.exact);
+  EXPECT_FALSE(result.cancelled);
+  EXPECT_TRUE(future.ready());
+
+  // A superseded search hands back whatever it has, promptly.
+  aletheia::GuessFuture stale = solver.BestGuessAsync(all, all);
+  stale.Cancel();
+  const auto cancelled_at = std::chrono::steady_clock::now();
+  const aletheia::GuessFuture::Result& partial = stale.Get();
+  EXPECT_LT(std::chrono::steady_clock::now() - cancelled_at,
+            std::chrono::milliseconds(250));
+  EXPECT_TRUE(partial.cancelled);
+  EXPECT_TRUE(aletheia::WordleSolver::IsValidWord(partial.guess));
+  {
+    aletheia::GuessFuture dropped = solver.BestGuessAsync(all, all);
+  }
+
+  // Cancelling a moved-from handle leaves the search that moved away alone.
+  aletheia::GuessFuture moved_from = solver.BestGuessAsync(all, all);
+  aletheia::GuessFuture moved_to = std::move(moved_from);
+  moved_from.Cancel();
+  EXPECT_TRUE(moved_from.token().cancelled());
+  EXPECT_FALSE(moved_to.token().cancelled());
+  EXPECT_FALSE(moved_to.Get().cancelled);
+  EXPECT_EQ(moved_to.Get().guess, expected);
+  aletheia::GuessFuture assigned;
+  assigned = std::move(moved_to);
+  moved_to.Cancel();
+  EXPECT_FALSE(assigned.token().cancelled());
+  EXPECT_FALSE(moved_to.valid());
+
+  // Lookahead hands the token to its first ply and every bucket's search.
+  solver.SetLookahead(8);
+  const std::string two_ply = solver.BestGuess(all, all, &expected_entropy);
+  aletheia::GuessFuture ahead = solver.BestGuessAsync(all, all);
+  EXPECT_EQ(ahead.Get().guess, two_ply);
+  EXPECT_TRUE(ahead.Get().exact);
+  aletheia::GuessFuture abandoned = solver.BestGuessAsync(all, all);
+  abandoned.Cancel();
+  const auto abandoned_at = std::chrono::steady_clock::now();
+  const aletheia::GuessFuture::Result& cut = abandoned.Get();
+  EXPECT_LT(std::chrono::steady_clock::now() - abandoned_at,
+            std::chrono::milliseconds(250));
+  EXPECT_TRUE(cut.cancelled);
+  EXPECT_TRUE(aletheia::WordleSolver::IsValidWord(cut.guess));
+  solver.SetLookahead(0);
+
+  aletheia::CancelToken token;
+  const auto full = solver.PatternCounts(all[0], all, &token);
+  EXPECT_EQ(std::accumulate(full.begin(), full.end(), 0),
+            static_cast<int>(all.size()));
+  token.Cancel();
+  const auto none = solver.PatternCounts(all[0], all, &token);
+  EXPECT_EQ(std::accumulate(none.begin(), none.end(), 0), 0);
+
+  Eigen::MatrixXd similarity = Eigen::MatrixXd::Zero(16, 16);
+  for (int i = 0; i < 16; ++i) {
+    for (int j = 0; j < 16; ++j) {
+      similarity(i, j) = i / 4 == j / 4 ? 1.0 : 0.0;
+    }
+  }
+  aletheia::ConnectionsSolver connections(similarity);
+  EXPECT_TRUE(connections.SolveBestPartition(&token).empty());
+  EXPECT_EQ(connections.SolveBestPartition().size(), 4u);
+
+  // Positions that need no search are answered on the spot.
+  aletheia::GameSession session(solver);
+  const std::string target(solver.words().text(11));
+  while (session.remaining().size() > 1) {
+    const std::string guess = session.Suggest();
+    ASSERT_TRUE(session.ApplyFeedback(guess, PatternFor(guess, target)));
+  }
+  aletheia::GuessFuture lone = session.SuggestAsync();
+  EXPECT_TRUE(lone.ready());
+  EXPECT_EQ(lone.Get().guess, target);
+}
+
+TEST(WordleSpeculation, PrecomputedFollowUpsMatchLiveSearches) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(600));
+  aletheia::GameSession session(solver);
+  const std::string guess = session.Suggest();
+  const auto counts =
+      solver.PatternCounts(solver.IndexOf(guess), session.remaining());
+  const int biggest = static_cast<int>(
+      std::max_element(counts.begin(), counts.end()) - counts.begin());
+  const std::string pattern = aletheia::WordleSolver::PatternString(biggest);
+
+  aletheia::SuggestionSpeculator speculator;
+  speculator.Start(session, guess, 4);
+  ASSERT_TRUE(speculator.active());
+  speculator.Wait();
+  aletheia::SuggestionSpeculator::Outcome outcome;
+  ASSERT_TRUE(speculator.Take(guess, pattern, &outcome));
+  EXPECT_FALSE(speculator.active());
+
+  aletheia::GameSession next = session;
+  ASSERT_TRUE(next.ApplyFeedback(guess, pattern));
+  double entropy = 0.0;
+  EXPECT_EQ(outcome.result.guess, next.Suggest(&entropy));
+  EXPECT_EQ(outcome.result.entropy, entropy);
+  EXPECT_TRUE(outcome.result.exact);
+
+  // Other guesses, solving patterns and the long tail are not speculated.
+  speculator.Start(session, guess, 1);
+  speculator.Wait();
+  EXPECT_FALSE(speculator.Take(solver.words().text(0) == guess
+                                   ? std::string(solver.words().text(1))
+                                   : std::string(solver.words().text(0)),
+                               pattern, &outcome));
+  speculator.Start(session, guess, 1);
+  speculator.Wait();
+  EXPECT_FALSE(speculator.Take(guess, "22222", &outcome));
+  int smallest = -1;
+  for (int code = 0; code + 1 < aletheia::WordleSolver::kPatternCount;
+       ++code) {
+    if (counts[code] > 0 && counts[code] < counts[biggest]) {
+      smallest = code;
+    }
+  }
+  ASSERT_GE(smallest, 0);
+  speculator.Start(session, guess, 1);
+  speculator.Wait();
+  EXPECT_FALSE(speculator.Take(
+      guess, aletheia::WordleSolver::PatternString(smallest), &outcome));
+
+  // The worker searches with the token in its limits, so cancelling stops
+  // even a two-ply search part way.
+  solver.SetLookahead(8);
+  speculator.Start(session, guess, 8);
+  const auto cancelled_at = std::chrono::steady_clock::now();
+  speculator.Cancel();
+  EXPECT_LT(std::chrono::steady_clock::now() - cancelled_at,
+            std::chrono::milliseconds(250));
+  EXPECT_FALSE(speculator.active());
+  solver.SetLookahead(0);
+}
+
+TEST(WordleServer, JsonLinesSessionsMatchDirectCalls) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(400));
+  const aletheia::WordTable& words = solver.words();
+  aletheia::SolverServer::Options options;
+  options.workers = 3;
+  options.queue_depth = 1;
+  options.max_sessions = 8;
+  options.allow_fallback = true;
+  aletheia::SolverServer server(solver, options);
+
+  const std::string opening = solver.BestGuess(AllIndices(solver),
+                                               AllIndices(solver), nullptr);
+  EXPECT_EQ(server.Handle(R"({"id":1,"op":"new","session":"a"})"),
+            R"({"id":1,"ok":true,"session":"a","remaining":400})");
+  EXPECT_NE(server.Handle(R"({"op":"suggest","session":"a"})")
+                .find("\"guess\":\"" + opening + "\""),
+            std::string::npos);
+  EXPECT_EQ(server.Handle(R"({"op":"new","session":"a"})"),
+            R"({"ok":false,"error":"session exists"})");
+  EXPECT_EQ(server.Handle("{\"op\":"),
+            R"({"ok":false,"error":"malformed request"})");
+  EXPECT_EQ(server.Handle(R"({"id":"x","op":"suggest","session":"b"})"),
+            R"({"id":"x","ok":false,"error":"unknown session"})");
+
+  // Pipelined games on named sessions: every request is written before any
+  // answer is read, and one session's answers keep their order.
+  std::ostringstream requests;
+  std::vector<std::string> targets;
+  for (size_t game = 0; game < 4; ++game) {
+    const std::string name = "g" + std::to_string(game);
+    targets.emplace_back(words.text(game * 37));
+    requests << R"({"id":)" << game * 10 << R"(,"op":"new","session":")"
+             << name << "\"}\n";
+    requests << R"({"id":)" << game * 10 + 1
+             << R"(,"op":"feedback","session":")" << name << R"(","guess":")"
+             << opening << R"(","pattern":")"
+             << PatternFor(opening, targets.back()) << "\"}\n";
+    requests << R"({"id":)" << game * 10 + 2 << R"(,"op":"top","k":3,)"
+             << R"("session":")" << name << "\"}\n";
+  }
+  requests << R"({"id":99,"op":"connections","words":["a","b","c","d","e",)"
+           << R"("f","g","h","i","j","k","l","m","n","o","p"]})" << "\n";
+  std::istringstream in(requests.str());
+  std::ostringstream out;
+  server.Serve(in, out);
+
+  std::istringstream lines(out.str());
+  std::string line;
+  std::vector<std::vector<int>> order(4);
+  size_t answered = 0;
+  while (std::getline(lines, line)) {
+    ++answered;
+    EXPECT_NE(line.find("\"ok\":true"), std::string::npos) << line;
+    const int id = std::stoi(line.substr(line.find(':') + 1));
+    if (id == 99) {
+      EXPECT_NE(line.find("\"groups\":[["), std::string::npos);
+      continue;
+    }
+    order[id / 10].push_back(id % 10);
+    if (id % 10 == 1) {
+      std::vector<size_t> remaining;
+      solver.FilterCandidates(AllIndices(solver), opening,
+                              PatternFor(opening, targets[id / 10]),
+                              &remaining);
+      EXPECT_NE(line.find("\"remaining\":" + std::to_string(remaining.size())),
+                std::string::npos)
+          << line;
+    }
+  }
+  EXPECT_EQ(answered, 13u);
+  for (const auto& session_order : order) {
+    EXPECT_EQ(session_order, (std::vector<int>{0, 1, 2}));
+  }
+  EXPECT_EQ(server.sessions(), 5u);
+  EXPECT_EQ(server.Handle(R"({"op":"end","session":"a"})"), R"({"ok":true})");
+  EXPECT_EQ(server.sessions(), 4u);
+}
+
+#if defined(ALETHEIA_TEST_SOCKETS)
+TEST(WordleServer, SocketConnectionsEndAndStopDrains) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(200));
+  aletheia::SolverServer::Options options;
+  options.workers = 2;
+  aletheia::SolverServer server(solver, options);
+  const std::string path =
+      ::testing::TempDir() + "aletheia_" + std::to_string(::getpid()) + ".sock";
+  bool served = false;
+  std::thread serving([&] { served = server.ServeUnixSocket(path); });
+
+  auto connect_client = [&path] {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::snprintf(address.sun_path, sizeof(address.sun_path), "%s",
+                  path.c_str());
+    for (int attempt = 0; attempt < 500; ++attempt) {
+      const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+      if (::connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                    sizeof(address)) == 0) {
+        return fd;
+      }
+      ::close(fd);
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return -1;
+  };
+  auto read_all = [](int fd) {
+    std::string data;
+    char chunk[256];
+    ssize_t n;
+    while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+      data.append(chunk, static_cast<size_t>(n));
+    }
+    return data;
+  };
+  const std::string request = "{\"id\":1,\"op\":\"stats\"}\n";
+
+  // Clients that hang up get every answer, one after another.
+  for (int client = 0; client < 3; ++client) {
+    const int fd = connect_client();
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::write(fd, request.data(), request.size()),
+              static_cast<ssize_t>(request.size()));
+    ::shutdown(fd, SHUT_WR);
+    EXPECT_EQ(read_all(fd).find("{\"id\":1,\"ok\":true"), 0u);
+    ::close(fd);
+  }
+
+  // A client still connected at Stop keeps the answer it asked for, and
+  // its connection is then closed by the server.
+  const int open_fd = connect_client();
+  ASSERT_GE(open_fd, 0);
+  ASSERT_EQ(::write(open_fd, request.data(), request.size()),
+            static_cast<ssize_t>(request.size()));
+  std::string answer;
+  char byte;
+  while (::read(open_fd, &byte, 1) == 1 && byte != '\n') {
+    answer.push_back(byte);
+  }
+  EXPECT_EQ(answer.find("{\"id\":1,\"ok\":true"), 0u);
+  server.Stop();
+  serving.join();
+  EXPECT_TRUE(served);
+  EXPECT_EQ(read_all(open_fd), "");
+  ::close(open_fd);
+  EXPECT_NE(::access(path.c_str(), F_OK), 0);
+}
+
+TEST(WordleServer, SocketPathKeepsExistingFiles) {
+  aletheia::WordleSolver solver;
+  solver.SetWordList(SampleWords(50));
+  aletheia::SolverServer server(solver, aletheia::SolverServer::Options{});
+  const std::string path =
+      ::testing::TempDir() + "aletheia_" + std::to_string(::getpid()) + ".txt";
+  std::FILE* file = std::fopen(path.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  std::fputs("keep me\n", file);
+  std::fclose(file);
+
+  EXPECT_FALSE(server.ServeUnixSocket(path));
+  EXPECT_EQ(::access(path.c_str(), F_OK), 0);
+  std::remove(path.c_str());
+}
+#endif
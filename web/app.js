@@ -44,6 +44,8 @@ const SPEED_BASELINE_KEY = "speedBaseline";
 const LEXICAL_WEIGHT_KEY = "lexicalWeight";
 const ENVELOPE_SIGMA = 2.0;
 const THREAD_POOL_SIZE = 4;
+// Best-guess latency ceiling; a slower search shows its best guess so far.
+const BEST_GUESS_BUDGET_MS = 400;
 
 const sampleDict = [
   "raise",
@@ -818,21 +820,40 @@ document.getElementById("applyPatternBtn").addEventListener("click", () => {
   logLine(`Applied feedback: ${guess.toUpperCase()} ${pattern}, remaining ${remaining}.`);
 });
 
-document.getElementById("bestGuessBtn").addEventListener("click", () => {
+// The search runs off the page's thread; feedback entered meanwhile
+// cancels it and the poll comes back empty.
+async function awaitBestGuess() {
+  for (;;) {
+    const result = Module.wordleBestGuessPoll();
+    if (result !== "wait") return result;
+    await new Promise((resolve) => setTimeout(resolve, 5));
+  }
+}
+
+document.getElementById("bestGuessBtn").addEventListener("click", async () => {
   if (!Module) return;
   if (bestGuessBtn) bestGuessBtn.disabled = true;
   const hardMode = Boolean(wordleHardEl.checked);
-  const result = Module.wordleBestGuess(hardMode);
-  if (!result) {
+  if (!Module.wordleBestGuessStart(hardMode, BEST_GUESS_BUDGET_MS)) {
     bestGuessOut.textContent = "Load a dictionary first.";
     clearEntropySpark();
     if (bestGuessBtn) bestGuessBtn.disabled = false;
     return;
   }
-  const [guess, entropy] = result.split("|");
+  const result = await awaitBestGuess();
+  if (!result) {
+    bestGuessOut.textContent = "Best guess superseded by new feedback.";
+    clearEntropySpark();
+    if (bestGuessBtn) bestGuessBtn.disabled = false;
+    return;
+  }
+  const [guess, entropy, pruned, candidates, exact] = result.split("|");
   bestGuessOut.textContent = `Best guess: ${guess} (entropy ${Number(
     entropy
-  ).toFixed(4)})`;
+  ).toFixed(4)}${exact === "1" ? "" : ", best so far"})`;
+  if (Number(candidates) > 0) {
+    bestGuessOut.textContent += `, pruned ${pruned}/${candidates}`;
+  }
   const remaining = Module.wordleRemainingCount();
   logLine(
     `Best guess (${hardMode ? "hard" : "normal"}): ${guess.toUpperCase()}, entropy ${Number(
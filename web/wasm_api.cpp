@@ -17,8 +17,16 @@
 namespace {
 aletheia::WordleSolver g_wordle;
 bool g_loaded = false;
-std::vector<size_t> g_remaining;
+// The page's game. Hard mode is chosen per query, so the session switches
+// mode on demand and keeps its pool in step with the hints.
+aletheia::GameSession g_session(g_wordle);
+// Background best guess for the page's game. Anything that changes the
+// game or the solver replaces it, which cancels the search and waits the
+// (sub-millisecond) time it takes to stop.
+aletheia::GuessFuture g_pending;
+std::vector<std::vector<size_t>> g_multi_boards;
 constexpr int kPatternCount = 243;
+constexpr size_t kGuessCacheEntries = 4096;
 
 std::string ToLowerAscii(std::string input) {
   for (char& c : input) {
@@ -39,20 +47,6 @@ std::vector<std::string> SplitWordsText(const std::string& text) {
   return words;
 }
 
-Eigen::VectorXd FallbackEmbedding(const std::string& word, int dims) {
-  Eigen::VectorXd vec(dims);
-  uint64_t hash = 1469598103934665603ULL;
-  for (char c : word) {
-    hash ^= static_cast<uint64_t>(c);
-    hash *= 1099511628211ULL;
-  }
-  for (int i = 0; i < dims; ++i) {
-    double value = static_cast<double>((hash >> (i * 3)) & 0xFFFF);
-    vec[i] = std::sin(value * 0.001 + static_cast<double>(i));
-  }
-  return vec;
-}
-
 std::string JsonEscape(const std::string& input) {
   std::string out;
   out.reserve(input.size());
@@ -78,19 +72,11 @@ bool IsPatternValid(const std::string& pattern) {
 }
 
 double EntropyForGuessIndex(size_t guess_index,
-                            const std::vector<size_t>& targets) {
+                            const aletheia::WordTable& targets) {
   if (targets.empty()) {
     return 0.0;
   }
-  std::array<int, kPatternCount> counts{};
-  counts.fill(0);
-  const auto& words = g_wordle.words();
-  const aletheia::PackedWord& guess = words[guess_index].packed;
-  for (size_t target_index : targets) {
-    const aletheia::PackedWord& target = words[target_index].packed;
-    int pattern = aletheia::WordleSolver::Pattern(guess, target);
-    counts[pattern]++;
-  }
+  const auto counts = g_wordle.PatternCounts(guess_index, targets);
   double entropy = 0.0;
   const double inv_total = 1.0 / static_cast<double>(targets.size());
   for (int count : counts) {
@@ -126,12 +112,9 @@ PcaResult ComputePcaProjection(const std::vector<Eigen::VectorXd>& embeddings,
   }
 
   Eigen::MatrixXd X(n, feature_dims);
-#ifdef _OPENMP
-#pragma omp parallel for schedule(static)
-#endif
-  for (int i = 0; i < n; ++i) {
-    X.row(i) = embeddings[i].transpose();
-  }
+  aletheia::ThreadPool::Instance().ParallelFor(
+      0, static_cast<size_t>(n), 64,
+      [&](size_t i) { X.row(i) = embeddings[i].transpose(); });
 
   Eigen::VectorXd mean = X.colwise().mean();
   Eigen::MatrixXd centered = X.rowwise() - mean.transpose();
@@ -178,74 +161,227 @@ PcaResult ComputePcaProjection(const std::vector<Eigen::VectorXd>& embeddings,
 void WordleReset();
 
 void LoadWordleDict(const std::string& dict_text) {
+  g_pending = aletheia::GuessFuture();
   std::vector<std::string> words = SplitWordsText(dict_text);
+  g_wordle.EnableGuessCache(kGuessCacheEntries);
   g_wordle.SetWordList(words);
+  g_multi_boards.clear();
   g_loaded = !g_wordle.words().empty();
   WordleReset();
 }
 
 void WordleReset() {
-  g_remaining.clear();
-  if (g_loaded) {
-    g_remaining.resize(g_wordle.words().size());
-    std::iota(g_remaining.begin(), g_remaining.end(), 0);
+  g_pending = aletheia::GuessFuture();
+  g_session.Reset();
+}
+
+bool LoadWordleBook(const std::string& data) {
+  if (!g_loaded) {
+    return false;
+  }
+  g_pending = aletheia::GuessFuture();
+  std::istringstream in(data);
+  aletheia::DecisionTree tree;
+  if (!tree.Read(in) || !g_wordle.SetDecisionTree(std::move(tree))) {
+    return false;
   }
+  WordleReset();
+  return true;
 }
 
 int WordleRemainingCount() {
-  return static_cast<int>(g_remaining.size());
+  return static_cast<int>(g_session.remaining().size());
 }
 
 bool WordleIsCandidate(const std::string& guess) {
   if (!g_loaded) {
     return false;
   }
-  std::string g = aletheia::WordleSolver::NormalizeWord(guess);
-  if (!aletheia::WordleSolver::IsValidWord(g)) {
-    return false;
+  return g_session.IsCandidate(aletheia::WordleSolver::NormalizeWord(guess));
+}
+
+int WordleApplyFeedback(const std::string& guess, const std::string& pattern) {
+  // Feedback no remaining word fits is rejected like malformed input and
+  // leaves the game as it was. A suggestion still running is for the old
+  // position.
+  g_pending = aletheia::GuessFuture();
+  if (!g_loaded || !g_session.ApplyFeedback(guess, pattern)) {
+    return -1;
   }
-  for (size_t idx : g_remaining) {
-    if (g_wordle.words()[idx].text == g) {
-      return true;
-    }
+  return static_cast<int>(g_session.remaining().size());
+}
+
+int WordleMultiReset(int boards) {
+  g_multi_boards.clear();
+  if (!g_loaded || boards < 1 ||
+      static_cast<size_t>(boards) > aletheia::WordleSolver::kMaxBoards) {
+    return -1;
   }
-  return false;
+  std::vector<size_t> all_indices(g_wordle.words().size());
+  std::iota(all_indices.begin(), all_indices.end(), 0);
+  g_multi_boards.assign(static_cast<size_t>(boards), all_indices);
+  return boards;
 }
 
-int WordleApplyFeedback(const std::string& guess, const std::string& pattern) {
-  if (!g_loaded || g_remaining.empty()) {
+int WordleMultiApplyFeedback(int board,
+                             const std::string& guess,
+                             const std::string& pattern) {
+  if (board < 0 || static_cast<size_t>(board) >= g_multi_boards.size()) {
     return -1;
   }
   std::string g = aletheia::WordleSolver::NormalizeWord(guess);
-  if (!aletheia::WordleSolver::IsValidWord(g) ||
-      !IsPatternValid(pattern)) {
+  if (!aletheia::WordleSolver::IsValidWord(g) || !IsPatternValid(pattern)) {
     return -1;
   }
+  std::vector<size_t>& remaining = g_multi_boards[static_cast<size_t>(board)];
+  if (pattern == "22222") {
+    // Solved boards stop contributing to later guesses.
+    remaining.clear();
+    return 0;
+  }
   std::vector<size_t> next;
-  next.reserve(g_remaining.size());
-  aletheia::WordleSolver::FilterCandidates(
-      g_wordle.words(), g_remaining, g, pattern, &next);
-  g_remaining.swap(next);
-  return static_cast<int>(g_remaining.size());
+  g_wordle.FilterCandidates(remaining, g, pattern, &next);
+  remaining = std::move(next);
+  return static_cast<int>(remaining.size());
 }
 
-std::string WordleBestGuess(bool hard_mode) {
-  if (!g_loaded) {
+std::string WordleMultiBestGuess() {
+  if (!g_loaded || g_multi_boards.empty()) {
     return "";
   }
   std::vector<size_t> all_indices(g_wordle.words().size());
   std::iota(all_indices.begin(), all_indices.end(), 0);
-  const std::vector<size_t>& targets =
-      g_remaining.empty() ? all_indices : g_remaining;
-  const std::vector<size_t>& candidates =
-      hard_mode ? targets : all_indices;
+  for (const auto& board : g_multi_boards) {
+    if (board.size() == 1) {
+      all_indices.assign(1, board[0]);
+      break;
+    }
+  }
   double entropy = 0.0;
-  std::string guess = g_wordle.BestGuess(candidates, targets, &entropy);
+  std::string guess =
+      g_wordle.BestMultiGuess(all_indices, g_multi_boards, &entropy);
   std::ostringstream out;
   out << guess << "|" << entropy;
   return out.str();
 }
 
+std::string WordleBestGuess(bool hard_mode) {
+  if (!g_loaded) {
+    return "";
+  }
+  g_session.SetHardMode(hard_mode);
+  double entropy = 0.0;
+  aletheia::WordleSolver::SearchStats stats;
+  const std::string guess = g_session.Suggest(&entropy, &stats);
+  std::ostringstream out;
+  out << guess << "|" << entropy << "|" << stats.pruned << "|"
+      << stats.candidates;
+  return out.str();
+}
+
+// WordleBestGuess under a time budget: "guess|entropy|pruned|candidates|exact",
+// where exact is 0 when the budget cut the search short. With lookahead set
+// the budget covers both plies.
+std::string WordleBestGuessWithin(bool hard_mode, int budget_ms) {
+  if (!g_loaded) {
+    return "";
+  }
+  g_session.SetHardMode(hard_mode);
+  double entropy = 0.0;
+  bool exact = true;
+  aletheia::WordleSolver::SearchStats stats;
+  const std::string guess = g_session.SuggestWithin(
+      std::chrono::milliseconds(budget_ms > 0 ? budget_ms : 0), &entropy,
+      &exact, &stats);
+  std::ostringstream out;
+  out << guess << "|" << entropy << "|" << stats.pruned << "|"
+      << stats.candidates << "|" << (exact ? 1 : 0);
+  return out.str();
+}
+
+// Starts WordleBestGuessWithin without blocking the caller; poll for the
+// answer with WordleBestGuessPoll. Builds without threads answer here.
+bool WordleBestGuessStart(bool hard_mode, int budget_ms) {
+  g_pending = aletheia::GuessFuture();
+  if (!g_loaded) {
+    return false;
+  }
+  g_session.SetHardMode(hard_mode);
+  g_pending = g_session.SuggestAsync(
+      std::chrono::milliseconds(budget_ms > 0 ? budget_ms : 0));
+  return true;
+}
+
+// "wait" while the started search runs, then its answer in the
+// WordleBestGuessWithin format once; "" when none is pending (never
+// started, or superseded by a change to the game).
+std::string WordleBestGuessPoll() {
+  if (!g_pending.valid()) {
+    return "";
+  }
+  if (!g_pending.ready()) {
+    return "wait";
+  }
+  const aletheia::GuessFuture::Result result = g_pending.Get();
+  g_pending = aletheia::GuessFuture();
+  std::ostringstream out;
+  out << result.guess << "|" << result.entropy << "|" << result.stats.pruned
+      << "|" << result.stats.candidates << "|" << (result.exact ? 1 : 0);
+  return out.str();
+}
+
+void WordleBestGuessCancel() { g_pending = aletheia::GuessFuture(); }
+
+// Stateless query: `history` is whitespace-separated guess:pattern hints,
+// e.g. "crane:00120 spilt:20001". The hints are compiled and matched in one
+// pass over the dictionary, so the session state is left untouched.
+// Returns "guess|entropy|remaining", or "" for malformed history.
+std::string WordleHintsBestGuess(const std::string& history, bool hard_mode) {
+  if (!g_loaded) {
+    return "";
+  }
+  aletheia::HintConstraints hints;
+  for (const std::string& token : SplitWordsText(history)) {
+    const size_t colon = token.find(':');
+    if (colon == std::string::npos ||
+        !hints.Add(std::string_view(token).substr(0, colon),
+                   std::string_view(token).substr(colon + 1))) {
+      return "";
+    }
+  }
+  std::vector<size_t> remaining;
+  g_wordle.FilterCandidates(hints, &remaining);
+  std::vector<size_t> candidates;
+  if (hard_mode) {
+    aletheia::CandidateSet pool;
+    g_wordle.RestrictHardModePool(hints, &pool);
+    pool.ToIndices(&candidates);
+  }
+  double entropy = 0.0;
+  std::string guess;
+  if (!remaining.empty()) {
+    guess = g_wordle.BestGuess(hard_mode ? candidates : g_wordle.all_indices(),
+                               remaining, &entropy, nullptr, hard_mode);
+  }
+  std::ostringstream out;
+  out << guess << "|" << entropy << "|" << remaining.size();
+  return out.str();
+}
+
+std::string WordleGuessCacheStats() {
+  aletheia::GuessCache::Stats stats = g_wordle.GuessCacheStats();
+  std::ostringstream out;
+  out << "{\"hits\":" << stats.hits << ",\"misses\":" << stats.misses
+      << ",\"evictions\":" << stats.evictions << ",\"size\":" << stats.size
+      << "}";
+  return out.str();
+}
+
+void WordleSetLookahead(int beam) {
+  g_pending = aletheia::GuessFuture();
+  g_wordle.SetLookahead(beam > 1 ? static_cast<size_t>(beam) : 0);
+}
+
 std::string WordleTopGuesses(int limit, bool hard_mode) {
   if (!g_loaded) {
     return "";
@@ -253,47 +389,10 @@ std::string WordleTopGuesses(int limit, bool hard_mode) {
   if (limit <= 0) {
     limit = 5;
   }
-  std::vector<size_t> all_indices(g_wordle.words().size());
-  std::iota(all_indices.begin(), all_indices.end(), 0);
-  const std::vector<size_t>& targets =
-      g_remaining.empty() ? all_indices : g_remaining;
-  const std::vector<size_t>& candidates =
-      hard_mode ? targets : all_indices;
-
-  auto sample_indices = [](const std::vector<size_t>& input, size_t max_count) {
-    if (input.size() <= max_count) {
-      return input;
-    }
-    std::vector<size_t> sampled;
-    sampled.reserve(max_count);
-    size_t step = (input.size() + max_count - 1) / max_count;
-    for (size_t i = 0; i < input.size() && sampled.size() < max_count; i += step) {
-      sampled.push_back(input[i]);
-    }
-    return sampled;
-  };
-
-  const size_t max_candidates = 300;
-  const size_t max_targets = 300;
-  std::vector<size_t> sampled_candidates = sample_indices(candidates, max_candidates);
-  std::vector<size_t> sampled_targets = sample_indices(targets, max_targets);
-
-  struct ScoredGuess {
-    size_t index = 0;
-    double entropy = 0.0;
-  };
-  std::vector<ScoredGuess> scored;
-  scored.reserve(sampled_candidates.size());
-  for (size_t guess_index : sampled_candidates) {
-    scored.push_back(
-        {guess_index, EntropyForGuessIndex(guess_index, sampled_targets)});
-  }
-  size_t take = std::min<size_t>(static_cast<size_t>(limit), scored.size());
-  std::partial_sort(
-      scored.begin(), scored.begin() + take, scored.end(),
-      [](const ScoredGuess& a, const ScoredGuess& b) {
-        return a.entropy > b.entropy;
-      });
+  g_session.SetHardMode(hard_mode);
+  const std::vector<aletheia::WordleSolver::ScoredGuess> scored =
+      g_session.TopGuesses(static_cast<size_t>(limit));
+  const size_t take = scored.size();
 
   std::ostringstream out;
   out << "{\"items\":[";
@@ -326,33 +425,37 @@ std::string WordleAdversarialStress(int games, bool hard_mode) {
 
   for (int game = 0; game < games; ++game) {
     std::vector<size_t> remaining = all_indices;
+    // Hard mode guesses from the NYT pool: any word that honours the
+    // revealed hints, not just the remaining targets.
+    aletheia::HintConstraints hints;
+    aletheia::CandidateSet pool;
+    std::vector<size_t> hard_candidates;
     for (int step = 0; step < 6; ++step) {
       const std::vector<size_t>& targets =
           remaining.empty() ? all_indices : remaining;
+      auto start = std::chrono::high_resolution_clock::now();
+      if (hard_mode) {
+        g_wordle.RestrictHardModePool(hints, &pool);
+        pool.ToIndices(&hard_candidates);
+      }
       const std::vector<size_t>& candidates =
-          hard_mode ? targets : all_indices;
+          hard_mode ? hard_candidates : all_indices;
       if (targets.empty() || candidates.empty()) {
         break;
       }
-      auto start = std::chrono::high_resolution_clock::now();
+      aletheia::WordTable packed_targets;
+      packed_targets.Assign(words, targets);
       size_t best_index = candidates[0];
       double best_entropy = -std::numeric_limits<double>::infinity();
       for (size_t guess_index : candidates) {
-        double entropy = EntropyForGuessIndex(guess_index, targets);
+        double entropy = EntropyForGuessIndex(guess_index, packed_targets);
         if (entropy > best_entropy) {
           best_entropy = entropy;
           best_index = guess_index;
         }
       }
 
-      std::array<int, kPatternCount> counts{};
-      counts.fill(0);
-      const aletheia::PackedWord& guess = words[best_index].packed;
-      for (size_t target_index : targets) {
-        const aletheia::PackedWord& target = words[target_index].packed;
-        int pattern = aletheia::WordleSolver::Pattern(guess, target);
-        counts[pattern]++;
-      }
+      const auto counts = g_wordle.PatternCounts(best_index, targets);
       int worst_pattern = 0;
       int worst_count = -1;
       for (int i = 0; i < kPatternCount; ++i) {
@@ -379,6 +482,7 @@ std::string WordleAdversarialStress(int games, bool hard_mode) {
         worst_ms = elapsed;
       }
       remaining.swap(next);
+      hints.Add(words[best_index].text, pattern_str);
       if (pattern_str == "22222" || remaining.size() <= 1) {
         break;
       }
@@ -415,15 +519,12 @@ std::string WordlePatternHistogram(const std::string& guess) {
     return "{\"error\":\"Invalid guess\"}";
   }
   auto g_pack = aletheia::WordleSolver::EncodeWord(g);
-  std::vector<size_t> all_indices(g_wordle.words().size());
-  std::iota(all_indices.begin(), all_indices.end(), 0);
-  const std::vector<size_t>& targets =
-      g_remaining.empty() ? all_indices : g_remaining;
+  const std::vector<size_t>& targets = g_session.remaining();
   std::array<int, kPatternCount> counts{};
   counts.fill(0);
   const auto& words = g_wordle.words();
   for (size_t target_index : targets) {
-    const aletheia::PackedWord& target = words[target_index].packed;
+    const aletheia::PackedWord target = words.packed(target_index);
     int pattern = aletheia::WordleSolver::Pattern(g_pack, target);
     counts[pattern]++;
   }
@@ -465,16 +566,24 @@ std::string WordleSpeedTest(int count, bool hard_mode) {
   int total_guesses = 0;
   for (int game = 0; game < count; ++game) {
     const size_t target_index = dist(rng);
-    const aletheia::PackedWord target = words[target_index].packed;
+    const aletheia::PackedWord target = words.packed(target_index);
     std::vector<size_t> remaining = all_indices;
+    aletheia::HintConstraints hints;
+    aletheia::CandidateSet pool;
+    std::vector<size_t> hard_candidates;
     bool solved = false;
     int guesses = 0;
     auto start = std::chrono::high_resolution_clock::now();
     for (int step = 0; step < 6; ++step) {
+      if (hard_mode) {
+        g_wordle.RestrictHardModePool(hints, &pool);
+        pool.ToIndices(&hard_candidates);
+      }
       const std::vector<size_t>& candidates =
-          hard_mode ? remaining : all_indices;
+          hard_mode ? hard_candidates : all_indices;
       double entropy = 0.0;
-      std::string guess = g_wordle.BestGuess(candidates, remaining, &entropy);
+      std::string guess = g_wordle.BestGuess(candidates, remaining, &entropy,
+                                             nullptr, hard_mode);
       if (guess.empty()) {
         break;
       }
@@ -493,6 +602,7 @@ std::string WordleSpeedTest(int count, bool hard_mode) {
       aletheia::WordleSolver::FilterCandidates(
           words, remaining, guess, pattern_str, &next);
       remaining.swap(next);
+      hints.Add(guess, pattern_str);
     }
     auto end = std::chrono::high_resolution_clock::now();
     double elapsed_ms =
@@ -559,7 +669,7 @@ std::string ConnectionsSolveWeightedDetailed(const std::string& words_text,
   vectors.reserve(words.size());
   const int dims = 24;
   for (const auto& word : words) {
-    vectors.push_back(FallbackEmbedding(word, dims));
+    vectors.push_back(aletheia::FallbackEmbedding(word, dims));
   }
 
   aletheia::SimilarityEngine similarity;
@@ -777,11 +887,22 @@ std::string ConnectionsSolveWeightedDetailed(const std::string& words_text,
 EMSCRIPTEN_BINDINGS(aletheia_wasm) {
   emscripten::function("loadWordleDict", &LoadWordleDict);
   emscripten::function("wordleReset", &WordleReset);
+  emscripten::function("loadWordleBook", &LoadWordleBook);
   emscripten::function("wordleRemainingCount", &WordleRemainingCount);
   emscripten::function("wordleIsCandidate", &WordleIsCandidate);
   emscripten::function("wordleApplyFeedback", &WordleApplyFeedback);
   emscripten::function("wordleBestGuess", &WordleBestGuess);
+  emscripten::function("wordleBestGuessWithin", &WordleBestGuessWithin);
+  emscripten::function("wordleBestGuessStart", &WordleBestGuessStart);
+  emscripten::function("wordleBestGuessPoll", &WordleBestGuessPoll);
+  emscripten::function("wordleBestGuessCancel", &WordleBestGuessCancel);
+  emscripten::function("wordleHintsBestGuess", &WordleHintsBestGuess);
+  emscripten::function("wordleMultiReset", &WordleMultiReset);
+  emscripten::function("wordleMultiApplyFeedback", &WordleMultiApplyFeedback);
+  emscripten::function("wordleMultiBestGuess", &WordleMultiBestGuess);
   emscripten::function("wordleTopGuesses", &WordleTopGuesses);
+  emscripten::function("wordleSetLookahead", &WordleSetLookahead);
+  emscripten::function("wordleGuessCacheStats", &WordleGuessCacheStats);
   emscripten::function("wordleAdversarialStress", &WordleAdversarialStress);
   emscripten::function("wordlePattern", &WordlePattern);
   emscripten::function("wordlePatternHistogram", &WordlePatternHistogram);